@@ -0,0 +1,249 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <numeric>
+#include "matrice3d.h"
+
+/**
+    @brief Benchmark delle operazioni della Matrice3D
+
+    Per ogni tipo di elemento e per dimensioni crescenti (da qualche KB, residenti in L1,
+    fino a --max-mb) misura le operazioni principali della classe e stampa un report CSV:
+
+        op,type,bytes,z,y,x,reps,ns_per_elem,gb_per_s
+
+    bytes e' la dimensione della matrice, gb_per_s la banda stimata (byte letti e scritti
+    dall'operazione diviso il tempo). Le righe che iniziano con # sono commenti.
+
+    Uso: bench.exe [--max-mb N] [--min-time secondi] [--out file.csv]
+
+*/
+
+/// Accumulatore globale: impedisce al compilatore di eliminare i cicli misurati
+static volatile double sink = 0;
+
+/**
+    @brief Funtore di trasform usato nel benchmark
+*/
+template <class T> struct addOne {
+    T operator()(T v) const { return v + T(1); }
+};
+
+/// Opzioni da riga di comando
+struct benchOptions {
+    std::size_t maxBytes; ///< dimensione massima di una matrice
+    double minTime; ///< tempo minimo di ogni misura (secondi)
+    std::ostream *out; ///< destinazione del report
+};
+
+/**
+    Esegue f ripetutamente finche' non passa almeno minTime e ritorna i secondi per
+    ripetizione e, in reps, il numero di ripetizioni.
+*/
+template <class F>
+double measure(F f, double minTime, unsigned int &reps) {
+    typedef std::chrono::steady_clock clock;
+    f(); // riscaldamento (pagine, cache, dispatch SIMD)
+    reps = 0;
+    clock::time_point start = clock::now();
+    double elapsed = 0;
+    do {
+        f();
+        reps++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < minTime);
+    return elapsed / reps;
+}
+
+/**
+    Stampa una riga del report
+
+    @param moved byte letti e scritti da una ripetizione
+*/
+void report(const benchOptions &o, const char *op, const char *type, std::size_t bytes,
+            unsigned int z, unsigned int y, unsigned int x, std::size_t elements,
+            std::size_t moved, unsigned int reps, double seconds) {
+    *o.out << op << ',' << type << ',' << bytes << ',' << z << ',' << y << ',' << x << ','
+           << reps << ',' << seconds * 1e9 / elements << ',' << moved / seconds / 1e9 << '\n';
+    o.out->flush();
+}
+
+/**
+    Esegue tutte le misure per il tipo T e una matrice di circa bytes byte
+*/
+template <class T, class U>
+void bench_size(const benchOptions &o, const char *type, std::size_t bytes) {
+    std::size_t n = bytes / sizeof(T);
+    // Dimensioni il piu' possibile cubiche, con x al massimo 256
+    unsigned int x = n < 256 ? (unsigned int)n : 256;
+    unsigned int y = n / x < 256 ? (unsigned int)(n / x) : 256;
+    unsigned int z = (unsigned int)(n / (std::size_t(x) * y));
+    n = std::size_t(z) * y * x;
+    bytes = n * sizeof(T);
+    unsigned int reps = 0;
+    double t;
+    // Accumulatore delle somme (senza overflow con segno per gli interi)
+    typedef typename std::conditional<std::is_integral<T>::value, std::uint64_t, T>::type acc;
+
+    Matrice3D<T> m(z, y, x);
+    for (std::size_t i = 0; i < n; i++)
+        m.data()[i] = T(i % 251);
+
+    t = measure([&] { Matrice3D<T> c(z, y, x); sink = sink + (double)c.size(); }, o.minTime, reps);
+    report(o, "construct", type, bytes, z, y, x, n, bytes, reps, t);
+
+    t = measure([&] { Matrice3D<T> c(m); sink = sink + (double)c.data()[n - 1]; }, o.minTime, reps);
+    report(o, "copy", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    t = measure([&] { Matrice3D<U> c(m); sink = sink + (double)c.data()[n - 1]; }, o.minTime, reps);
+    report(o, "convert", type, bytes, z, y, x, n, n * (sizeof(T) + sizeof(U)), reps, t);
+
+    t = measure([&] {
+        acc s = 0;
+        for (unsigned int i = 0; i < z; i++)
+            for (unsigned int j = 0; j < y; j++)
+                for (unsigned int k = 0; k < x; k++)
+                    s += m(i, j, k);
+        sink = sink + (double)s;
+    }, o.minTime, reps);
+    report(o, "access_seq", type, bytes, z, y, x, n, bytes, reps, t);
+
+    t = measure([&] {
+        acc s = 0;
+        // Generatore lineare congruenziale: coordinate pseudo-casuali senza tabelle
+        std::uint64_t r = 88172645463325252ULL;
+        for (std::size_t i = 0; i < n; i++) {
+            r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::uint64_t v = r >> 16;
+            s += m.at_unchecked((int)(v % z), (int)((v >> 16) % y), (int)((v >> 32) % x));
+        }
+        sink = sink + (double)s;
+    }, o.minTime, reps);
+    report(o, "access_rand", type, bytes, z, y, x, n, bytes, reps, t);
+
+    t = measure([&] {
+        acc s = 0;
+        for (typename Matrice3D<T>::const_iterator i = m.begin(), ie = m.end(); i != ie; ++i)
+            s += *i;
+        sink = sink + (double)s;
+    }, o.minTime, reps);
+    report(o, "iterate", type, bytes, z, y, x, n, bytes, reps, t);
+
+    // Pilastri lungo z con gli iteratori con passo (da confrontare con "access_seq")
+    t = measure([&] {
+        acc s = 0;
+        const Matrice3D<T> &cm = m;
+        for (unsigned int j = 0; j < y; j++)
+            for (unsigned int k = 0; k < x; k++) {
+                typename Matrice3D<T>::const_axis_range p = cm.pillar(j, k);
+                s = std::accumulate(p.begin(), p.end(), s);
+            }
+        sink = sink + (double)s;
+    }, o.minTime, reps);
+    report(o, "pillars", type, bytes, z, y, x, n, bytes, reps, t);
+
+    // Meta' centrale di ogni asse
+    unsigned int sz = z / 2 > 0 ? z / 2 : 1, sy = y / 2 > 0 ? y / 2 : 1, sx = x / 2 > 0 ? x / 2 : 1;
+    std::size_t sn = std::size_t(sz) * sy * sx;
+    t = measure([&] {
+        Matrice3D<T> c = m.slice(z / 4, z / 4 + sz - 1, y / 4, y / 4 + sy - 1, x / 4, x / 4 + sx - 1);
+        sink = sink + (double)c.size();
+    }, o.minTime, reps);
+    report(o, "slice", type, bytes, z, y, x, sn, 2 * sn * sizeof(T), reps, t);
+
+    Matrice3D<T> c(m);
+    t = measure([&] { sink = sink + (m == c); }, o.minTime, reps);
+    report(o, "equal", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    t = measure([&] { sink = sink + (double)(m.hash() & 1); }, o.minTime, reps);
+    report(o, "hash", type, bytes, z, y, x, n, bytes, reps, t);
+
+    t = measure([&] { m.fill(c.data(), c.data() + n); sink = sink + (double)m.data()[0]; }, o.minTime, reps);
+    report(o, "fill", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    t = measure([&] { Matrice3D<T> r = trasform<T>(m, addOne<T>()); sink = sink + (double)r.data()[n - 1]; }, o.minTime, reps);
+    report(o, "trasform", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    // Varianti senza allocazioni: in place e a due ingressi con la matrice di uscita riusata
+    Matrice3D<T> w(m);
+    t = measure([&] { trasform_inplace(w, addOne<T>()); sink = sink + (double)w.data()[n - 1]; }, o.minTime, reps);
+    report(o, "trasform_inplace", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    t = measure([&] {
+        trasform(m, c, [](T a, T b) { return T(a + b); }, w);
+        sink = sink + (double)w.data()[n - 1];
+    }, o.minTime, reps);
+    report(o, "trasform_zip", type, bytes, z, y, x, n, 3 * bytes, reps, t);
+
+    Matrice3DKernel<T> lap = Matrice3DKernel<T>::laplacian();
+    t = measure([&] { Matrice3D<T> r = convolve(m, lap); sink = sink + (double)r.data()[n - 1]; }, o.minTime, reps);
+    report(o, "convolve", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    t = measure([&] { Matrice3D<T> r = transpose(m); sink = sink + (double)r.data()[n - 1]; }, o.minTime, reps);
+    report(o, "transpose", type, bytes, z, y, x, n, 2 * bytes, reps, t);
+
+    // Matrice compressa: codifica dalla densa e scansione con gli iteratori (da
+    // confrontare con "iterate"); m ha pochi valori distinti e si comprime bene
+    t = measure([&] { Matrice3DCompressed<T> cm(m); sink = sink + (double)cm.compressed_bytes(); }, o.minTime, reps);
+    report(o, "compress", type, bytes, z, y, x, n, bytes, reps, t);
+
+    const Matrice3DCompressed<T> cm(m);
+    t = measure([&] {
+        acc s = 0;
+        for (typename Matrice3DCompressed<T>::const_iterator i = cm.begin(), ie = cm.end(); i != ie; ++i)
+            s += *i;
+        sink = sink + (double)s;
+    }, o.minTime, reps);
+    report(o, "compressed_iterate", type, bytes, z, y, x, n, bytes, reps, t);
+
+    // Piramide con la media: copia del livello 0 piu' riduzioni (lette circa 8/7 di m)
+    t = measure([&] {
+        Matrice3DPyramid<T> p(m);
+        sink = sink + (double)p.level(p.levels() - 1)(0, 0, 0);
+    }, o.minTime, reps);
+    report(o, "pyramid", type, bytes, z, y, x, n, 2 * bytes + bytes * 9 / 7, reps, t);
+}
+
+/**
+    Esegue le misure per il tipo T su tutte le dimensioni (x4 a ogni passo)
+*/
+template <class T, class U>
+void bench_type(const benchOptions &o, const char *type) {
+    // Servono circa 3 matrici contemporaneamente (m, la sua copia e il risultato)
+    for (std::size_t bytes = 16 << 10; bytes <= o.maxBytes; bytes *= 4)
+        bench_size<T, U>(o, type, bytes);
+}
+
+int main(int argc, char **argv) {
+    benchOptions o;
+    o.maxBytes = std::size_t(256) << 20;
+    o.minTime = 0.2;
+    o.out = &std::cout;
+    std::ofstream file;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--max-mb") == 0 && i + 1 < argc)
+            o.maxBytes = std::size_t(std::atol(argv[++i])) << 20;
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            o.minTime = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            file.open(argv[++i]);
+            o.out = &file;
+        }
+        else {
+            std::cerr << "Uso: " << argv[0] << " [--max-mb N] [--min-time secondi] [--out file.csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    *o.out << "# Matrice3D benchmark, simd=" << Matrice3DSimd::name(Matrice3DSimd::level()) << ", max_bytes=" << o.maxBytes << '\n';
+    *o.out << "op,type,bytes,z,y,x,reps,ns_per_elem,gb_per_s\n";
+    bench_type<float, double>(o, "float");
+    bench_type<double, float>(o, "double");
+    bench_type<int, float>(o, "int32");
+    bench_type<unsigned char, float>(o, "uint8");
+    return 0;
+}
@@ -1,8 +1,58 @@
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <fstream>
+#include <cstdio>
+#include <new>
+#include <atomic>
+#include <thread>
+// Strumentazione attiva nei test (vedi test_statistiche)
+#define MATRICE3D_STATS
 #include "matrice3d.h"
 
+/**
+    Contatore delle allocazioni dinamiche effettuate dal programma.
+    Gli operatori new/delete globali sono ridefiniti per incrementarlo,
+    in modo da poter verificare quante allocazioni esegue un'operazione.
+    E' atomico perche' anche i thread del pool allocano.
+*/
+static std::atomic<unsigned int> allocazioni(0);
+
+void* operator new(std::size_t n) {
+    allocazioni++;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    allocazioni++;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t n, std::align_val_t al) {
+    allocazioni++;
+    std::size_t a = static_cast<std::size_t>(al);
+    // aligned_alloc richiede una dimensione multipla dell'allineamento
+    if (void *p = std::aligned_alloc(a, n ? (n + a - 1) / a * a : a))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
 /**
     @brief Funtore di addizione tra tipi double
 
@@ -167,6 +217,11 @@ void test_fill() {
 
     assert(m1(0,0,0) == 1); // Assert per il primo valore
     assert(m1(0,1,2) == 6); // Assert per l'ultimo valore
+
+    // Sequenza piu' corta della matrice: gli elementi successivi restano invariati
+    std::list<int> l = {7, 8};
+    m1.fill(l.begin(), l.end());
+    assert(m1(0,0,0) == 7 && m1(0,0,1) == 8 && m1(0,0,2) == 3 && m1(0,1,2) == 6);
 }
 
 /**
@@ -199,6 +254,53 @@ void test_operator_function() {
 
 }
 
+/**
+    @brief Test delle politiche di accesso (checkedAccess, debugAccess, uncheckedAccess)
+           e dell'accesso diretto al buffer con at_unchecked e data()
+
+*/
+void test_accesso() {
+
+    std::cout<<"******** Test delle politiche di accesso della Matrice3D ********"<<std::endl;
+
+    int a[24]; // Dati per riempire la matrice
+    for (int i = 0; i < 24; i++)
+        a[i] = i;
+
+    Matrice3D<int, defaultCmp, uncheckedAccess> m1(2,3,4);
+    m1.fill(a,a+24);
+    assert(m1.strideY() == 4 && m1.strideZ() == 12);
+
+    // operator(), at_unchecked e data() indirizzano lo stesso elemento
+    assert(m1(1,2,3) == 23);
+    assert(&m1.at_unchecked(1,2,3) == &m1(1,2,3));
+    assert(m1.data()[1 * m1.strideZ() + 2 * m1.strideY() + 3] == 23);
+
+    // Somma di un piano con aritmetica dei puntatori
+    int somma = 0;
+    const int *piano = m1.data() + m1.strideZ();
+    for (unsigned int i = 0; i < m1.strideZ(); i++)
+        somma += piano[i];
+    std::cout << "Somma del secondo piano di m1: " << somma << std::endl;
+    assert(somma == 12 + 13 + 14 + 15 + 16 + 17 + 18 + 19 + 20 + 21 + 22 + 23);
+
+    // Conversione tra politiche diverse
+    Matrice3D<int, defaultCmp, debugAccess> m2(m1);
+    assert(m2(0,1,2) == 6);
+    Matrice3D<double> m3(m2);
+    assert(m3(1,0,0) == 12.0);
+
+    // La politica di default resta quella con eccezioni
+    try {
+        m3(2,0,0) = 1.0;
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Eccezione Operatore() con checkedAccess: " << e.what() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 /**
     @brief Test dell'iterator con una Matrice3D di interi
 
@@ -319,10 +421,1975 @@ void test_trasform() {
     std::cout << std::endl;
 }
 
+/**
+    @brief Test delle allocazioni: move constructor, move assignment e trasform
+           non devono eseguire copie profonde.
+
+*/
+void test_allocazioni() {
+
+    std::cout << "******** Test delle allocazioni (move e trasform) ********" << std::endl;
+
+    double a[8] = {1.5,2.5,3.5,4.5,5.5,6.5,7.5,8.5}; // Dati per riempire la matrice
+    Matrice3D<double> m1(2,2,2);
+    m1.fill(a,a+8);
+
+    // trasform deve allocare solo la matrice risultato
+    unsigned int prima = allocazioni;
+    Matrice3D<int> m2 = trasform<int>(m1, doubleAdd());
+    std::cout << "Allocazioni eseguite da trasform: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 1);
+    assert(m2(0,0,0) == 3 && m2(1,1,1) == 10);
+
+    // Move constructor: nessuna allocazione, m2 resta vuota
+    prima = allocazioni;
+    Matrice3D<int> m3(std::move(m2));
+    assert(allocazioni - prima == 0);
+    assert(m2.size() == 0 && m3.size() == 8);
+    assert(m3(1,1,1) == 10);
+
+    // Move assignment: nessuna allocazione
+    Matrice3D<int> m4(1,1,1);
+    prima = allocazioni;
+    m4 = std::move(m3);
+    assert(allocazioni - prima == 0);
+    assert(m4.size() == 8 && m4(0,0,0) == 3);
+
+    // Il valore di ritorno di slice viene spostato, non copiato
+    prima = allocazioni;
+    Matrice3D<int> m5;
+    m5 = m4.slice(0,0,0,1,0,1);
+    std::cout << "Allocazioni eseguite da slice + assegnamento: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 1);
+    assert(m5.size() == 4 && m5(0,1,1) == m4(0,1,1));
+
+    std::cout << std::endl;
+}
+
+/**
+    @brief Tipo custom che conta le proprie costruzioni e distruzioni
+
+*/
+struct Contatore {
+    static int costruzioni; ///< numero di costruzioni (default e copia)
+    static int distruzioni; ///< numero di distruzioni
+    int v;
+    Contatore() : v(0) { costruzioni++; }
+    Contatore(int v) : v(v) { costruzioni++; }
+    Contatore(const Contatore &c) : v(c.v) { costruzioni++; }
+    Contatore& operator=(const Contatore &c) { v = c.v; return *this; }
+    ~Contatore() { distruzioni++; }
+    bool operator==(const Contatore &c) const { return v == c.v; }
+};
+int Contatore::costruzioni = 0;
+int Contatore::distruzioni = 0;
+
+/**
+    @brief Test degli allocatori: allineamento, costruzione solo dove serve
+           e arena per matrici temporanee
+
+*/
+void test_allocatori() {
+
+    std::cout << "******** Test degli allocatori della Matrice3D ********" << std::endl;
+
+    // L'allocatore di default allinea il buffer a 64 byte
+    Matrice3D<float> m1(3,5,7);
+    assert(reinterpret_cast<std::uintptr_t>(m1.data()) % 64 == 0);
+
+    // La copia costruisce ogni elemento una sola volta (nessuna costruzione di default)
+    Matrice3D<Contatore> m2(2,2,2);
+    for (int i = 0; i < 8; i++)
+        m2.data()[i] = Contatore(i);
+    Contatore::costruzioni = 0;
+    Contatore::distruzioni = 0;
+    {
+        Matrice3D<Contatore> m3(m2);
+        assert(Contatore::costruzioni == 8);
+        assert(m3(1,1,1).v == 7);
+    }
+    assert(Contatore::distruzioni == 8); // Tutti gli elementi vengono distrutti
+
+    // Conversione: costruzione diretta dal valore convertito
+    Contatore::costruzioni = 0;
+    Matrice3D<int> m4(2,2,2);
+    for (int i = 0; i < 8; i++)
+        m4.data()[i] = i * 2;
+    Matrice3D<Contatore> m5(m4);
+    assert(Contatore::costruzioni == 8);
+    assert(m5(1,0,0).v == 8);
+
+    // Arena: molte matrici temporanee con una sola allocazione di sistema
+    typedef arenaAllocator<double> ArenaAlloc;
+    typedef Matrice3D<double, defaultCmp, checkedAccess, ArenaAlloc> MatriceArena;
+    Matrice3DArena arena(1 << 16);
+    unsigned int prima = allocazioni;
+    for (int frame = 0; frame < 3; frame++) {
+        {
+            MatriceArena t1(4,4,4, ArenaAlloc(arena));
+            MatriceArena t2(4,4,4, ArenaAlloc(arena));
+            for (int i = 0; i < 64; i++) {
+                t1.data()[i] = i;
+                t2.data()[i] = 2 * i;
+            }
+            assert(reinterpret_cast<std::uintptr_t>(t2.data()) % 64 == 0);
+            MatriceArena t3(t1); // La copia resta nell'arena
+            assert(t3 == t1 && t3.get_allocator() == t1.get_allocator());
+            MatriceArena t4 = t2.slice(0,1,0,1,0,1);
+            assert(t4(1,1,1) == t2(1,1,1));
+        }
+        arena.reset(); // Fine frame: tutta la memoria torna disponibile
+    }
+    std::cout << "Allocazioni di sistema per 3 frame nell'arena: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 0);
+    assert(arena.used() == 0 && arena.capacity() == (1 << 16));
+
+    std::cout << std::endl;
+}
+
+/**
+    @brief Test degli operatori aritmetici element-wise (expression template)
+
+*/
+void test_espressioni() {
+
+    std::cout << "******** Test degli operatori aritmetici della Matrice3D ********" << std::endl;
+
+    Matrice3D<double> a(2,2,2), b(2,2,2);
+    Matrice3D<int> c(2,2,2); // Tipo diverso dagli altri operandi
+    for (int i = 0; i < 8; i++) {
+        a.data()[i] = i * 0.5;
+        b.data()[i] = i;
+        c.data()[i] = 10 * i;
+    }
+
+    // L'intera espressione viene valutata con la sola allocazione del risultato
+    unsigned int prima = allocazioni;
+    Matrice3D<double> r = a + b * 2.0 - c / 10;
+    std::cout << "Allocazioni eseguite da a + b * 2.0 - c / 10: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 1);
+    for (int i = 0; i < 8; i++)
+        assert(r.data()[i] == i * 0.5 + i * 2.0 - i);
+
+    // Assegnamento su matrice delle stesse dimensioni: nessuna allocazione
+    prima = allocazioni;
+    r = -(a - b) * 4;
+    r += a;
+    r *= 2;
+    assert(allocazioni - prima == 0);
+    assert(r(1,1,1) == (-(3.5 - 7.0) * 4 + 3.5) * 2);
+
+    // Conversione del risultato e comparatore custom, come nel costruttore di conversione
+    Matrice3D<int, intEvenCmp> pari = c + c; // Tutti pari
+    Matrice3D<int, intEvenCmp> altri = 2 * b;
+    assert(pari == altri);
+    printMatrice(pari);
+
+    // Dimensioni diverse
+    try {
+        Matrice3D<double> d(1,2,2);
+        Matrice3D<double> e = a + d;
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Eccezione operatore + (dimensioni diverse): " << e.what() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+/**
+    @brief Test dei kernel vettoriali: ogni livello (scalare, SSE2, AVX2, AVX-512)
+           disponibile sulla CPU deve dare gli stessi risultati del codice scalare.
+           Le dimensioni 3x5x7 (105 elementi) esercitano anche i cicli di coda.
+
+*/
+void test_simd() {
+
+    std::cout << "******** Test dei kernel SIMD della Matrice3D ********" << std::endl;
+
+    Matrice3DSimd::Level rilevato = Matrice3DSimd::detected();
+    std::cout << "Livello SIMD rilevato: " << Matrice3DSimd::name(rilevato) << std::endl;
+
+    Matrice3D<float> f(3,5,7), g(3,5,7), h(3,5,7);
+    Matrice3D<int> n(3,5,7);
+    Matrice3D<std::uint8_t> u(3,5,7);
+    Matrice3D<short> sh(3,5,7);
+    for (int i = 0; i < 105; i++) {
+        f.data()[i] = (i - 50) * 0.37f;
+        g.data()[i] = (i % 7) * 1.5f - 3.0f;
+        h.data()[i] = i * 0.01f;
+        n.data()[i] = (i - 50) * 101;
+        u.data()[i] = static_cast<std::uint8_t>(i * 7);
+        sh.data()[i] = static_cast<short>((i - 50) * 311);
+    }
+
+    for (int l = Matrice3DSimd::scalar; l <= rilevato; l++) {
+        Matrice3DSimd::setLevel(static_cast<Matrice3DSimd::Level>(l));
+        std::cout << "Verifica livello " << Matrice3DSimd::name(Matrice3DSimd::level()) << std::endl;
+
+        // Conversioni (costruttore di conversione e fill)
+        Matrice3D<float> fn(n), fu(u), fs(sh);
+        Matrice3D<int> nf(f);
+        Matrice3D<double> df(f);
+        Matrice3D<float> fd(df);
+        for (int i = 0; i < 105; i++) {
+            assert(fn.data()[i] == static_cast<float>(n.data()[i]));
+            assert(fu.data()[i] == static_cast<float>(u.data()[i]));
+            assert(fs.data()[i] == static_cast<float>(sh.data()[i]));
+            assert(nf.data()[i] == static_cast<int>(f.data()[i]));
+            assert(df.data()[i] == static_cast<double>(f.data()[i]));
+            assert(fd.data()[i] == f.data()[i]);
+        }
+        Matrice3D<float> ff(3,5,7);
+        ff.fill(n.data(), n.data() + 105);
+        assert(ff == fn);
+
+        // Operazioni aritmetiche
+        Matrice3D<float> somma = f + g;
+        Matrice3D<float> prodotto = f * g;
+        Matrice3D<float> muladd = fma(f, g, h);
+        Matrice3D<float> limitata = clamp(f, -2.0f, 3.0f);
+        Matrice3D<float> limitata2 = trasform<float>(f, m3dClamp<float>(-2.0f, 3.0f));
+        Matrice3D<int> nmuladd = fma(n, n, n);
+        Matrice3D<int> nlimitata = clamp(n, -700, 900);
+        for (int i = 0; i < 105; i++) {
+            assert(somma.data()[i] == f.data()[i] + g.data()[i]);
+            assert(prodotto.data()[i] == f.data()[i] * g.data()[i]);
+            assert(muladd.data()[i] == std::fma(f.data()[i], g.data()[i], h.data()[i]));
+            assert(limitata.data()[i] == std::min(std::max(f.data()[i], -2.0f), 3.0f));
+            assert(limitata2.data()[i] == limitata.data()[i]);
+            assert(nmuladd.data()[i] == n.data()[i] * n.data()[i] + n.data()[i]);
+            assert(nlimitata.data()[i] == std::min(std::max(n.data()[i], -700), 900));
+        }
+
+        // Uguaglianza: semantica di == (NaN diverso da se stesso, -0 uguale a +0)
+        Matrice3D<float> f2(f);
+        assert(f2 == f);
+        f2.data()[104] = -f2.data()[104];
+        assert(!(f2 == f));
+        f2.data()[104] = f.data()[104];
+        f2.data()[0] = 0.0f;
+        Matrice3D<float> f3(f2);
+        f3.data()[0] = -0.0f;
+        assert(f2 == f3);
+        f3.data()[0] = std::nanf("");
+        assert(!(f3 == f3));
+        Matrice3D<short> sh2(sh);
+        assert(sh2 == sh);
+        sh2.data()[104] = 0;
+        assert(!(sh2 == sh));
+
+        // Minimo/massimo elemento per elemento e riduzioni
+        float fmin[105], fmax[105];
+        int nmin[105];
+        Matrice3DSimd::min(fmin, f.data(), g.data(), 105);
+        Matrice3DSimd::max(fmax, f.data(), g.data(), 105);
+        Matrice3DSimd::min(nmin, n.data(), n.data() + 1, 104);
+        double fsum = 0;
+        for (int i = 0; i < 105; i++) {
+            assert(fmin[i] == std::min(f.data()[i], g.data()[i]) && fmax[i] == std::max(f.data()[i], g.data()[i]));
+            fsum += g.data()[i];
+        }
+        for (int i = 0; i < 104; i++)
+            assert(nmin[i] == std::min(n.data()[i], n.data()[i + 1]));
+        assert(Matrice3DSimd::minimum(f.data(), 105) == f.data()[0] && Matrice3DSimd::maximum(f.data(), 105) == f.data()[104]);
+        assert(Matrice3DSimd::minimum(n.data() + 60, 45) == n.data()[60] && Matrice3DSimd::maximum(n.data(), 3) == n.data()[2]);
+        assert(Matrice3DSimd::sum(g.data(), 105) == (float)fsum);
+    }
+    Matrice3DSimd::setLevel(rilevato);
+    std::cout << std::endl;
+}
+
+/**
+    @brief Funtore non lineare per il test delle esecuzioni parallele
+*/
+struct doubleWave {
+    double operator()(double x) const { return std::sin(x) * x + 1.0 / (1.0 + x * x); }
+};
+
+/**
+    @brief Funtore che lancia un'eccezione su un valore specifico
+*/
+struct throwOnNegative {
+    int operator()(int x) const {
+        if (x < 0)
+            throw Matrice3DError("valore negativo");
+        return x;
+    }
+};
+
+/**
+    @brief Test delle operazioni parallele: i risultati con m3dPar(pool) devono essere
+           identici a quelli sequenziali.
+
+*/
+void test_parallelo() {
+
+    std::cout << "******** Test delle operazioni parallele della Matrice3D ********" << std::endl;
+
+    Matrice3DThreadPool pool(4);
+    std::cout << "Thread del pool: " << pool.size() << std::endl;
+
+    std::vector<double> dati(17 * 9 * 13);
+    for (std::size_t i = 0; i < dati.size(); i++)
+        dati[i] = (double(i) - 700.0) * 0.013;
+
+    // Ripeto piu' volte per esercitare il riuso del pool
+    for (int ripetizione = 0; ripetizione < 50; ripetizione++) {
+        // fill da iteratori random access (non puntatori)
+        Matrice3D<double> a(17,9,13), b(17,9,13);
+        a.fill(dati.begin(), dati.end(), m3dSeq);
+        b.fill(dati.begin(), dati.end(), m3dPar(pool));
+        assert(a == b);
+        assert(a.equals(b, m3dPar(pool)) && b.equals(a, m3dSeq));
+
+        // trasform
+        Matrice3D<double> ta = trasform<double>(a, doubleWave(), m3dSeq);
+        Matrice3D<double> tb = trasform<double>(a, doubleWave(), m3dPar(pool));
+        assert(std::equal(ta.begin(), ta.end(), tb.begin()));
+
+        // Costruttore di conversione
+        Matrice3D<float> ca(a, m3dSeq);
+        Matrice3D<float> cb(a, m3dPar(pool));
+        assert(ca == cb);
+        Matrice3D<Coordinates> co(2,3,4);
+        co(1,2,3) = Coordinates(ripetizione, 0);
+        Matrice3D<int> ci(co, m3dPar(pool)); // Tipo custom: conversione sequenziale
+        assert(ci(1,2,3) == ripetizione && ci(0,0,0) == 0);
+
+        // Differenza solo nell'ultimo elemento
+        tb(16,8,12) += 1.0;
+        assert(!ta.equals(tb, m3dPar(pool)));
+    }
+
+    // Comparatore custom in parallelo
+    Matrice3D<int, intEvenCmp> p1(8,2,2), p2(8,2,2);
+    for (int i = 0; i < 32; i++) {
+        p1.data()[i] = 2 * i;
+        p2.data()[i] = 4 * i;
+    }
+    assert(p1.equals(p2, m3dPar(pool)));
+    p2(7,1,1) = 3;
+    assert(!p1.equals(p2, m3dPar(pool)));
+
+    // Le eccezioni del funtore arrivano al chiamante
+    Matrice3D<int> n(8,4,4);
+    for (int i = 0; i < 128; i++)
+        n.data()[i] = i;
+    n(5,0,0) = -1;
+    try {
+        trasform<int>(n, throwOnNegative(), m3dPar(pool));
+        assert(false);
+    }
+    catch(Matrice3DError &e){
+        std::cout << "Eccezione dal funtore in parallelo: " << e.what() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+/**
+    @brief Test dei layout di memoria: operatore (), iteratori, slice, == e conversioni
+           devono dare gli stessi risultati con i layout row-major, a mattoni e Morton.
+
+*/
+void test_layout() {
+
+    std::cout << "******** Test dei layout della Matrice3D ********" << std::endl;
+
+    typedef Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<8> > tiled;
+    typedef Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, mortonLayout> morton;
+    typedef Matrice3D<float, defaultCmp, checkedAccess, alignedAllocator<float>, tiledLayout<4> > tiledF;
+
+    // Dimensioni non multiple dei mattoni e assi con numero di bit diverso
+    const int dims[4][3] = { {19, 13, 11}, {3, 70, 5}, {1, 1, 9}, {16, 16, 16} };
+    for (int d = 0; d < 4; d++) {
+        int Z = dims[d][0], Y = dims[d][1], X = dims[d][2];
+        Matrice3D<int> a(Z, Y, X);
+        for (int i = 0; i < Z; i++)
+            for (int j = 0; j < Y; j++)
+                for (int k = 0; k < X; k++)
+                    a(i, j, k) = i * 10000 + j * 100 + k;
+
+        // Relayout in entrambe le direzioni
+        tiled t(a);
+        morton m(t);
+        for (int i = 0; i < Z; i++)
+            for (int j = 0; j < Y; j++)
+                for (int k = 0; k < X; k++)
+                    assert(t(i, j, k) == a(i, j, k) && m(i, j, k) == a(i, j, k));
+        assert(Matrice3D<int>(m) == a);
+        assert(Matrice3D<int>(t) == a);
+
+        // Gli iteratori visitano gli elementi nello stesso ordine
+        assert(std::equal(a.begin(), a.end(), t.begin()));
+        assert(std::equal(a.begin(), a.end(), m.begin()));
+        assert((unsigned int)std::distance(t.begin(), t.end()) == a.size());
+
+        // Copia, == e conversione di tipo con lo stesso layout
+        tiled t2(t);
+        assert(t2 == t && t2.equals(t, m3dSeq));
+        t2(Z - 1, Y - 1, X - 1) = -1;
+        assert(!(t2 == t));
+        tiledF tf(t);
+        assert(tf(Z - 1, 0, X - 1) == static_cast<float>(a(Z - 1, 0, X - 1)));
+
+        // fill nell'ordine degli iteratori
+        morton m2(Z, Y, X);
+        m2.fill(a.begin(), a.end());
+        assert(m2 == m);
+
+        // slice
+        int z2 = Z - 1, y2 = Y / 2, x2 = X - 1;
+        assert(Matrice3D<int>(t.slice(0, z2, 1 < y2 ? 1 : 0, y2, 0, x2)) == a.slice(0, z2, 1 < y2 ? 1 : 0, y2, 0, x2));
+        assert(Matrice3D<int>(m.slice(z2, z2, 0, y2, x2 / 2, x2)) == a.slice(z2, z2, 0, y2, x2 / 2, x2));
+
+        // trasform ed espressioni
+        assert(trasform<int>(t, doubleAdd()) == trasform<int>(a, doubleAdd()));
+        tiled somma(a + a);
+        assert(Matrice3D<int>(somma) == a * 2);
+    }
+
+    // Iteratore in scrittura e const_iterator
+    tiled t(9, 9, 9);
+    int n = 0;
+    for (tiled::iterator i = t.begin(); i != t.end(); ++i)
+        *i = n++;
+    const tiled &ct = t;
+    tiled::const_iterator ci = ct.begin();
+    assert(*ci == 0 && t(8, 8, 8) == 728 && t(1, 0, 0) == 81);
+
+    // Comparatore custom con layout non contiguo
+    Matrice3D<int, intEvenCmp, checkedAccess, alignedAllocator<int>, mortonLayout> e1(3, 5, 2), e2(3, 5, 2);
+    e1(2, 4, 1) = 2;
+    e2(2, 4, 1) = 4;
+    assert(e1 == e2);
+    e2(2, 4, 1) = 3;
+    assert(!(e1 == e2));
+
+    // Coordinate fuori range
+    try {
+        t(9, 0, 0) = 1;
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Accesso fuori range con layout a mattoni: " << e.what() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+/**
+    @brief Test del formato binario: save, load e load_mapped (sola lettura e copy-on-write)
+
+*/
+void test_file() {
+
+    std::cout << "******** Test del salvataggio su file della Matrice3D ********" << std::endl;
+
+    const std::string file = "test_matrice3d.m3d";
+
+    Matrice3D<float> a(7, 33, 65);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = i * 0.25f - 100.0f;
+    save(a, file);
+
+    // Lettura completa
+    Matrice3D<float> l = load<Matrice3D<float> >(file);
+    assert(l == a);
+
+    // Mappatura in sola lettura: nessuna lettura, i dati sono quelli del file
+    {
+        const Matrice3DMapped<float> m = load_mapped<Matrice3DMapped<float> >(file);
+        assert(m.get_allocator().mapping->contains(m.data()));
+        assert(std::equal(a.begin(), a.end(), m.begin()));
+        // Le copie vivono sull'heap
+        Matrice3DMapped<float> c(m);
+        assert(!m.get_allocator().mapping->contains(c.data()));
+        c(0, 0, 0) = 1.0f;
+        assert(m(0, 0, 0) == a(0, 0, 0));
+    }
+
+    // Copy-on-write: le scritture non arrivano al file
+    {
+        Matrice3DMapped<float> w = load_mapped<Matrice3DMapped<float> >(file, m3dCopyOnWrite);
+        w(6, 32, 64) = 42.0f;
+        assert(w(6, 32, 64) == 42.0f);
+        assert(load<Matrice3D<float> >(file)(6, 32, 64) == a(6, 32, 64));
+    }
+
+    // Layout a mattoni e Morton
+    Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<8> > t((Matrice3D<int>(a)));
+    save(t, file);
+    assert((load<Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<8> > >(file) == t));
+    const Matrice3DMapped<int, tiledLayout<8> > mt = load_mapped<Matrice3DMapped<int, tiledLayout<8> > >(file);
+    assert(std::equal(t.begin(), t.end(), mt.begin()));
+    Matrice3D<double, defaultCmp, checkedAccess, alignedAllocator<double>, mortonLayout> md(a);
+    save(md, file);
+    assert((load<Matrice3D<double, defaultCmp, checkedAccess, alignedAllocator<double>, mortonLayout> >(file) == md));
+
+    // Tipo o layout diversi da quelli del file
+    try {
+        load<Matrice3D<float> >(file);
+        assert(false);
+    }
+    catch(Matrice3DError &e){
+        std::cout << "Tipo diverso: " << e.what() << std::endl;
+    }
+    try {
+        load<Matrice3D<double> >(file);
+        assert(false);
+    }
+    catch(Matrice3DError &e){
+        std::cout << "Layout diverso: " << e.what() << std::endl;
+    }
+
+    // File scritto con l'ordine dei byte opposto
+    Matrice3D<int> s(2, 3, 4);
+    for (unsigned int i = 0; i < s.size(); i++)
+        s.data()[i] = 1000 * i + 7;
+    save(s, file);
+    {
+        std::fstream f(file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        Matrice3DFileHeader h;
+        f.read(reinterpret_cast<char *>(&h), sizeof(h));
+        m3dByteSwap(&h.byteOrder, 4, 1);
+        m3dByteSwap(&h.version, 2, 1);
+        m3dByteSwap(&h.sizeZ, 8, 6);
+        Matrice3D<int> swapped(s);
+        m3dByteSwap(swapped.data(), sizeof(int), swapped.size());
+        f.seekp(0);
+        f.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        f.write(reinterpret_cast<const char *>(swapped.data()), swapped.size() * sizeof(int));
+    }
+    assert(load<Matrice3D<int> >(file) == s);
+    try {
+        load_mapped<Matrice3DMapped<int> >(file);
+        assert(false);
+    }
+    catch(Matrice3DError &e){
+        std::cout << "Ordine dei byte diverso: " << e.what() << std::endl;
+    }
+
+    // Header corrotti: rifiutati con Matrice3DError prima di allocare il buffer
+    for (int caso = 0; caso < 5; caso++) {
+        save(s, file);
+        {
+            std::fstream f(file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            Matrice3DFileHeader h;
+            f.read(reinterpret_cast<char *>(&h), sizeof(h));
+            if (caso == 0)
+                h.sizeZ = std::uint64_t(1) << 40; // dimensione oltre INT_MAX
+            else if (caso == 1)
+                h.count = 1000; // count diverso da z * y * x
+            else if (caso == 2) {
+                h.sizeZ = h.sizeY = h.sizeX = 100000; // 4 * 10^15 byte in un file di 160
+                h.count = std::uint64_t(100000) * 100000 * 100000;
+            }
+            else if (caso == 3)
+                h.dataOffset = ~std::uint64_t(63); // allineato, ma dataOffset + count * 4 in overflow
+            else {
+                h.dataOffset = 68; // buffer intero nel file ma non allineato a 64 byte
+                f.seekp(0, std::ios::end);
+                f.write(std::string(64, '\0').data(), 64);
+            }
+            f.seekp(0);
+            f.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        }
+        for (int mappato = 0; mappato < 2; mappato++)
+            try {
+                if (mappato)
+                    load_mapped<Matrice3DMapped<int> >(file);
+                else
+                    load<Matrice3D<int> >(file);
+                assert(false);
+            }
+            catch(Matrice3DError &e){
+                if (mappato)
+                    std::cout << "Header corrotto (" << caso << "): " << e.what() << std::endl;
+            }
+    }
+
+    // Matrice vuota
+    save(Matrice3D<int>(), file);
+    assert(load<Matrice3D<int> >(file).size() == 0);
+    std::remove(file.c_str());
+    std::cout << std::endl;
+}
+
+/**
+    @brief Test della Matrice3DStream: la cache resta nel budget e i valori coincidono
+           con quelli di una Matrice3D in memoria.
+
+*/
+void test_stream() {
+
+    std::cout << "******** Test della Matrice3DStream ********" << std::endl;
+
+    const std::string file = "test_stream.m3d";
+    const std::string file2 = "test_stream2.m3d";
+
+    Matrice3D<int> a(21, 16, 12);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = i * 3 - 500;
+
+    const std::size_t plane = 16 * 12 * sizeof(int);
+    {
+        // Budget di 3 slab da 2 piani: 11 slab in tutto
+        Matrice3DStream<int> s(file, 21, 16, 12, 3 * 2 * plane, 2);
+        assert(s.slabs() == 11 && s.slots() == 3 && s.memory() <= s.budget());
+        for (int i = 0; i < 21; i++)
+            for (int j = 0; j < 16; j++)
+                for (int k = 0; k < 12; k++)
+                    s(i, j, k) = a(i, j, k);
+        std::cout << "Slab letti: " << s.loads() << ", riscritti: " << s.writes() << std::endl;
+        // Ogni slab viene letto una volta sola (anche grazie al prefetch)
+        assert(s.loads() == 11);
+    }
+    // Gli slab modificati sono stati riscritti: il file e' leggibile con load()
+    assert(load<Matrice3D<int> >(file) == a);
+
+    {
+        const Matrice3DStream<int> s(file, 4 * plane);
+        assert(s.depth() == 1 && s.slots() == 4);
+        // Iterazione sequenziale
+        assert(std::equal(a.begin(), a.end(), s.begin()));
+        assert(s.writes() == 0);
+        // Accesso casuale: l'LRU deve ricaricare gli slab scartati
+        for (int r = 0; r < 200; r++) {
+            int i = (r * 7) % 21, j = (r * 5) % 16, k = (r * 3) % 12;
+            assert(s(i, j, k) == a(i, j, k));
+        }
+        // slice
+        assert(s.slice(3, 17, 2, 9, 0, 11) == a.slice(3, 17, 2, 9, 0, 11));
+
+        // trasform in streaming su un secondo file, con slab di profondita' diversa
+        Matrice3DStream<float> b(file2, 21, 16, 12, 3 * 3 * plane, 3);
+        trasform(s, doubleAdd(), b);
+        b.flush();
+        assert(load<Matrice3D<float> >(file2) == Matrice3D<float>(trasform<int>(a, doubleAdd())));
+    }
+
+    // Lettura attraverso una Matrice3DStream non costante (operatore () e iteratori):
+    // gli slab restano puliti e il file non viene riscritto
+    {
+        Matrice3DStream<int> s(file, 3 * 2 * plane, 2);
+        long long somma = 0, attesa = 0;
+        for (int v : s)
+            somma += v;
+        for (int i = 0; i < 21; i++)
+            for (int j = 0; j < 16; j++)
+                for (int k = 0; k < 12; k++)
+                    somma += s(i, j, k);
+        for (int v : a)
+            attesa += 2 * v;
+        assert(somma == attesa && std::equal(a.begin(), a.end(), s.begin()));
+        s.flush();
+        assert(s.writes() == 0);
+        // Un assegnamento segna solo il suo slab
+        s(20, 15, 11) = s(20, 15, 11);
+        s.flush();
+        assert(s.writes() == 1);
+        // slab() su una matrice costante e' in sola lettura e non segna lo slab
+        const Matrice3DStream<int> &cs = s;
+        assert((std::is_same<decltype(cs.slab(0)), const int *>::value));
+        assert(cs.slab(1)[0] == a(2, 0, 0));
+        s.flush();
+        assert(s.writes() == 1);
+    }
+    assert(load<Matrice3D<int> >(file) == a);
+
+    // Scrittura tramite iteratore
+    {
+        Matrice3DStream<int> s(file, 2 * 5 * plane, 5);
+        int n = 0;
+        for (Matrice3DStream<int>::iterator i = s.begin(); i != s.end(); ++i)
+            *i = n++;
+    }
+    assert(load<Matrice3D<int> >(file)(20, 15, 11) == (int)a.size() - 1);
+
+    // Budget insufficiente e coordinate non valide
+    try {
+        Matrice3DStream<int> s(file, plane);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Budget insufficiente: " << e.what() << std::endl;
+    }
+    try {
+        Matrice3DStream<int> s(file, 4 * plane);
+        s(21, 0, 0) = 1;
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Coordinate fuori range: " << e.what() << std::endl;
+    }
+    std::remove(file.c_str());
+    std::remove(file2.c_str());
+    std::cout << std::endl;
+}
+
 /**
     @brief Test del metodo slice con una Matrice3D di interi 
 
 */
+/**
+    Coordinata del vicino c lungo un asse di n elementi secondo la condizione al
+    contorno (-1 se il vicino vale zero)
+*/
+int coordinata_bordo(int c, int n, Matrice3DBoundary b) {
+    if (c >= 0 && c < n)
+        return c;
+    if (b == m3dBoundaryZero)
+        return -1;
+    if (b == m3dBoundaryClamp)
+        return c < 0 ? 0 : n - 1;
+    return ((c % n) + n) % n;
+}
+
+/**
+    Convoluzione di riferimento, calcolata elemento per elemento con operator ()
+*/
+Matrice3D<int> convolve_rif(const Matrice3D<int> &a, const Matrice3DKernel<int> &k, Matrice3DBoundary b) {
+    int Z = a.sizeZ(), Y = a.sizeY(), X = a.sizeX();
+    Matrice3D<int> r(Z, Y, X);
+    for (int i = 0; i < Z; i++)
+        for (int j = 0; j < Y; j++)
+            for (int l = 0; l < X; l++) {
+                int s = 0;
+                for (int dz = -k.radiusZ(); dz <= k.radiusZ(); dz++)
+                    for (int dy = -k.radiusY(); dy <= k.radiusY(); dy++)
+                        for (int dx = -k.radiusX(); dx <= k.radiusX(); dx++) {
+                            int z = coordinata_bordo(i + dz, Z, b), y = coordinata_bordo(j + dy, Y, b), x = coordinata_bordo(l + dx, X, b);
+                            if (z >= 0 && y >= 0 && x >= 0)
+                                s += k(dz, dy, dx) * a(z, y, x);
+                        }
+                r(i, j, l) = s;
+            }
+    return r;
+}
+
+/**
+    @brief Stencil a 27 punti: massimo del vicinato
+*/
+struct max27 {
+    int operator()(const Matrice3DNeighborhood<int> &n) const {
+        int m = n(0, 0, 0);
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    m = std::max(m, n(dz, dy, dx));
+        return m;
+    }
+};
+
+void test_stencil() {
+
+    std::cout << "******** Test degli stencil della Matrice3D ********" << std::endl;
+
+    const Matrice3DBoundary bordi[3] = { m3dBoundaryZero, m3dBoundaryClamp, m3dBoundaryWrap };
+
+    Matrice3D<int> a(40, 36, 23);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = int(i * 7919 % 201) - 100;
+
+    // Kernel generico con raggi diversi sui tre assi
+    Matrice3DKernel<int> k(1, 2, 1);
+    for (int dz = -1; dz <= 1; dz++)
+        for (int dy = -2; dy <= 2; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                k.set(dz, dy, dx, (dz * 3 + dy * 5 - dx * 2 + 7) % 4);
+    assert(!k.isSeparable());
+
+    // Kernel separabile e la stessa matrice di pesi come kernel generico
+    std::vector<int> wz = { 1, 2, 1 }, wy = { 1, -1, 3 }, wx = { 2, 0, 1, 1, -1 };
+    Matrice3DKernel<int> s = Matrice3DKernel<int>::separable(wz, wy, wx), d(s);
+    d.set(0, 0, 0, s(0, 0, 0));
+    assert(s.isSeparable() && !d.isSeparable() && s(1, -1, 2) == 1 * 1 * -1);
+
+    for (int b = 0; b < 3; b++) {
+        Matrice3D<int> r1 = convolve_rif(a, k, bordi[b]);
+        Matrice3D<int> r3 = convolve_rif(convolve_rif(r1, k, bordi[b]), k, bordi[b]);
+        assert(convolve(a, k, bordi[b]) == r1);
+        assert(convolve(a, k, bordi[b], 3) == r3);
+
+        // Tile piccoli: halo tra tile e bordi della matrice nello stesso tile
+        Matrice3DStencil<int> e1(40, 36, 23, 1, 2, 1, 1, bordi[b], 4096), e3(40, 36, 23, 1, 2, 1, 3, bordi[b], 4096);
+        assert(e1.tiles() > 4 && e3.tiles() > 1);
+        m3dKernelRows<int> op1(k, e1.strideZ(), e1.strideY()), op3(k, e3.strideZ(), e3.strideY());
+        assert((m3dStencilRun<int, defaultCmp>(a, e1, op1, m3dSeq) == r1));
+        assert((m3dStencilRun<int, defaultCmp>(a, e3, op3, m3dSeq) == r3));
+
+        // Passate 1D del kernel separabile
+        Matrice3D<int> s2 = convolve_rif(convolve_rif(a, d, bordi[b]), d, bordi[b]);
+        assert(convolve(a, s, bordi[b], 2) == s2);
+        Matrice3DStencil<int> es(40, 36, 23, 1, 1, 2, 2, bordi[b], 4096);
+        m3dKernelRows<int> ops(s, es.strideZ(), es.strideY());
+        assert(ops.passes() == 3 && es.tiles() > 1);
+        assert((m3dStencilRun<int, defaultCmp>(a, es, ops, m3dSeq) == s2));
+
+        // Stencil con funtore: 27 punti e coordinate del centro
+        Matrice3D<int> m = stencil(a, 1, max27(), bordi[b]);
+        for (int i = 0; i < 40; i += 13)
+            for (int j = 0; j < 36; j += 7)
+                for (int l = 0; l < 23; l += 11) {
+                    int v = a(i, j, l);
+                    for (int dz = -1; dz <= 1; dz++)
+                        for (int dy = -1; dy <= 1; dy++)
+                            for (int dx = -1; dx <= 1; dx++) {
+                                int z = coordinata_bordo(i + dz, 40, bordi[b]), y = coordinata_bordo(j + dy, 36, bordi[b]), x = coordinata_bordo(l + dx, 23, bordi[b]);
+                                v = std::max(v, z < 0 || y < 0 || x < 0 ? 0 : a(z, y, x));
+                            }
+                    assert(m(i, j, l) == v);
+                }
+        Matrice3D<int> c = stencil(a, 2, [](const Matrice3DNeighborhood<int> &n) { return int(n.z() * 10000 + n.y() * 100 + n.x()); }, bordi[b], 2);
+        assert(c(39, 35, 22) == 393522 && c(7, 0, 3) == 70003);
+    }
+
+    // Laplaciano: nullo su una matrice costante con Clamp e Wrap
+    Matrice3D<float> f(12, 10, 9);
+    std::fill(f.begin(), f.end(), 2.5f);
+    Matrice3DKernel<float> lap = Matrice3DKernel<float>::laplacian();
+    Matrice3D<float> l0 = convolve(f, lap), lc = convolve(f, lap, m3dBoundaryClamp, 4), lw = convolve(f, lap, m3dBoundaryWrap);
+    for (unsigned int i = 0; i < f.size(); i++)
+        assert(lc.data()[i] == 0 && lw.data()[i] == 0);
+    assert(l0(0, 0, 0) == -7.5f && l0(0, 5, 5) == -2.5f && l0(6, 5, 5) == 0);
+    assert(convolve(f, lap, m3dBoundaryZero, 0) == f);
+
+    // Esecuzione parallela, ingresso con layout a mattoni
+    Matrice3DThreadPool pool(3);
+    assert(convolve(a, k, m3dBoundaryWrap, 2, m3dPar(pool)) == convolve(a, k, m3dBoundaryWrap, 2));
+    assert(stencil(a, 1, max27(), m3dBoundaryClamp, 1, m3dPar(pool)) == stencil(a, 1, max27(), m3dBoundaryClamp));
+    Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<4> > t(a);
+    assert(convolve(t, k, m3dBoundaryClamp) == convolve(a, k, m3dBoundaryClamp));
+    assert(convolve(Matrice3D<int>(), k).size() == 0);
+
+    try {
+        Matrice3DKernel<int> n(1, -1, 0);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Raggio negativo: " << e.what() << std::endl;
+    }
+    try {
+        std::vector<int> pari = { 1, 1 };
+        Matrice3DKernel<int>::separable(wz, pari, wx);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Pesi 1D di lunghezza pari: " << e.what() << std::endl;
+    }
+    try {
+        k.set(2, 0, 0, 1);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Peso fuori dal kernel: " << e.what() << std::endl;
+    }
+}
+
+void test_riduzioni() {
+
+    std::cout << "******** Test delle riduzioni della Matrice3D ********" << std::endl;
+
+    const int Z = 7, Y = 9, X = 2100;
+    Matrice3D<int> a(Z, Y, X);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = int(i * 7919 % 1001) - 500;
+    a(4, 2, 1733) = 600;
+    a(5, 8, 2) = 600;
+    a(1, 3, 40) = -700;
+
+    // Intera matrice, confrontata con un ciclo su operator ()
+    long long s = 0;
+    int lo = a(0, 0, 0), hi = a(0, 0, 0);
+    for (int i = 0; i < Z; i++)
+        for (int j = 0; j < Y; j++)
+            for (int k = 0; k < X; k++) {
+                s += a(i, j, k);
+                lo = std::min(lo, a(i, j, k));
+                hi = std::max(hi, a(i, j, k));
+            }
+    assert(sum(a) == s && minimum(a) == lo && maximum(a) == hi);
+    assert(mean(a) == double(s) / a.size());
+    Matrice3DIndex im = argmax(a), in = argmin(a);
+    assert(im.z == 4 && im.y == 2 && im.x == 1733 && in.z == 1 && in.y == 3 && in.x == 40);
+
+    // Lungo gli assi
+    Matrice3D<long long> sz = sum(a, m3dAxisZ), sy = sum(a, m3dAxisY), sx = sum(a, m3dAxisX);
+    assert(sz.sizeZ() == 1 && sz.sizeY() == Y && sz.sizeX() == X);
+    assert(sy.sizeZ() == Z && sy.sizeY() == 1 && sy.sizeX() == X);
+    assert(sx.sizeZ() == Z && sx.sizeY() == Y && sx.sizeX() == 1);
+    Matrice3D<int> mz = maximum(a, m3dAxisZ), ny = minimum(a, m3dAxisY);
+    Matrice3D<unsigned int> az = argmax(a, m3dAxisZ), ay = argmin(a, m3dAxisY), ax = argmax(a, m3dAxisX);
+    for (int j = 0; j < Y; j++)
+        for (int k = 0; k < X; k++) {
+            long long t = 0;
+            unsigned int best = 0;
+            for (int i = 0; i < Z; i++) {
+                t += a(i, j, k);
+                if (a((int)best, j, k) < a(i, j, k))
+                    best = i;
+            }
+            assert(sz(0, j, k) == t && az(0, j, k) == best && mz(0, j, k) == a(best, j, k));
+        }
+    for (int i = 0; i < Z; i++)
+        for (int k = 0; k < X; k++) {
+            long long t = 0;
+            unsigned int best = 0;
+            for (int j = 0; j < Y; j++) {
+                t += a(i, j, k);
+                if (a(i, j, k) < a(i, (int)best, k))
+                    best = j;
+            }
+            assert(sy(i, 0, k) == t && ay(i, 0, k) == best && ny(i, 0, k) == a(i, best, k));
+        }
+    for (int i = 0; i < Z; i++)
+        for (int j = 0; j < Y; j++) {
+            long long t = 0;
+            for (int k = 0; k < X; k++)
+                t += a(i, j, k);
+            assert(sx(i, j, 0) == t && a(i, j, (int)ax(i, j, 0)) == maximum(a.slice(i, i, j, j, 0, X - 1)));
+        }
+    assert(ax(4, 2, 0) == 1733 && ax(5, 8, 0) == 2);
+    Matrice3D<double> my = mean(a, m3dAxisY);
+    assert(my(3, 0, 17) == double(sy(3, 0, 17)) / Y);
+
+    // Politica parallela e layout a mattoni: stessi risultati
+    Matrice3DThreadPool pool(3);
+    assert(sum(a, m3dPar(pool)) == s && argmax(a, m3dPar(pool)) == im && minimum(a, m3dPar(pool)) == lo);
+    assert(sum(a, m3dAxisZ, m3dPar(pool)) == sz && argmin(a, m3dAxisY, m3dPar(pool)) == ay);
+    assert(maximum(a, m3dAxisX, m3dPar(pool)) == maximum(a, m3dAxisX));
+    Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<8> > t(a);
+    assert(sum(t) == s && argmin(t) == in && sum(t, m3dAxisY) == sy);
+
+    // Somma a coppie: 2^24 + 4M volte 1 in float (sommando in sequenza resterebbe 2^24)
+    Matrice3D<float> f(64, 256, 257);
+    std::fill(f.begin(), f.end(), 1.0f);
+    f(0, 0, 0) = 16777216.0f;
+    float fs = sum(f);
+    assert(std::fabs(double(fs) - (16777216.0 + (f.size() - 1))) < 1e-6 * fs);
+    assert(sum(f, m3dPar(pool)) == fs);
+    Matrice3D<float> fz = sum(f, m3dAxisZ);
+    assert(std::fabs(fz(0, 0, 0) - (16777216.0 + 63)) < 1e-6 * fz(0, 0, 0) && fz(0, 9, 9) == 64);
+    assert(mean(f, m3dAxisX)(3, 3, 0) == 1.0f);
+
+    // Matrice vuota
+    assert(sum(Matrice3D<int>()) == 0 && sum(Matrice3D<int>(), m3dAxisZ).size() == 0);
+    try {
+        maximum(Matrice3D<float>());
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Massimo di una matrice vuota: " << e.what() << std::endl;
+    }
+}
+
+void test_sparse() {
+
+    std::cout << "******** Test della Matrice3DSparse ********" << std::endl;
+
+    // Volume quasi vuoto (fill -1) con due blocchi di valori e qualche punto isolato
+    const int Z = 37, Y = 41, X = 50;
+    Matrice3D<float> d(Z, Y, X);
+    std::fill(d.begin(), d.end(), -1.0f);
+    for (int i = 3; i < 9; i++)
+        for (int j = 30; j < 41; j++)
+            for (int k = 45; k < 50; k++)
+                d(i, j, k) = float(i * 100 + j + k);
+    d(36, 0, 0) = 5;
+    d(20, 20, 20) = 7;
+
+    Matrice3DSparse<float> sp(d, -1.0f);
+    assert(sp.sizeZ() == Z && sp.sizeY() == Y && sp.sizeX() == X && sp.size() == d.size());
+    // Blocco: 2 mattoni in z, 3 in y, 2 in x; piu' i due punti
+    assert(sp.bricks() == 14 && sp.storage_size() == 14 * 512);
+    assert(sp.materialize() == d);
+    const Matrice3DSparse<float> &csp = sp;
+    assert(csp(0, 0, 0) == -1.0f && csp(20, 20, 20) == 7 && sp.bricks() == 14);
+
+    // Scrittura: alloca il mattone solo nelle regioni vuote
+    sp(10, 10, 10) = 3;
+    d(10, 10, 10) = 3;
+    sp(20, 20, 21) = 8;
+    d(20, 20, 21) = 8;
+    assert(sp.bricks() == 15 && sp.materialize() == d);
+    sp(1, 2, 3) = sp(20, 20, 20);
+    d(1, 2, 3) = 7;
+    assert(sp.bricks() == 16 && csp(1, 2, 3) == 7);
+
+    // Letture da una matrice non costante: nessun mattone allocato
+    Matrice3DSparse<int> letta(64, 64, 64, 3);
+    long long somma = 0;
+    for (int z = 0; z < 64; z++)
+        for (int y = 0; y < 64; y++)
+            for (int x = 0; x < 64; x++)
+                somma += letta(z, y, x);
+    assert(somma == 3 * 64 * 64 * 64 && letta.bricks() == 0);
+    letta(63, 0, 9) += 1;
+    assert(letta.bricks() == 1 && letta(63, 0, 9) == 4 && letta(63, 0, 8) == 3);
+
+    // Iterazione sui soli mattoni memorizzati
+    double tot = 0;
+    unsigned int visti = 0;
+    for (Matrice3DSparse<float>::const_iterator i = csp.begin(); i != csp.end(); ++i, ++visti)
+        for (unsigned int dz = 0; dz < (*i).sizeZ(); dz++)
+            for (unsigned int dy = 0; dy < (*i).sizeY(); dy++)
+                for (unsigned int dx = 0; dx < (*i).sizeX(); dx++) {
+                    assert((*i)(dz, dy, dx) == d((*i).z() + dz, (*i).y() + dy, (*i).x() + dx));
+                    if ((*i)(dz, dy, dx) != -1.0f)
+                        tot += (*i)(dz, dy, dx);
+                }
+    double atteso = 0;
+    for (Matrice3D<float>::const_iterator i = d.begin(); i != d.end(); ++i)
+        if (*i != -1.0f)
+            atteso += *i;
+    assert(visti == sp.bricks() && tot == atteso);
+
+    // slice su intervalli allineati e non ai mattoni
+    assert(sp.slice(2, 12, 25, 40, 40, 49).materialize() == d.slice(2, 12, 25, 40, 40, 49));
+    assert(sp.slice(0, 36, 0, 40, 0, 49).materialize() == d);
+    Matrice3DSparse<float> vuota = sp.slice(12, 19, 0, 9, 0, 9);
+    assert(vuota.bricks() == 0 && vuota.materialize() == d.slice(12, 19, 0, 9, 0, 9));
+
+    // trasform: anche il fill viene trasformato
+    Matrice3DSparse<double> t = trasform<double>(sp, [](float v) { return v * 2.0 + 1; });
+    assert(t.fill_value() == -1.0 && t.bricks() == sp.bricks());
+    assert(t.materialize() == trasform<double>(d, [](float v) { return v * 2.0 + 1; }));
+    Matrice3DThreadPool pool(3);
+    assert(trasform<float>(sp, m3dClamp<float>(0, 10), m3dPar(pool)).materialize() ==
+           trasform<float>(d, m3dClamp<float>(0, 10)));
+
+    // == con fill e mattoni diversi
+    Matrice3DSparse<float> copia(sp);
+    assert(copia == sp);
+    copia(30, 0, 0) = -1.0f; // mattone memorizzato ma tutto a fill
+    assert(copia == sp && copia.bricks() == sp.bricks() + 1);
+    copia.prune();
+    assert(copia == sp && copia.bricks() == sp.bricks());
+    copia(36, 0, 0) = 6;
+    assert(!(copia == sp));
+    Matrice3DSparse<float> altroFill(sp.materialize(), 0.0f);
+    assert(altroFill == sp && altroFill.fill_value() == 0.0f && altroFill.bricks() > sp.bricks());
+    assert(!(Matrice3DSparse<float>(4, 4, 4, 1.0f) == Matrice3DSparse<float>(4, 4, 4, 2.0f)));
+    assert(!(Matrice3DSparse<float>(4, 4, 4) == Matrice3DSparse<float>(4, 4, 5)));
+
+    // Move e clear
+    Matrice3DSparse<float> mossa(std::move(copia));
+    assert(copia.size() == 0 && copia.bricks() == 0 && mossa.bricks() == sp.bricks());
+    mossa.clear();
+    assert(mossa.size() == 0 && mossa.materialize().size() == 0);
+
+    // Mattoni di lato 4 e conversione da un layout non contiguo
+    Matrice3D<float, defaultCmp, checkedAccess, alignedAllocator<float>, tiledLayout<8> > td(d);
+    Matrice3DSparse<float, defaultCmp, checkedAccess, 4> s4(td, -1.0f);
+    assert(s4.materialize() == d && s4.slice(3, 9, 29, 40, 44, 49).materialize() == d.slice(3, 9, 29, 40, 44, 49));
+
+    try {
+        csp(Z, 0, 0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Accesso fuori dalla Matrice3DSparse: " << e.what() << std::endl;
+    }
+    try {
+        sp.slice(3, 2, 0, 0, 0, 0);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Slice non valida della Matrice3DSparse: " << e.what() << std::endl;
+    }
+}
+
+void test_fixed() {
+
+    std::cout << "******** Test della Matrice3DFixed ********" << std::endl;
+
+    typedef Matrice3DFixed<float, 3, 3, 3> Blocco;
+    static_assert(Blocco::size() == 27 && Blocco::strideZ() == 9 && Blocco::strideY() == 3, "dimensioni costanti");
+    static_assert(sizeof(Blocco) == 27 * sizeof(float), "elementi interni all'oggetto");
+    static_assert(std::is_trivially_copyable<Blocco>::value, "copia banale");
+    constexpr Matrice3DFixed<int, 2, 2, 2> uni(1);
+    static_assert(uni.at_unchecked(1, 1, 1) == 1 && uni == Matrice3DFixed<int, 2, 2, 2>(1), "espressioni costanti");
+
+    // Nessuna allocazione: costruzione, accesso, copia, trasform e ==
+    std::vector<Blocco> blocchi(1);
+    unsigned int prima = allocazioni;
+    Blocco a;
+    assert(a(2, 2, 2) == 0.0f);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            for (int k = 0; k < 3; k++)
+                a(i, j, k) = float(i * 9 + j * 3 + k);
+    Blocco b = a;
+    blocchi[0] = a;
+    Matrice3DFixed<double, 3, 3, 3> c = trasform<double>(a, [](float v) { return v / 2.0; });
+    assert(a == b && blocchi[0] == a && c(1, 2, 0) == 7.5);
+    b(0, 0, 1) = 100;
+    assert(!(a == b));
+    assert((Matrice3DFixed<int, 3, 3, 3>(a)(2, 1, 0) == 21));
+    std::cout << "Allocazioni eseguite dalla Matrice3DFixed: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 0);
+
+    // Conversione da e verso la Matrice3D dinamica
+    Matrice3D<float> d = a;
+    assert(d.sizeZ() == 3 && d.sizeY() == 3 && d.sizeX() == 3 && d(2, 1, 0) == 21.0f);
+    assert(d == a && a == d && !(d == b));
+    Matrice3D<double> dd(c);
+    assert(dd(1, 2, 0) == 7.5);
+    Matrice3D<float, defaultCmp, checkedAccess, alignedAllocator<float>, tiledLayout<2> > t = a;
+    assert(Blocco(t) == a && Blocco(d) == a);
+    assert(!(Matrice3D<float>(3, 3, 4) == a));
+    Matrice3DFixed<float, 4, 4, 4> q;
+    q.fill(d.begin(), d.end());
+    assert(q(0, 0, 0) == 0.0f && q(1, 2, 2) == 26.0f && q(1, 2, 3) == 0.0f);
+
+    try {
+        a(3, 0, 0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Accesso fuori dalla Matrice3DFixed: " << e.what() << std::endl;
+    }
+    try {
+        Blocco e(Matrice3D<float>(3, 3, 2));
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Conversione con dimensioni diverse: " << e.what() << std::endl;
+    }
+}
+
+/**
+    Controlla permute(A, a0, a1, a2) elemento per elemento
+*/
+template <class T, class M>
+void controlla_permute(const M &A, const Matrice3D<T> &B, const Matrice3DAxis *ax) {
+    unsigned int size[3] = {A.sizeZ(), A.sizeY(), A.sizeX()};
+    assert(B.sizeZ() == size[ax[0]] && B.sizeY() == size[ax[1]] && B.sizeX() == size[ax[2]]);
+    for (unsigned int i = 0; i < B.sizeZ(); i++)
+        for (unsigned int j = 0; j < B.sizeY(); j++)
+            for (unsigned int k = 0; k < B.sizeX(); k++) {
+                unsigned int c[3];
+                c[ax[0]] = i;
+                c[ax[1]] = j;
+                c[ax[2]] = k;
+                assert(B(i, j, k) == A(c[0], c[1], c[2]));
+            }
+}
+
+void test_permute() {
+
+    std::cout << "******** Test della permutazione degli assi ********" << std::endl;
+
+    const Matrice3DAxis perm[6][3] = {
+        {m3dAxisZ, m3dAxisY, m3dAxisX}, {m3dAxisZ, m3dAxisX, m3dAxisY}, {m3dAxisY, m3dAxisZ, m3dAxisX},
+        {m3dAxisY, m3dAxisX, m3dAxisZ}, {m3dAxisX, m3dAxisZ, m3dAxisY}, {m3dAxisX, m3dAxisY, m3dAxisZ}};
+
+    // Dimensioni non multiple delle tile e piani piu' grandi di una foglia della ricorsione
+    Matrice3D<float> f(13, 70, 45);
+    Matrice3D<double> d(9, 21, 38);
+    Matrice3D<short> h(5, 17, 33);
+    for (unsigned int i = 0; i < f.size(); i++)
+        f.data()[i] = float(i);
+    for (unsigned int i = 0; i < d.size(); i++)
+        d.data()[i] = -double(i);
+    for (unsigned int i = 0; i < h.size(); i++)
+        h.data()[i] = short(i % 30000);
+
+    Matrice3DThreadPool pool(3);
+    Matrice3DSimd::Level prima = Matrice3DSimd::level();
+    for (int l = Matrice3DSimd::scalar; l <= Matrice3DSimd::avx512; l++) {
+        Matrice3DSimd::setLevel(Matrice3DSimd::Level(l));
+        for (int p = 0; p < 6; p++) {
+            Matrice3D<float> fp = permute(f, perm[p][0], perm[p][1], perm[p][2]);
+            controlla_permute(f, fp, perm[p]);
+            assert(permute(f, perm[p][0], perm[p][1], perm[p][2], m3dPar(pool)) == fp);
+            controlla_permute(d, permute(d, perm[p][0], perm[p][1], perm[p][2]), perm[p]);
+            controlla_permute(h, permute(h, perm[p][0], perm[p][1], perm[p][2], m3dPar(pool)), perm[p]);
+        }
+    }
+    Matrice3DSimd::setLevel(prima);
+
+    // Trasposta, layout non contiguo, matrice vuota
+    Matrice3D<float> t = transpose(f);
+    assert(t.sizeZ() == 45 && t.sizeY() == 70 && t.sizeX() == 13 && t(44, 3, 12) == f(12, 3, 44));
+    assert(transpose(t, m3dPar(pool)) == f);
+    Matrice3D<float, defaultCmp, checkedAccess, alignedAllocator<float>, tiledLayout<8> > tf(f);
+    assert(permute(tf, m3dAxisX, m3dAxisZ, m3dAxisY) == permute(f, m3dAxisX, m3dAxisZ, m3dAxisY));
+    assert(transpose(Matrice3D<int>()).size() == 0);
+
+    // Vista permutata: nessuna copia, le scritture arrivano alla matrice di origine
+    Matrice3DView<float> v = permuted_view(f, m3dAxisX, m3dAxisZ, m3dAxisY);
+    assert(v.sizeZ() == 45 && v.sizeY() == 13 && v.sizeX() == 70 && v(44, 12, 3) == f(12, 3, 44));
+    v(1, 2, 3) = -1.0f;
+    assert(f(2, 3, 1) == -1.0f);
+    assert(v.materialize() == permute(f, m3dAxisX, m3dAxisZ, m3dAxisY));
+    const Matrice3D<float> &cf = f;
+    Matrice3DView<const float> cv = permuted_view(cf.view(2, 5, 0, 69, 10, 19), m3dAxisY, m3dAxisX, m3dAxisZ);
+    assert(cv.sizeZ() == 70 && cv.sizeY() == 10 && cv.sizeX() == 4 && cv(7, 1, 2) == f(4, 7, 11));
+
+    try {
+        permute(f, m3dAxisX, m3dAxisX, m3dAxisY);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Assi non validi: " << e.what() << std::endl;
+    }
+}
+
+// Tipi per il confronto byte a byte: enum e struct senza riempimento dichiarata con m3dBitwiseEqual
+enum Materiale { aria, acqua, osso };
+
+struct Voxel {
+    int materiale;
+    int densita;
+};
+
+bool operator==(const Voxel &a, const Voxel &b) {
+    return a.materiale == b.materiale && a.densita == b.densita;
+}
+
+template <> struct m3dBitwiseEqual<Voxel> : std::true_type {};
+
+void test_hash() {
+
+    std::cout << "******** Test dell'hash e dell'uguaglianza ********" << std::endl;
+
+    Matrice3DThreadPool pool(3);
+
+    // Matrici uguali hanno lo stesso hash, anche calcolato in parallelo (piu' tratti)
+    Matrice3D<int> a(9, 130, 70), b(9, 130, 70);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = b.data()[i] = int(i * 7 % 1000);
+    std::uint64_t ha = a.hash();
+    assert(ha == b.hash(m3dPar(pool)));
+    assert(a == b && a.equals(b, m3dPar(pool)));
+
+    // Dimensioni diverse con gli stessi elementi: hash diversi
+    Matrice3D<int> c(130, 9, 70);
+    c.fill(a.data(), a.data() + a.size());
+    assert(c.hash() != ha);
+
+    // L'hash segue ogni scrittura; hash diversi escludono l'uguaglianza
+    b(8, 129, 69) = -1;
+    assert(b.hash() != ha && !(a == b) && !a.equals(b, m3dPar(pool)));
+    b(8, 129, 69) = a(8, 129, 69);
+    assert(b.hash() == ha && a == b);
+    b.fill(c.data(), c.data() + 1);
+    assert(b.hash() == ha);
+    Matrice3D<int> d(a);
+    assert(d.hash() == ha);
+    d.swap(c);
+    assert(c.hash() == ha && d.hash() != ha);
+
+    // Scritture con un puntatore ottenuto prima di hash(): == e hash() vedono il
+    // contenuto attuale
+    int *p = a.data();
+    a.hash();
+    b.hash();
+    p[0] = 7;
+    b(0, 0, 0) = 7;
+    assert(a == b && a.equals(b, m3dPar(pool)) && a.hash() == b.hash() && a.hash() != ha);
+
+    // hash() della stessa matrice da piu' thread
+    std::vector<std::uint64_t> hp(8);
+    const Matrice3D<int> &ca = a;
+    m3dForBlocks(m3dPar(pool), hp.size(), 1, [&](std::size_t i, std::size_t e) {
+        for (; i < e; i++)
+            hp[i] = ca.hash();
+    });
+    assert(std::count(hp.begin(), hp.end(), a.hash()) == 8);
+
+    // Floating point: -0 e +0 sono uguali e hanno lo stesso hash
+    Matrice3D<double> z1(2, 3, 4), z2(2, 3, 4);
+    std::fill(z1.begin(), z1.end(), 0.0);
+    std::fill(z2.begin(), z2.end(), -0.0);
+    assert(z1 == z2 && z1.hash() == z2.hash() && z1.hash(m3dPar(pool)) == z2.hash());
+    // long double ha byte di riempimento: niente hash
+    assert(m3dHashable<double>::value && !m3dHashable<long double>::value);
+
+    // Layout a blocchi: il riempimento non cambia l'hash di matrici uguali
+    Matrice3D<float, defaultCmp, checkedAccess, alignedAllocator<float>, tiledLayout<4> > t1(5, 11, 13), t2(5, 11, 13);
+    t1(4, 10, 12) = t2(4, 10, 12) = 3.5f;
+    assert(t1.hash() == t2.hash() && t1 == t2);
+
+    // Confronto byte a byte (memcmp) per enum e tipi dichiarati con m3dBitwiseEqual
+    Matrice3D<Materiale> m1(4, 5, 6), m2(4, 5, 6);
+    std::fill(m1.begin(), m1.end(), aria);
+    std::fill(m2.begin(), m2.end(), acqua);
+    assert(!(m1 == m2));
+    std::fill(m2.begin(), m2.end(), aria);
+    m1(3, 4, 5) = osso;
+    assert(!(m1 == m2) && m1.hash() != m2.hash());
+    m2(3, 4, 5) = osso;
+    assert(m1 == m2 && m1.equals(m2, m3dPar(pool)) && m1.hash() == m2.hash());
+
+    Matrice3D<Voxel> v1(3, 40, 600), v2(3, 40, 600);
+    std::fill(v1.begin(), v1.end(), Voxel{1, 0});
+    std::fill(v2.begin(), v2.end(), Voxel{1, 0});
+    v1(2, 39, 599).densita = 5;
+    assert(!(v1 == v2) && !v1.equals(v2, m3dPar(pool)));
+    v2(2, 39, 599).densita = 5;
+    assert(v1 == v2 && v1.equals(v2, m3dPar(pool)) && v1.hash() == v2.hash(m3dPar(pool)));
+
+    // Uscita anticipata del confronto parallelo: una differenza in ogni posizione
+    // (inizio, tratti intermedi, fine) viene sempre trovata
+    Matrice3D<float> f1(16, 128, 128), f2(16, 128, 128);
+    std::fill(f1.begin(), f1.end(), 0.0f);
+    std::fill(f2.begin(), f2.end(), 0.0f);
+    const std::size_t posizioni[4] = {0, 65536, 123457, f1.size() - 1};
+    for (std::size_t pos : posizioni) {
+        f2.data()[pos] = 1.0f;
+        assert(!f1.equals(f2, m3dPar(pool)));
+        f2.data()[pos] = 0.0f;
+    }
+    assert(f1.equals(f2, m3dPar(pool)));
+
+    std::cout << "Hash: " << std::hex << ha << std::dec << std::endl;
+}
+
+/**
+    @brief Test delle copie in blocco dei tipi banalmente copiabili (copia, conversione
+           tra politiche diverse e fill, anche con sorgente sovrapposta)
+
+*/
+void test_copia() {
+
+    std::cout << "******** Test delle copie in blocco ********" << std::endl;
+
+    // Tipo banalmente copiabile non aritmetico: copia con memcpy
+    Matrice3D<Voxel> c1(3, 4, 5);
+    for (unsigned int i = 0; i < c1.size(); i++)
+        c1.data()[i] = Voxel{int(i), int(2 * i)};
+    Matrice3D<Voxel> c2(c1);
+    assert(c2 == c1 && c2(2, 3, 4).materiale == 59 && c2(2, 3, 4).densita == 118);
+
+    // Conversione verso politiche diverse con lo stesso tipo
+    Matrice3D<int> a(4, 6, 7);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = int(i);
+    Matrice3D<int, defaultCmp, uncheckedAccess> u(a);
+    assert(u.size() == a.size() && u(3, 5, 6) == a(3, 5, 6));
+
+    // fill con sorgente sovrapposta: stesso risultato di una copia tramite buffer
+    std::vector<int> atteso(a.data() + 10, a.data() + a.size());
+    a.fill(a.data() + 10, a.data() + a.size());
+    assert(std::equal(atteso.begin(), atteso.end(), a.data()));
+    assert(a(3, 5, 6) == int(a.size() - 1));
+
+    Matrice3DThreadPool pool(3);
+    Matrice3D<int> b(40, 30, 20);
+    for (unsigned int i = 0; i < b.size(); i++)
+        b.data()[i] = int(i);
+    b.fill(b.data() + 1, b.data() + b.size(), m3dPar(pool));
+    for (unsigned int i = 0; i + 1 < b.size(); i++)
+        assert(b.data()[i] == int(i + 1));
+    std::vector<int> sorgente(b.size(), -3);
+    b.fill(sorgente.data(), sorgente.data() + sorgente.size(), m3dPar(pool));
+    assert(b(39, 29, 19) == -3 && b(0, 0, 0) == -3);
+
+    // Tipo con copia non banale: costruzione per copia elemento per elemento
+    Contatore::costruzioni = 0;
+    Matrice3D<Contatore> k1(2, 2, 2);
+    Matrice3D<Contatore> k2(k1);
+    assert(Contatore::costruzioni == 16);
+}
+
+/**
+    @brief Test della strumentazione delle operazioni (MATRICE3D_STATS)
+
+*/
+void test_statistiche() {
+
+    std::cout << "******** Test della strumentazione ********" << std::endl;
+
+    Matrice3DStats::reset();
+    Matrice3D<int> a(2, 3, 4);
+    std::fill(a.begin(), a.end(), 1);
+    assert(Matrice3DStats::get(m3dOpAlloc).count == 1 && Matrice3DStats::get(m3dOpAlloc).bytes == 24 * sizeof(int));
+
+    // L'assegnamento conta anche la copia profonda che esegue
+    Matrice3D<int> b(a), c;
+    c = a;
+    assert(Matrice3DStats::get(m3dOpCopy).count == 2 && Matrice3DStats::get(m3dOpAssign).count == 1);
+    assert(Matrice3DStats::get(m3dOpAlloc).count == 3);
+
+    Matrice3D<int> s = a.slice(0, 1, 1, 2, 0, 0);
+    Matrice3D<double> d(a);
+    assert(Matrice3DStats::get(m3dOpSlice).count == 1 && Matrice3DStats::get(m3dOpSlice).bytes == 4 * sizeof(int));
+    assert(Matrice3DStats::get(m3dOpConvert).count == 1 && Matrice3DStats::get(m3dOpConvert).bytes == 24 * sizeof(int));
+
+    assert(a == b);
+    a.hash();
+    Matrice3D<int> t = trasform<int>(a, intAdd());
+    b.fill(t.data(), t.data() + t.size());
+    assert(Matrice3DStats::get(m3dOpEqual).count == 1 && Matrice3DStats::get(m3dOpHash).count == 1);
+    assert(Matrice3DStats::get(m3dOpTrasform).count == 1 && Matrice3DStats::get(m3dOpFill).count == 1);
+
+    try {
+        a(2, 0, 0) = 0;
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        assert(Matrice3DStats::get(m3dOpOutOfRange).count == 1);
+    }
+
+    // I contatori dei thread terminati restano nel totale
+    std::thread th([] {
+        Matrice3D<char> m(4, 4, 4);
+        Matrice3D<char> n(m);
+        (void)n;
+    });
+    th.join();
+    assert(Matrice3DStats::get(m3dOpCopy).count == 3 && Matrice3DStats::get(m3dOpAlloc).count == 8);
+
+    std::string json = Matrice3DStats::json();
+    std::cout << json << std::endl;
+    assert(json.find("\"slice\": {\"count\": 1, \"bytes\": 16") != std::string::npos);
+    assert(json.find("\"out_of_range\": {\"count\": 1") != std::string::npos);
+
+    Matrice3DStats::reset();
+    assert(Matrice3DStats::get(m3dOpCopy).count == 0 && Matrice3DStats::get(m3dOpAlloc).bytes == 0);
+}
+
+/**
+    @brief Test della Matrice3DCow (buffer condiviso copy-on-write)
+
+*/
+void test_cow() {
+
+    std::cout << "******** Test della Matrice3DCow ********" << std::endl;
+
+    Matrice3DCow<int> a(4, 5, 6);
+    std::vector<int> v(a.size());
+    for (unsigned int i = 0; i < v.size(); i++)
+        v[i] = int(i);
+    a.fill(v.begin(), v.end());
+
+    // La copia condivide il buffer senza allocare, e la lettura non copia
+    unsigned int prima = allocazioni;
+    Matrice3DCow<int> b(a);
+    const Matrice3DCow<int> &cb = b;
+    int somma = 0;
+    for (Matrice3DCow<int>::const_iterator it = b.cbegin(); it != b.cend(); ++it)
+        somma += *it;
+    for (int x : cb)
+        somma += x;
+    somma += cb(3, 4, 5);
+    assert(allocazioni - prima == 0);
+    somma += *b.slice(0, 0, 0, 0, 0, 0).begin();
+    assert(somma == 2 * 119 * 60 + 119 && b.shared() && a.use_count() == 2 && cb.data() != nullptr);
+    assert(a.matrix().data() == cb.data() && a == b);
+
+    // La prima scrittura stacca la copia, le successive no
+    b(0, 0, 0) = -1;
+    assert(!a.shared() && !b.shared() && a(0, 0, 0) == 0 && b(0, 0, 0) == -1 && !(a == b));
+    const int *buffer = cb.data();
+    b(1, 1, 1) = -2;
+    *b.begin() = -3;
+    assert(cb.data() == buffer && a(1, 1, 1) == 37 && b(0, 0, 0) == -3);
+
+    // fill, begin() non costante e matrix_mut() staccano il buffer
+    Matrice3DCow<int> c(a), d(a), e(a);
+    c.fill(v.rbegin(), v.rend());
+    *d.begin() = 7;
+    e.matrix_mut()(3, 4, 5) = 8;
+    assert(a.use_count() == 1 && a(0, 0, 0) == 0 && a(3, 4, 5) == 119);
+    assert(c(0, 0, 0) == 119 && d(0, 0, 0) == 7 && e(3, 4, 5) == 8);
+
+    // swap scambia i buffer: la scrittura su a stacca a dal buffer condiviso con f
+    Matrice3DCow<int> f(c);
+    a.swap(f);
+    assert(a.use_count() == 2 && a(0, 0, 0) == 119 && f(0, 0, 0) == 0);
+    a(0, 0, 0) = 1;
+    assert(c(0, 0, 0) == 119 && !c.shared());
+
+    // Spostamento e assegnamento
+    Matrice3DCow<int> g(std::move(f));
+    assert(f.size() == 0 && g(3, 4, 5) == 119);
+    f = g;
+    assert(g.shared() && f(3, 4, 5) == 119);
+    Matrice3DCow<int> vuota;
+    f = vuota;
+    assert(f.size() == 0 && !g.shared());
+
+    // Copie e scritture concorrenti su oggetti che condividono lo stesso buffer
+    const Matrice3DCow<int> sorgente(g);
+    std::vector<std::thread> th;
+    std::atomic<int> errori(0);
+    for (int t = 0; t < 4; t++)
+        th.emplace_back([&, t] {
+            for (int r = 0; r < 50; r++) {
+                Matrice3DCow<int> copia(sorgente);
+                if (copia(3, 4, 5) != 119)
+                    errori++;
+                copia(0, 0, 0) = t;
+                if (copia(0, 0, 0) != t || copia(3, 4, 5) != 119)
+                    errori++;
+            }
+        });
+    for (std::thread &x : th)
+        x.join();
+    assert(errori == 0 && sorgente(0, 0, 0) == 0 && sorgente.use_count() == 2);
+}
+
+/**
+    @brief Test della Matrice3DCompressed (blocchi codificati e cache di blocchi decodificati)
+
+*/
+void test_compressed() {
+
+    std::cout << "******** Test della Matrice3DCompressed ********" << std::endl;
+
+    // Volume di etichette: sfondo e due sfere
+    Matrice3D<unsigned char> etichette(40, 50, 60);
+    for (int z = 0; z < 40; z++)
+        for (int y = 0; y < 50; y++)
+            for (int x = 0; x < 60; x++) {
+                int d1 = (z - 20) * (z - 20) + (y - 25) * (y - 25) + (x - 20) * (x - 20);
+                int d2 = (z - 15) * (z - 15) + (y - 20) * (y - 20) + (x - 45) * (x - 45);
+                etichette(z, y, x) = d1 < 100 ? 1 : (d2 < 64 ? 2 : 0);
+            }
+    Matrice3DCompressed<unsigned char> c(etichette, 2);
+    std::cout << "Byte compressi: " << c.compressed_bytes() << " su " << etichette.size()
+              << " (memoria con la cache: " << c.memory() << ")" << std::endl;
+    assert(c.compressed_bytes() * 5 < etichette.size());
+    assert(c.codec(0) == m3dCodecConst && c.materialize() == etichette);
+
+    // Iterazione: ogni blocco decodificato una sola volta
+    unsigned long prima = c.decodes(), somma = 0, attesa = 0;
+    for (unsigned char v : c)
+        somma += v;
+    for (unsigned char v : etichette)
+        attesa += v;
+    assert(somma == attesa && c.decodes() - prima == c.blocks());
+
+    // Scritture: ricodificate all'uscita dalla cache o con flush()
+    const Matrice3DCompressed<unsigned char> &cc = c;
+    for (int z = 0; z < 40; z += 7) {
+        c(z, 3, 5) = 9;
+        etichette(z, 3, 5) = 9;
+    }
+    c.flush();
+    assert(cc(35, 3, 5) == 9 && cc(20, 25, 20) == 1 && cc(15, 20, 45) == 2 && c.materialize() == etichette);
+    assert(c.slice(10, 30, 5, 45, 7, 59) == etichette.slice(10, 30, 5, 45, 7, 59));
+
+    // Scrittura con l'iteratore alternata ad altri accessi e a flush(): l'iteratore
+    // ricarica il blocco e lo segna di nuovo come modificato
+    Matrice3DCompressed<unsigned char>::iterator w = c.begin();
+    *w = 3;
+    assert(cc(39, 49, 59) == etichette(39, 49, 59));
+    ++w;
+    *w = 4;
+    c.flush();
+    ++w;
+    *w = 5;
+    for (int z = 0; z < 40; z++)
+        cc(z, 0, 0);
+    etichette(0, 0, 0) = 3;
+    etichette(0, 0, 1) = 4;
+    etichette(0, 0, 2) = 5;
+    assert(c.materialize() == etichette);
+
+    // Letture da una matrice non costante (operator() e iteratori): nessun blocco
+    // viene segnato come modificato, quindi flush() non ricodifica nulla
+    Matrice3DCompressed<int> r(64, 64, 64, 1, 2);
+    r.flush();
+    unsigned long ricodificati = r.encodes();
+    long long letti = 0;
+    for (int v : r)
+        letti += v;
+    for (int z = 0; z < 64; z += 9)
+        letti += r(z, 63 - z, z);
+    r.flush();
+    assert(letti == 64 * 64 * 64 + 8 && r.encodes() == ricodificati);
+    // block() su una matrice costante e' in sola lettura e non segna il blocco
+    const Matrice3DCompressed<int> &cr = r;
+    assert((std::is_same<decltype(cr.block(0)), const int *>::value) && cr.block(5)[7] == 1);
+    r.flush();
+    assert(r.encodes() == ricodificati);
+    r(20, 15, 11) = r(20, 15, 11);
+    *r.begin() += 1;
+    r.flush();
+    assert(r.encodes() == ricodificati + 2 && r(0, 0, 0) == 2);
+
+    // Copia ed ==: i blocchi con la stessa codifica non vengono decodificati
+    Matrice3DCompressed<unsigned char> d(c);
+    assert(d == c);
+    d(39, 49, 59) = 7;
+    assert(!(d == c));
+
+    // trasform a blocchi, sequenziale e parallela
+    Matrice3DThreadPool pool(3);
+    Matrice3DCompressed<int> t = trasform<int>(c, intAdd());
+    Matrice3DCompressed<int> tp = trasform<int>(c, intAdd(), m3dPar(pool));
+    Matrice3D<int> td = trasform<int>(etichette, intAdd());
+    assert(t.materialize() == td && tp == t);
+
+    // Tutte le codifiche, con interi con segno a 64 bit e blocchi piu' corti alla fine
+    Matrice3D<long long> v(3, 5, 7);
+    for (unsigned int i = 0; i < v.size(); i++)
+        v.data()[i] = i < 16 ? -5 : (i < 32 ? -1000000000000LL + (i * i * 31) % 41 :
+                                         (long long)(std::uint64_t(i) * 0x9E3779B97F4A7C15ULL));
+    Matrice3DCompressed<long long, defaultCmp, checkedAccess, 16> lv(v);
+    assert(lv.codec(0) == m3dCodecConst && lv.codec(1) == m3dCodecPacked && lv.codec(6) == m3dCodecRaw);
+    assert(lv.materialize() == v && lv.blocks() == 7);
+    std::vector<long long> gradiente(16);
+    for (int i = 0; i < 16; i++)
+        gradiente[i] = 1000000000000000LL - i * 12345 + i % 3;
+    lv.write_block(2, gradiente.data());
+    assert(lv.codec(2) == m3dCodecDelta && lv(0, 4, 4) == gradiente[0] && lv(1, 1, 5) == gradiente[15]);
+    std::vector<long long> sequenze(16, 4);
+    sequenze[15] = -4000000000000000LL;
+    lv.write_block(3, sequenze.data());
+    assert(lv.codec(3) == m3dCodecRle && lv(1, 1, 6) == 4 && lv(1, 4, 0) == sequenze[15]);
+
+    // Floating point: codifica dei bit, confronto con ==
+    Matrice3D<float> f(2, 30, 30);
+    for (unsigned int i = 0; i < f.size(); i++)
+        f.data()[i] = i < 900 ? 0.5f : float(i) / 7;
+    Matrice3DCompressed<float, defaultCmp, checkedAccess, 512> fc(f);
+    assert(fc.codec(0) == m3dCodecConst && fc.materialize() == f);
+
+    try {
+        cc(40, 0, 0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Coordinate non valide: " << e.what() << std::endl;
+    }
+}
+
+void test_pyramid() {
+
+    std::cout << "******** Test della Matrice3DPyramid ********" << std::endl;
+
+    // Dimensioni dispari: finestre incomplete sul bordo
+    Matrice3D<float> a(5, 6, 7);
+    for (unsigned int i = 0; i < a.size(); i++)
+        a.data()[i] = float((i * 37) % 101);
+    Matrice3DPyramid<float> p(a);
+    assert(p.levels() == 4 && p.base() == a);
+    assert(p.level(1).sizeZ() == 3 && p.level(1).sizeY() == 3 && p.level(1).sizeX() == 4);
+    assert(p.level(3).size() == 1);
+
+    // Ogni elemento e' la media della finestra del livello precedente (solo elementi presenti)
+    for (unsigned int l = 1; l < p.levels(); l++) {
+        const Matrice3D<float> &f = p.level(l - 1), &c = p.level(l);
+        for (int z = 0; z < (int)c.sizeZ(); z++)
+            for (int y = 0; y < (int)c.sizeY(); y++)
+                for (int x = 0; x < (int)c.sizeX(); x++) {
+                    Matrice3D<float> w = f.slice(2 * z, std::min(2 * z + 1, (int)f.sizeZ() - 1), 2 * y,
+                                                 std::min(2 * y + 1, (int)f.sizeY() - 1), 2 * x,
+                                                 std::min(2 * x + 1, (int)f.sizeX() - 1));
+                    assert(std::fabs(c(z, y, x) - mean(w)) < 1e-4f);
+                }
+    }
+
+    // Massimo e parallelo: stesso risultato della versione sequenziale
+    Matrice3DThreadPool pool(3);
+    Matrice3D<int> b(9, 4, 5);
+    for (unsigned int i = 0; i < b.size(); i++)
+        b.data()[i] = int((i * 7919) % 1000) - 500;
+    Matrice3DPyramid<int> pm(b, m3dFilterMax);
+    assert(pm.level(1)(4, 1, 2) == maximum(b.slice(8, 8, 2, 3, 4, 4)));
+    assert(pm.level(pm.levels() - 1)(0, 0, 0) == maximum(b));
+    assert(Matrice3DPyramid<int>(b, m3dFilterMax, 0, m3dPar(pool)) == pm);
+    assert(Matrice3DPyramid<int>(b, m3dFilterMean, 2).levels() == 2);
+
+    // Moda per le etichette: a parita' vince il primo valore della finestra
+    Matrice3D<unsigned char> e(2, 2, 4);
+    unsigned char valori[] = {1, 2, 3, 3, 1, 2, 5, 5, 2, 1, 3, 5, 2, 1, 3, 5};
+    e.fill(valori, valori + 16);
+    Matrice3DPyramid<unsigned char> pe(e, m3dFilterMode);
+    assert(pe.level(1)(0, 0, 0) == 1 && pe.level(1)(0, 0, 1) == 3);
+
+    // Tipi custom: moda con il funtore di confronto, media non disponibile
+    Matrice3D<Voxel> vox(2, 2, 2);
+    Voxel osso_v = {osso, 1900}, acqua_v = {acqua, 1000};
+    for (Voxel &v : vox)
+        v = osso_v;
+    vox(1, 1, 1) = acqua_v;
+    assert(Matrice3DPyramid<Voxel>(vox, m3dFilterMode).level(1)(0, 0, 0) == osso_v);
+    try {
+        Matrice3DPyramid<Voxel> pv(vox, m3dFilterMean);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &ex){
+        std::cout << "Filtro non valido: " << ex.what() << std::endl;
+    }
+
+    // Livello di dettaglio: coordinate del livello 0
+    assert(p.lod(1, 4, 5, 6) == p.level(1)(2, 2, 3) && p.lod(3, 4, 5, 6) == p.level(3)(0, 0, 0));
+    assert(p.slice(2, 0, 4, 0, 5, 0, 6) == p.level(2) && p.slice(1, 2, 3, 0, 1, 4, 6).size() == 2);
+    assert(p.level_for(30) == 2 && p.level_for(1000) == 0 && p.level_for(0) == 3);
+
+    // Aggiornamento incrementale: uguale alla piramide ricostruita da capo
+    Matrice3D<float> sub(2, 2, 3);
+    for (float &v : sub)
+        v = 100.0f;
+    p.update(sub, 3, 4, 4, m3dPar(pool));
+    for (int z = 0; z < 2; z++)
+        for (int y = 0; y < 2; y++)
+            for (int x = 0; x < 3; x++)
+                a(3 + z, 4 + y, 4 + x) = 100.0f;
+    assert(p == Matrice3DPyramid<float>(a));
+
+    try {
+        p.update(sub, 4, 0, 0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &ex){
+        std::cout << "Sotto-volume non valido: " << ex.what() << std::endl;
+    }
+    try {
+        p.level(4);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &ex){
+        std::cout << "Livello non valido: " << ex.what() << std::endl;
+    }
+}
+
+void test_assi() {
+
+    std::cout << "******** Test di righe, colonne, pilastri e piani ********" << std::endl;
+
+    Matrice3D<int> m(3, 4, 5);
+    for (unsigned int i = 0; i < m.size(); i++)
+        m.data()[i] = (int)i;
+    const Matrice3D<int> &cm = m;
+
+    // Riga contigua: iteratori T* e algoritmi standard
+    Matrice3D<int>::row_range r = m.row(1, 2);
+    assert(r.size() == 5 && r[0] == m(1, 2, 0) && r.back() == m(1, 2, 4));
+    assert(std::accumulate(r.begin(), r.end(), 0) == 5 * m(1, 2, 2));
+    std::reverse(r.begin(), r.end());
+    assert(m(1, 2, 0) == 34 && m(1, 2, 4) == 30);
+    std::reverse(r.begin(), r.end());
+
+    // Colonna e pilastro: iteratori random access con passo
+    Matrice3D<int>::const_axis_range c = cm.col(2, 3);
+    assert(c.size() == 4 && c.end() - c.begin() == 4 && c.begin()[2] == m(2, 2, 3));
+    assert(*(c.end() - 1) == m(2, 3, 3) && c.begin() < c.end() && c.end() >= c.begin());
+    Matrice3D<int>::axis_range p = m.pillar(1, 4);
+    std::vector<int> valori(p.begin(), p.end());
+    assert(valori.size() == 3 && valori[0] == m(0, 1, 4) && valori[2] == m(2, 1, 4));
+    std::sort(p.begin(), p.end(), std::greater<int>());
+    assert(m(0, 1, 4) == valori[2] && m(2, 1, 4) == valori[0]);
+    std::fill(m.col(0, 0).begin(), m.col(0, 0).end(), -1);
+    assert(m(0, 0, 0) == -1 && m(0, 3, 0) == -1 && m(0, 0, 1) == 1);
+    Matrice3D<int>::const_axis_range pc = m.pillar(1, 4);
+    assert(std::is_sorted(pc.begin(), pc.end(), std::greater<int>()));
+
+    // Iterazione all'indietro sull'ultimo pilastro: end() e la posizione prima del primo
+    // elemento restano indici, senza puntatori fuori dal buffer
+    Matrice3D<int>::const_axis_range ultimo = cm.pillar(3, 4);
+    std::vector<int> indietro(std::make_reverse_iterator(ultimo.end()), std::make_reverse_iterator(ultimo.begin()));
+    assert(indietro.size() == 3 && indietro[0] == m(2, 3, 4) && indietro[2] == m(0, 3, 4));
+    Matrice3D<int>::const_axis_range::iterator prima = ultimo.begin() - 1;
+    assert(prima.index() == -1 && ultimo.end() - prima == 4 && *(prima + 1) == m(0, 3, 4));
+
+    // fill() da un intervallo con passo, sequenziale e parallelo
+    Matrice3DThreadPool pool(2);
+    Matrice3D<int> d(1, 1, 4), dp(1, 1, 4);
+    Matrice3D<int>::const_axis_range cc = cm.col(1, 2);
+    d.fill(cc.begin(), cc.end());
+    dp.fill(cc.begin(), cc.end(), m3dPar(pool));
+    assert(d(0, 0, 3) == m(1, 3, 2) && dp == d);
+
+    // Piani: viste con dimensione 1 lungo l'asse fissato
+    Matrice3DView<int> pz = m.plane(2), py = m.plane_y(1), px = m.plane_x(4);
+    assert(pz.sizeZ() == 1 && pz.size() == 20 && pz(0, 3, 4) == m(2, 3, 4));
+    assert(py.sizeY() == 1 && py(2, 0, 3) == m(2, 1, 3));
+    std::fill(px.begin(), px.end(), 7);
+    assert(m(0, 0, 4) == 7 && m(2, 3, 4) == 7 && m(2, 3, 3) != 7);
+    assert(cm.plane(1).row(0, 2)[4] == m(1, 2, 4) && px.col(1, 0)[3] == 7 && pz.row(0, 1).size() == 5);
+    assert(py.pillar(0, 2).size() == 3 && py.pillar(0, 2)[1] == m(1, 1, 2));
+
+    // Le scritture attraverso gli intervalli cambiano l'hash
+    std::uint64_t h = m.hash();
+    m.row(0, 0)[0] = 100;
+    assert(m.hash() != h);
+
+    try {
+        m.pillar(4, 0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Pilastro non valido: " << e.what() << std::endl;
+    }
+}
+
+void test_grandi_volumi() {
+
+    std::cout << "******** Test dei volumi oltre 2^32 elementi ********" << std::endl;
+
+    // 2048 x 2048 x 1024 = 2^32: in unsigned int il prodotto varrebbe 0
+    assert(m3dVolume(2048, 2048, 1024) == (std::size_t(1) << 32));
+    try {
+        m3dVolume(std::size_t(1) << 22, std::size_t(1) << 21, std::size_t(1) << 21);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Volume non rappresentabile: " << e.what() << std::endl;
+    }
+
+    // Il costruttore rifiuta i volumi oltre max_size() dell'allocatore prima di allocare
+    try {
+        Matrice3D<char> m(1 << 30, 1 << 30, 1 << 30);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Matrice troppo grande: " << e.what() << std::endl;
+    }
+    try {
+        // Volume di circa 2^58 elementi, ma il Morton arrotonda il buffer a 2^60
+        Matrice3D<double, defaultCmp, checkedAccess, alignedAllocator<double>, mortonLayout> m((1 << 20) + 1, (1 << 20) + 1, 1 << 18);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Layout troppo grande: " << e.what() << std::endl;
+    }
+
+    // Vista con stride nulli: size() e coordinate oltre 2^32 senza memoria
+    unsigned char cella = 9;
+    Matrice3DView<unsigned char> v(&cella, 2048, 2048, 1025, 0, 0, 0);
+    assert(v.size() == std::size_t(2048) * 2048 * 1025);
+    assert(v(2047, 2047, 1024) == 9);
+
+    // Volume reale di 1025 x 2048 x 2048 byte (4 GiB + 4 MiB): vengono toccate poche
+    // pagine, ma senza memoria virtuale sufficiente il test viene saltato
+    try {
+        Matrice3D<unsigned char> m(1025, 2048, 2048);
+        std::size_t n = std::size_t(1025) * 2048 * 2048;
+        assert(m.size() == n && m.strideZ() == std::size_t(1) << 22);
+        m(0, 0, 0) = 1;
+        m(1024, 0, 0) = 7; // posizione 2^32
+        m(1024, 2047, 2047) = 42; // ultimo elemento
+        assert(m(0, 0, 0) == 1 && m.data()[std::size_t(1) << 32] == 7);
+        assert(&m(1024, 2047, 2047) - m.data() == std::ptrdiff_t(n - 1));
+        assert(*(m.end() - 1) == 42 && m.pillar(2047, 2047)[1024] == 42);
+        assert(m.row(1024, 2047).back() == 42 && m.plane(1024)(0, 2047, 2047) == 42);
+        Matrice3DView<unsigned char> coda = m.view(1024, 1024, 2047, 2047, 2040, 2047);
+        assert(coda.size() == 8 && *std::max_element(coda.begin(), coda.end()) == 42);
+        std::cout << "Volume di " << m.size() << " elementi" << std::endl;
+    }
+    catch(std::bad_alloc &){
+        std::cout << "Memoria insufficiente per il volume da 4 GiB: test saltato" << std::endl;
+    }
+}
+
+void test_trasform_multipli() {
+
+    std::cout << "******** Test di trasform in place e a piu' ingressi ********" << std::endl;
+
+    Matrice3D<int> a(3, 4, 5), b(3, 4, 5);
+    Matrice3D<float> f(3, 4, 5);
+    for (unsigned int i = 0; i < a.size(); i++) {
+        a.data()[i] = (int)i - 20;
+        b.data()[i] = (int)(i % 7);
+        f.data()[i] = 0.5f * (float)i;
+    }
+    Matrice3DThreadPool pool(2);
+
+    // Due e tre ingressi di tipi diversi, in un unico passaggio
+    Matrice3D<int> c = trasform<int>(a, b, [](int x, int y) { return x * y; });
+    Matrice3D<double> d = trasform<double>(a, b, f, [](int x, int y, float z) { return x + y * (double)z; });
+    assert(c(2, 3, 4) == a(2, 3, 4) * b(2, 3, 4) && c(0, 1, 2) == a(0, 1, 2) * b(0, 1, 2));
+    assert(d(1, 2, 3) == a(1, 2, 3) + b(1, 2, 3) * (double)f(1, 2, 3));
+    assert(trasform<int>(a, b, [](int x, int y) { return x * y; }, m3dPar(pool)) == c);
+
+    // Dimensioni controllate una volta sola
+    try {
+        trasform<int>(a, Matrice3D<int>(3, 5, 4), [](int x, int y) { return x + y; });
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Dimensioni diverse: " << e.what() << std::endl;
+    }
+
+    // Matrice di uscita riusata: nessuna allocazione a ogni fotogramma
+    Matrice3D<int> out(3, 4, 5);
+    unsigned int prima = allocazioni;
+    for (int frame = 0; frame < 3; frame++) {
+        trasform(a, b, [frame](int x, int y) { return x - y + frame; }, out);
+        trasform(a, b, f, [](int x, int y, float z) { return x + y + (int)z; }, out, m3dSeq);
+        trasform(a, [](int x) { return 2 * x; }, out);
+    }
+    std::cout << "Allocazioni con la matrice di uscita: " << (allocazioni - prima) << std::endl;
+    assert(allocazioni - prima == 0 && out(2, 3, 4) == 2 * a(2, 3, 4));
+    // Con dimensioni diverse la matrice di uscita viene riallocata una volta
+    Matrice3D<int> piccola(1, 1, 1);
+    trasform(a, b, [](int x, int y) { return x * y; }, piccola, m3dPar(pool));
+    assert(piccola == c);
+
+    // In place: stesso buffer, anche con i funtori vettoriali e in parallelo
+    Matrice3D<float> g(f), gp(f);
+    const float *buffer = g.data();
+    prima = allocazioni;
+    trasform_inplace(g, m3dClamp<float>(2.0f, 20.0f));
+    assert(allocazioni - prima == 0 && g.data() == buffer);
+    trasform_inplace(gp, m3dClamp<float>(2.0f, 20.0f), m3dPar(pool));
+    assert(g == gp);
+    assert(g == trasform<float>(f, m3dClamp<float>(2.0f, 20.0f)));
+    std::uint64_t h = g.hash();
+    trasform_inplace(g, [](float v) { return v + 1.0f; });
+    assert(g.hash() != h && g(0, 0, 0) == 3.0f);
+
+    // La matrice di uscita puo' coincidere con un ingresso
+    Matrice3D<int> s(a);
+    trasform(s, b, [](int x, int y) { return x * y; }, s);
+    assert(s == c);
+
+    // Tipo degli elementi esplicito, come per le versioni che ritornano la matrice
+    Matrice3D<int> e(3, 4, 5);
+    trasform<int>(a, [](int x) { return x + 1; }, e);
+    assert(e(1, 2, 3) == a(1, 2, 3) + 1);
+    trasform<int>(a, [](int x) { return x - 1; }, e, m3dPar(pool));
+    assert(e(1, 2, 3) == a(1, 2, 3) - 1);
+    trasform<int>(a, b, [](int x, int y) { return x * y; }, e, m3dSeq);
+    assert(e == c);
+    trasform<int>(a, b, f, [](int x, int y, float z) { return x + y + (int)z; }, e);
+    assert(e(2, 0, 1) == a(2, 0, 1) + b(2, 0, 1) + (int)f(2, 0, 1));
+    trasform_inplace<int>(e, [](int x) { return 2 * x; }, m3dPar(pool));
+    trasform_inplace<int>(e, [](int x) { return x / 2; });
+    assert(e(2, 0, 1) == a(2, 0, 1) + b(2, 0, 1) + (int)f(2, 0, 1));
+
+    // Layout non contigui: ciclo sulle coordinate, stesso risultato
+    typedef Matrice3D<int, defaultCmp, checkedAccess, alignedAllocator<int>, tiledLayout<4> > Tiled;
+    Tiled t(a), to(1, 1, 1);
+    trasform(t, b, [](int x, int y) { return x * y; }, to);
+    assert(Matrice3D<int>(to) == c && trasform<int>(t, b, [](int x, int y) { return x * y; }) == c);
+    trasform_inplace(t, [](int x) { return -x; });
+    assert(t(2, 3, 4) == -a(2, 3, 4) && t == Tiled(trasform<int>(a, [](int x) { return -x; })));
+
+    // N ingressi passati come tupla: quattro e cinque matrici in un unico passaggio
+    Matrice3D<int> q(a);
+    trasform_inplace(q, [](int x) { return x % 5; });
+    auto quattro = [](int x, int y, float z, int w) { return x + y * w + (int)z; };
+    Matrice3D<int> r4 = trasform<int>(std::tie(a, b, f, q), quattro);
+    assert(r4(2, 3, 4) == quattro(a(2, 3, 4), b(2, 3, 4), f(2, 3, 4), q(2, 3, 4)));
+    assert(r4(0, 1, 2) == quattro(a(0, 1, 2), b(0, 1, 2), f(0, 1, 2), q(0, 1, 2)));
+    assert(trasform<int>(std::tie(a, b, f, q), quattro, m3dPar(pool)) == r4);
+    prima = allocazioni;
+    trasform<int>(std::tie(a, b, f, q, c), [](int x, int y, float z, int w, int v) { return x - y + (int)z + w - v; }, e);
+    assert(allocazioni - prima == 0);
+    assert(e(1, 2, 3) == a(1, 2, 3) - b(1, 2, 3) + (int)f(1, 2, 3) + q(1, 2, 3) - c(1, 2, 3));
+    trasform(std::tie(a, b), [](int x, int y) { return x * y; }, e, m3dPar(pool));
+    assert(e == c);
+    try {
+        trasform<int>(std::forward_as_tuple(a, b, f, Matrice3D<int>(3, 4, 4)), quattro);
+        assert(false);
+    }
+    catch(Matrice3DInvalidParameters &e){
+        std::cout << "Dimensioni diverse con quattro ingressi: " << e.what() << std::endl;
+    }
+
+    // Ingressi vuoti: risultato vuoto
+    Matrice3D<int> vuota;
+    assert(trasform<int>(vuota, vuota, [](int x, int y) { return x + y; }).size() == 0);
+}
+
 void test_slice() {
 
     std::cout << "******** Test d'uso della Matrice3D di interi con il metodo slice ********" << std::endl;
@@ -343,6 +2410,62 @@ void test_slice() {
     std::cout << std::endl;
 }
 
+/**
+    @brief Test delle viste (Matrice3DView) su una Matrice3D di interi
+
+*/
+void test_view() {
+
+    std::cout << "******** Test d'uso della Matrice3DView (slice senza copia) ********" << std::endl;
+
+    int a[18] = {1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18}; // Dati per riempire la matrice
+
+    Matrice3D<int> m1(3,3,2);
+    m1.fill(a,a+18);
+
+    // La creazione di una vista non alloca memoria
+    unsigned int prima = allocazioni;
+    Matrice3DView<int> v1 = m1.view(1,2,0,2,0,1); // Stesso intervallo di test_slice
+    assert(allocazioni - prima == 0);
+    assert(v1.sizeZ() == 2 && v1.sizeY() == 3 && v1.sizeX() == 2);
+    assert(v1(0,0,0) == 7);
+
+    std::cout << "Stampa di v1 con iterator (vista di m1):" << std::endl;
+    for (Matrice3DView<int>::iterator i = v1.begin(); i != v1.end(); ++i)
+        std::cout << *i << " ";
+    std::cout << std::endl;
+
+    // La vista e la slice contengono gli stessi valori nello stesso ordine
+    Matrice3D<int> m2 = m1.slice(1,2,0,2,0,1);
+    assert(std::equal(v1.begin(), v1.end(), m2.begin()));
+    assert(v1.materialize() == m2);
+
+    // Vista annidata: una colonna del secondo piano della vista
+    Matrice3DView<int> v2 = v1.slice(1,1,0,2,1,1);
+    assert(v2.size() == 3);
+    assert(v2(0,0,0) == 14 && v2(0,2,0) == 18);
+
+    // Le scritture attraverso la vista modificano la matrice di origine
+    v2(0,1,0) = 100;
+    assert(m1(2,1,1) == 100);
+
+    // Vista in sola lettura su una matrice costante
+    const Matrice3D<int> m3(m1);
+    Matrice3DView<const int> v3 = m3.view(0,0,1,1,0,1);
+    assert(v3(0,0,1) == 4);
+    assert(std::count(v3.begin(), v3.end(), 3) == 1);
+
+    // Eccezione su coordinate fuori dalla vista
+    try {
+        v2(0,3,0);
+        assert(false);
+    }
+    catch(Matrice3DOutOfRange &e){
+        std::cout << "Eccezione Operatore() della vista: " << e.what() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 /**
     @brief Test dell'operatore == con due Matrice3D di char e interi
            con funtore di confronto generico (classico == tra dati)
@@ -511,18 +2634,66 @@ int main(){
     test_conversione();
     // Test per l'operatore ()
     test_operator_function();
+    // Test per le politiche di accesso
+    test_accesso();
     // Test per l'iterator
     test_iterator();
     // Test per il const_iterator
     test_const_iterator();
     // Test per il metodo slice
     test_slice();
+    // Test per le viste
+    test_view();
     // Test per l'operatore ==
     test_opequals();
     // Test per il metodo fill
     test_fill();
     // Test per il metodo trasform
     test_trasform();
+    // Test delle allocazioni (move e trasform)
+    test_allocazioni();
+    // Test degli allocatori
+    test_allocatori();
+    // Test degli operatori aritmetici
+    test_espressioni();
+    // Test dei kernel SIMD
+    test_simd();
+    // Test delle operazioni parallele
+    test_parallelo();
+    // Test dei layout di memoria
+    test_layout();
+    // Test del formato binario su file
+    test_file();
+    // Test della Matrice3D su disco
+    test_stream();
+    // Test degli stencil e delle convoluzioni
+    test_stencil();
+    // Test delle riduzioni
+    test_riduzioni();
+    // Test della Matrice3DSparse
+    test_sparse();
+    // Test della Matrice3DFixed
+    test_fixed();
+    // Test della permutazione degli assi
+    test_permute();
+    // Test dell'hash e dell'uguaglianza
+    test_hash();
+    // Test delle copie in blocco
+    test_copia();
+    // Test della strumentazione
+    test_statistiche();
+    // Test della Matrice3DCow
+    test_cow();
+    // Test della Matrice3DCompressed
+    test_compressed();
+    // Test della Matrice3DPyramid
+    test_pyramid();
+    // Test di righe, colonne, pilastri e piani
+    test_assi();
+    // Test dei volumi oltre 2^32 elementi
+    test_grandi_volumi();
+    // Test di trasform in place e a piu' ingressi
+    test_trasform_multipli();
     // Test eccezioni
     test_eccezioni();
     // Test per la Matrice3D con dati custom
@@ -3,6 +3,24 @@
 
 #include <iostream> // cout ostream
 #include <algorithm> // swap
+#include <utility> // move
+#include <cstddef> // ptrdiff_t
+#include <iterator> // forward_iterator_tag
+#include <type_traits> // remove_const
+#include <cassert> // assert
+#include <memory> // allocator_traits
+#include <cstring> // memcmp
+#include <cstdint> // uint64_t
+#include <functional> // less
+#include <vector> // vector (hash parallelo)
+#include <tuple> // tuple, apply (trasform a N ingressi)
+#include "matrice3d_alloc.h" // alignedAllocator, Matrice3DArena
+#include "matrice3d_simd.h" // Matrice3DSimd
+#include "matrice3d_parallel.h" // Matrice3DThreadPool, m3dSeq, m3dPar
+#include "matrice3d_layout.h" // rowMajorLayout, tiledLayout, mortonLayout
+#include "matrice3d_hash.h" // m3dBitwiseEqual, m3dHashElements
+#include "matrice3d_stats.h" // M3D_STATS_SCOPE, M3D_STATS_EVENT
+#include "matrice3d_axis.h" // Matrice3DStrideIterator, Matrice3DRange
 
 
 /**
@@ -47,6 +65,27 @@ class Matrice3DError : public std::exception {
         const char * what () { return message; }
 };
 
+/**
+    @brief Numero di elementi di un volume z * y * x
+
+    Il prodotto viene calcolato in std::size_t: tre dimensioni a 32 bit possono superare
+    2^32 elementi (es. 2048 x 2048 x 1024) e il prodotto in unsigned int si ridurrebbe
+    modulo 2^32 senza errori. Ogni moltiplicazione e' controllata contro limit.
+
+    @param z, y, x dimensioni del volume
+    @param limit numero massimo di elementi ammesso
+
+    @return z * y * x
+
+    @throw Matrice3DOutOfRange se il volume supera limit
+*/
+inline std::size_t m3dVolume(std::size_t z, std::size_t y, std::size_t x,
+                             std::size_t limit = std::size_t(-1)) {
+    if ((y != 0 && z > limit / y) || (x != 0 && z * y > limit / x))
+        throw Matrice3DOutOfRange("ERRORE: Dimensioni della matrice troppo grandi");
+    return z * y * x;
+}
+
 /**
     @brief Funtore di default per il confronto tra elementi della matrice
 
@@ -57,9 +96,321 @@ class Matrice3DError : public std::exception {
 */
 struct defaultCmp {
     template <typename T>
-    bool operator()(T x1, T x2) const { return (x1 == x2); }
+    constexpr bool operator()(T x1, T x2) const { return (x1 == x2); }
+};
+
+
+/**
+    @brief Politiche di controllo degli indici per l'operatore () della Matrice3D
+
+    Ogni politica espone un metodo statico check(z, y, x, sizeZ, sizeY, sizeX)
+    chiamato prima di ogni accesso tramite operatore ():
+    - checkedAccess: lancia Matrice3DOutOfRange (comportamento di default).
+    - debugAccess: controlla con assert, quindi solo se NDEBUG non e' definita.
+    - uncheckedAccess: nessun controllo, l'accesso si riduce all'aritmetica dei puntatori.
+
+*/
+struct checkedAccess {
+    static void check(int z, int y, int x, unsigned int sizeZ, unsigned int sizeY, unsigned int sizeX) {
+        if(z >= sizeZ || y >= sizeY || x >= sizeX || z < 0 || y < 0 || x < 0){
+            M3D_STATS_EVENT(m3dOpOutOfRange, 0);
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+        }
+    }
+};
+
+struct debugAccess {
+    static void check(int z, int y, int x, unsigned int sizeZ, unsigned int sizeY, unsigned int sizeX) {
+        assert(z >= 0 && y >= 0 && x >= 0);
+        assert((unsigned int)z < sizeZ && (unsigned int)y < sizeY && (unsigned int)x < sizeX);
+        (void)z; (void)y; (void)x; (void)sizeZ; (void)sizeY; (void)sizeX;
+    }
+};
+
+struct uncheckedAccess {
+    static void check(int, int, int, unsigned int, unsigned int, unsigned int) {}
+};
+
+/**
+    @brief Riferimento a un elemento di un contenitore a blocchi con cache
+
+    Ritornato dall'operatore () e dagli iteratori non costanti dei contenitori che
+    tengono in memoria solo alcuni blocchi (Matrice3DStream, Matrice3DCompressed,
+    Matrice3DSparse). Si usa come T&: la lettura (conversione a T) chiama
+    C::load_element(i), che non alloca il blocco e non lo segna come modificato;
+    l'assegnamento e gli operatori composti chiamano
+    C::store_element(i). Cosi' una scansione in sola lettura attraverso un contenitore
+    non costante non provoca riscritture del blocco.
+
+*/
+template <class C> class Matrice3DElementRef
+{
+    C *_c; ///< contenitore dell'elemento
+    std::size_t _i; ///< posizione lineare dell'elemento
+
+    public:
+    typedef typename C::value_type value_type; ///< tipo dell'elemento
+
+    Matrice3DElementRef(C *c, std::size_t i) : _c(c), _i(i) {}
+
+    operator value_type() const { return _c->load_element(_i); }
+
+    Matrice3DElementRef& operator=(const value_type &v) { _c->store_element(_i) = v; return *this; }
+    Matrice3DElementRef& operator=(const Matrice3DElementRef &other) { return *this = value_type(other); }
+    Matrice3DElementRef& operator+=(const value_type &v) { _c->store_element(_i) += v; return *this; }
+    Matrice3DElementRef& operator-=(const value_type &v) { _c->store_element(_i) -= v; return *this; }
+    Matrice3DElementRef& operator*=(const value_type &v) { _c->store_element(_i) *= v; return *this; }
+    Matrice3DElementRef& operator/=(const value_type &v) { _c->store_element(_i) /= v; return *this; }
 };
 
+template <class T, class Cmp, class Check, class Alloc, class Layout> class Matrice3D;
+template <class E> struct Matrice3DExpr;
+
+/**
+    @brief Classe Matrice3DView
+
+    Vista non proprietaria su una porzione di una Matrice3D. La vista non alloca
+    memoria: si riferisce al buffer della matrice di origine attraverso un puntatore
+    al primo elemento e tre stride (distanza, in elementi, tra due piani, due righe e
+    due colonne consecutive). Crearla costa O(1) indipendentemente dalle dimensioni.
+
+    La vista resta valida finche' la matrice di origine non viene distrutta o
+    riallocata. Come per i puntatori, la constness della vista e' "superficiale":
+    per una vista in sola lettura si usa Matrice3DView<const T>.
+
+*/
+template <class T, class Cmp = defaultCmp> class Matrice3DView
+{
+    T *_data; ///< puntatore al primo elemento della vista
+    unsigned int _sizeX; ///< dimensione X
+    unsigned int _sizeY; ///< dimensione Y
+    unsigned int _sizeZ; ///< dimensione Z
+    std::size_t _size; ///< dimensione totale
+    std::ptrdiff_t _strideX; ///< distanza tra due colonne consecutive
+    std::ptrdiff_t _strideY; ///< distanza tra due righe consecutive
+    std::ptrdiff_t _strideZ; ///< distanza tra due piani consecutivi
+
+    public:
+
+    /**
+        Costruttore di default: vista vuota
+
+        @post _data == nullptr
+        @post _size == 0
+    */
+    Matrice3DView() : _data(nullptr), _sizeX(0), _sizeY(0), _sizeZ(0), _size(0),
+                      _strideX(0), _strideY(0), _strideZ(0) {}
+
+    /**
+        Costruttore della vista a partire da un buffer e dai suoi stride
+
+        @param data puntatore al primo elemento della vista
+        @param z, y, x dimensioni della vista
+        @param sz, sy, sx stride di piano, riga e colonna
+
+        @post _size == z * y * x
+    */
+    Matrice3DView(T *data, unsigned int z, unsigned int y, unsigned int x,
+                  std::ptrdiff_t sz, std::ptrdiff_t sy, std::ptrdiff_t sx)
+        : _data(data), _sizeX(x), _sizeY(y), _sizeZ(z), _size(std::size_t(z) * y * x),
+          _strideX(sx), _strideY(sy), _strideZ(sz) {}
+
+    /**
+        Conversione implicita da vista modificabile a vista in sola lettura
+    */
+    template <typename U, typename = typename std::enable_if<
+        std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+    Matrice3DView(const Matrice3DView<U, Cmp> &other)
+        : Matrice3DView(other.data(), other.sizeZ(), other.sizeY(), other.sizeX(),
+                        other.strideZ(), other.strideY(), other.strideX()) {}
+
+    unsigned int sizeX() const { return _sizeX; } ///< dimensione X della vista
+    unsigned int sizeY() const { return _sizeY; } ///< dimensione Y della vista
+    unsigned int sizeZ() const { return _sizeZ; } ///< dimensione Z della vista
+    std::size_t size() const { return _size; } ///< dimensione totale della vista
+    std::ptrdiff_t strideX() const { return _strideX; } ///< stride di colonna
+    std::ptrdiff_t strideY() const { return _strideY; } ///< stride di riga
+    std::ptrdiff_t strideZ() const { return _strideZ; } ///< stride di piano
+    T *data() const { return _data; } ///< puntatore al primo elemento
+
+    /**
+        Operatore ():  Ritorna il valore delle coordinate (z, y, x) della vista,
+        ovvero l'elemento corrispondente della matrice di origine.
+
+        @return Valore delle coordinate (z, y, x)
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide
+    */
+    T& operator()(int z, int y, int x) const {
+        if(z >= _sizeZ || y >= _sizeY || x >= _sizeX || z < 0 || y < 0 || x < 0){
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della vista");
+        }
+        return _data[z * _strideZ + y * _strideY + x * _strideX];
+    }
+
+    /**
+        Metodo at_unchecked: come l'operatore () ma senza controllo delle coordinate.
+
+        @pre 0 <= z < sizeZ(), 0 <= y < sizeY(), 0 <= x < sizeX()
+
+        @return Valore delle coordinate (z, y, x)
+    */
+    T& at_unchecked(int z, int y, int x) const {
+        return _data[z * _strideZ + y * _strideY + x * _strideX];
+    }
+
+    /**
+        Metodi row, col e pillar: elementi della vista lungo x (riga (z, y)), lungo y
+        (colonna (z, x)) o lungo z (pilastro (y, x)), con iteratori random access che
+        seguono gli stride della vista.
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate fuori dai limiti della vista
+    */
+    Matrice3DRange<Matrice3DStrideIterator<T> > row(int z, int y) const {
+        if(z < 0 || z >= (int)_sizeZ || y < 0 || y >= (int)_sizeY)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della vista");
+        return Matrice3DRange<Matrice3DStrideIterator<T> >(
+            Matrice3DStrideIterator<T>(_data + z * _strideZ + y * _strideY, _strideX), _sizeX);
+    }
+
+    Matrice3DRange<Matrice3DStrideIterator<T> > col(int z, int x) const {
+        if(z < 0 || z >= (int)_sizeZ || x < 0 || x >= (int)_sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della vista");
+        return Matrice3DRange<Matrice3DStrideIterator<T> >(
+            Matrice3DStrideIterator<T>(_data + z * _strideZ + x * _strideX, _strideY), _sizeY);
+    }
+
+    Matrice3DRange<Matrice3DStrideIterator<T> > pillar(int y, int x) const {
+        if(y < 0 || y >= (int)_sizeY || x < 0 || x >= (int)_sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della vista");
+        return Matrice3DRange<Matrice3DStrideIterator<T> >(
+            Matrice3DStrideIterator<T>(_data + y * _strideY + x * _strideX, _strideZ), _sizeZ);
+    }
+
+    /**
+        Metodo slice: Ritorna una sotto-vista contenente i valori negli intervalli di
+                      coordinate z1..z2, y1..y2 e x1..x2 (relativi a questa vista).
+                      Non copia alcun elemento.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Matrice3DView sugli stessi dati
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3DView slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        if(z1 > z2 || y1 > y2 || x1 > x2)
+            throw Matrice3DInvalidParameters("ERRORE: Parametri forniti invalidi");
+        if(z1 < 0 || z2 >= _sizeZ || y1 < 0 || y2 >= _sizeY || x1 < 0 || x2 >= _sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+        return Matrice3DView(_data + z1 * _strideZ + y1 * _strideY + x1 * _strideX,
+                             z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1,
+                             _strideZ, _strideY, _strideX);
+    }
+
+    /**
+        Metodo materialize: copia gli elementi della vista in una nuova Matrice3D
+                            proprietaria dei propri dati.
+
+        @tparam M tipo della Matrice3D risultato (di default con gli stessi T e Cmp)
+
+        @return Matrice3D con gli stessi valori della vista
+    */
+    template <class M = Matrice3D<typename std::remove_const<T>::type, Cmp, checkedAccess,
+                                  alignedAllocator<typename std::remove_const<T>::type>, rowMajorLayout> >
+    M materialize() const {
+        if (_size == 0)
+            return M();
+        return copy_into(M(_sizeZ, _sizeY, _sizeX));
+    }
+
+    /**
+        Metodo materialize: come sopra, ma la nuova Matrice3D usa l'allocatore alloc.
+
+        @param alloc allocatore della Matrice3D risultato
+
+        @return Matrice3D con gli stessi valori della vista
+    */
+    template <class M>
+    M materialize(const typename M::allocator_type &alloc) const {
+        if (_size == 0)
+            return M(alloc);
+        return copy_into(M(_sizeZ, _sizeY, _sizeX, alloc));
+    }
+
+    private:
+
+    /**
+        Copia gli elementi della vista in m, che ha le stesse dimensioni della vista.
+    */
+    template <class M>
+    M copy_into(M m) const {
+        typename M::iterator out = m.begin();
+        // Copio riga per riga seguendo gli stride
+        for (unsigned int i = 0; i < _sizeZ; i++)
+            for (unsigned int j = 0; j < _sizeY; j++) {
+                const T *row = _data + i * _strideZ + j * _strideY;
+                for (unsigned int k = 0; k < _sizeX; k++)
+                    *out++ = row[k * _strideX];
+            }
+        return m;
+    }
+
+    public:
+
+    /**
+     @brief Forward iterator della vista
+
+            Scorre gli elementi della vista nello stesso ordine della Matrice3D
+            (x, poi y, poi z), saltando le parti della matrice di origine che
+            non appartengono alla vista.
+    */
+    class iterator {
+        const Matrice3DView *_view; ///< vista su cui si itera
+        T *_ptr; ///< elemento corrente
+        unsigned int _x; ///< colonna corrente
+        unsigned int _y; ///< riga corrente
+        std::size_t _i; ///< posizione lineare corrente
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        iterator() : _view(nullptr), _ptr(nullptr), _x(0), _y(0), _i(0) {}
+        iterator(const Matrice3DView *v, std::size_t i) : _view(v), _ptr(v->_data), _x(0), _y(0), _i(i) {}
+
+        reference operator*() const { return *_ptr; }
+        pointer operator->() const { return _ptr; }
+
+        iterator& operator++() {
+            ++_i;
+            _ptr += _view->_strideX;
+            // Fine riga: torno all'inizio della riga e passo alla successiva
+            if (++_x == _view->_sizeX) {
+                _x = 0;
+                _ptr += _view->_strideY - _view->_sizeX * _view->_strideX;
+                // Fine piano: passo al piano successivo
+                if (++_y == _view->_sizeY) {
+                    _y = 0;
+                    _ptr += _view->_strideZ - _view->_sizeY * _view->_strideY;
+                }
+            }
+            return *this;
+        }
+        iterator operator++(int) { iterator tmp(*this); ++(*this); return tmp; }
+
+        bool operator==(const iterator &other) const { return _i == other._i; }
+        bool operator!=(const iterator &other) const { return _i != other._i; }
+    };
+
+    // Metodi membro begin() e end() per l'iterazione
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, _size); }
+};
 
 /**
     @brief Classe Matrice3D
@@ -67,19 +418,74 @@ struct defaultCmp {
     La classe implementa una matrice a 3 dimensioni di celle contenete dati
     di tipo T. La dimensione della matrice è scelta dall’utente in fase di costruzione
     dell’oggetto.
+    La politica Check stabilisce come l'operatore () controlla le coordinate
+    (vedi checkedAccess, debugAccess e uncheckedAccess).
+    La memoria e' ottenuta dall'allocatore Alloc (di default allineata a 64 byte) ed
+    e' non inizializzata: gli elementi vengono costruiti direttamente con il loro
+    valore finale, e per i tipi banali la costruzione di default viene saltata.
+    La politica Layout stabilisce l'ordine degli elementi nel buffer (vedi
+    matrice3d_layout.h): row-major di default, oppure a mattoni o Morton. Operatore (),
+    iteratori, slice() e == non dipendono dal layout; view() e le espressioni
+    aritmetiche richiedono il layout row-major.
+    Le dimensioni e le coordinate di ciascun asse sono a 32 bit; size(), gli stride e le
+    posizioni nel buffer sono std::size_t, quindi il volume puo' superare 2^32 elementi.
+    Il costruttore controlla che z * y * x non vada in overflow (vedi m3dVolume).
 
 */
-template <class T, class Cmp = defaultCmp> class Matrice3D
+template <class T, class Cmp = defaultCmp, class Check = checkedAccess,
+          class Alloc = alignedAllocator<T>, class Layout = rowMajorLayout> class Matrice3D
 {
+    template <class, class, class, class, class> friend class Matrice3D;
+
+    typedef std::allocator_traits<Alloc> alloc_traits;
+    static_assert(std::is_same<typename Alloc::value_type, T>::value,
+                  "Matrice3D: Alloc::value_type deve essere T");
+
     T *_matrix; ///< valore da memorizzare 
     unsigned int _sizeX; ///< dimensione X
     unsigned int _sizeY; ///< dimensione Y
     unsigned int _sizeZ; ///< dimensione Z
-    unsigned int _size; ///< dimensione totale
+    std::size_t _size; ///< dimensione totale
+    std::size_t _strideY; ///< distanza tra due righe consecutive (== _sizeX)
+    std::size_t _strideZ; ///< distanza tra due piani consecutivi (== _sizeX * _sizeY)
     Cmp _cmp; ///< funtore di confronto
+    Alloc _alloc; ///< allocatore del buffer
+    Layout _layout; ///< layout del buffer (vuoto per il row-major)
+
+    /// Confronto dell'intero buffer (riempimento dei layout compreso) con memcmp o SIMD
+    static constexpr bool buffer_compare = std::is_same<Cmp, defaultCmp>::value &&
+                                           (std::is_arithmetic<T>::value || m3dBitwiseEqual<T>::value);
+    /// Elementi confrontati tra due controlli dell'uscita anticipata in equals() parallelo
+    static constexpr std::size_t compare_slice = std::size_t(1) << 16;
+
+    /// Confronto degli elementi del buffer in [b, e)
+    bool equal_range(const Matrice3D &other, std::size_t b, std::size_t e) const {
+        // Tipi aritmetici con il funtore di default: confronto vettoriale (stesso layout,
+        // e il riempimento vale T() in entrambe le matrici)
+        if constexpr (std::is_same<Cmp, defaultCmp>::value && std::is_arithmetic<T>::value)
+            return Matrice3DSimd::equal(_matrix + b, other._matrix + b, e - b);
+        // Tipi confrontabili byte a byte (enum, puntatori, m3dBitwiseEqual): memcmp
+        else if constexpr (buffer_compare)
+            return e == b || std::memcmp(_matrix + b, other._matrix + b, (e - b) * sizeof(T)) == 0;
+        // Altrimenti ciclo sugli elementi e controllo se sono uguali con il funtore
+        else {
+            for (std::size_t i = b; i < e; i++)
+                if (!(_cmp(_matrix[i], other._matrix[i])))
+                    return false;
+            return true;
+        }
+    }
     
     public:
 
+    typedef T value_type; ///< tipo degli elementi
+    typedef Alloc allocator_type; ///< tipo dell'allocatore
+    typedef Layout layout_type; ///< politica di layout
+    typedef Matrice3DRange<T*> row_range; ///< riga (contigua)
+    typedef Matrice3DRange<const T*> const_row_range; ///< riga in sola lettura
+    typedef Matrice3DRange<Matrice3DStrideIterator<T> > axis_range; ///< colonna o pilastro
+    typedef Matrice3DRange<Matrice3DStrideIterator<const T> > const_axis_range; ///< colonna o pilastro in sola lettura
+
     /**
         PRIMO METODO FONDAMENTALE: Costruttore di default.
 
@@ -90,7 +496,17 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
         @post _size == 0
 
     */
-    Matrice3D() : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0)  {}
+    Matrice3D() : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0), _alloc()  {}
+
+    /**
+        Costruttore di una Matrice3D vuota che usera' l'allocatore alloc
+
+        @param alloc allocatore del buffer
+
+        @post _matrix == nullptr
+        @post _size == 0
+    */
+    explicit Matrice3D(const Alloc &alloc) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0), _alloc(alloc)  {}
 
     /**
         SECONDO METODO FONDAMENTALE: Distruttore 
@@ -108,9 +524,13 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
     /**
         TERZO METODO FONDAMENTALE: Copy Contructor 
 
+        Gli elementi vengono costruiti per copia direttamente nella memoria non
+        inizializzata, senza una costruzione di default preliminare; i tipi
+        banalmente copiabili sono copiati in blocco (memcpy).
+
         @param other Matrice3D da copiare    
     
-        @post _matrix == new T[other._sizeX * other._sizeY * other._sizeZ]
+        @post _matrix == copia di other._matrix
         @post _sizeX == other._sizeX
         @post _sizeY == other._sizeY
         @post _sizeZ == other._sizeZ
@@ -118,17 +538,19 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
         @throw Matrice3DError possibile eccezione possibile eccezione generata dal for
     */
-    Matrice3D(const Matrice3D &other) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0) {
-        
-        _matrix = new T[other._sizeX * other._sizeY * other._sizeZ];
-        // Provo l'assegnamento
+    Matrice3D(const Matrice3D &other) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0),
+                                        _alloc(alloc_traits::select_on_container_copy_construction(other._alloc)) {
+        M3D_STATS_SCOPE(m3dOpCopy, other.storage_size() * sizeof(T));
+        // Provo la costruzione per copia
         try {
-            for (int i = 0; i < other._size; i++)
-                _matrix[i] = other._matrix[i];  
+            copy_storage(other._matrix, other.storage_size());
             _sizeX = other._sizeX;
             _sizeY = other._sizeY;
             _sizeZ = other._sizeZ;
             _size = other._size;
+            _strideY = other._strideY;
+            _strideZ = other._strideZ;
+            _layout = other._layout;
         }
         catch (...) {
             std::cerr << "ERRORE: Copy Costructor fallito." << std::endl; 
@@ -144,7 +566,7 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
         @return reference alla Matrice3D this
 
-        @post _matrix == new T[other._size]
+        @post _matrix == copia di other._matrix
         @post _sizeX == other._sizeX
         @post _sizeY == other._sizeY
         @post _sizeZ == other._sizeZ
@@ -152,72 +574,316 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
     */
     Matrice3D& operator=(const Matrice3D &other) {
         if (this != &other) {
+            M3D_STATS_SCOPE(m3dOpAssign, other.storage_size() * sizeof(T));
             Matrice3D tmp(other);
             swap(tmp);
         }
         return *this;
     }
 
+    /**
+        Move Constructor: acquisisce il buffer di other senza copiarlo
+
+        @param other Matrice3D da cui spostare i dati
+
+        @post _matrix == other._matrix (prima dello spostamento)
+        @post other._matrix == nullptr
+        @post other._size == 0
+    */
+    Matrice3D(Matrice3D &&other) noexcept : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0),
+                                            _alloc(other._alloc) {
+        swap(other);
+    }
+
+    /**
+        Operatore di Assegnamento per spostamento
+
+        @param other Matrice3D da cui spostare i dati
+
+        @return reference alla Matrice3D this
+
+        @post other._matrix == nullptr
+        @post other._size == 0
+    */
+    Matrice3D& operator=(Matrice3D &&other) noexcept {
+        if (this != &other) {
+            // Il vecchio buffer di this viene liberato da tmp
+            Matrice3D tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
     /**
         Costruttore secondario
         @param z dimensione Z
         @param y dimensione Y
         @param x dimensione X
+        @param alloc allocatore del buffer
 
-        @post _matrix == new T[z * y * x]
+        @post _matrix == buffer di z * y * x elementi (costruiti di default se T non e' banale
+                         o se il layout non e' contiguo)
         @post _sizeX == x
         @post _sizeY == y
         @post _sizeZ == z
         @post _size == z * y * x
 
-        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida
+        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida o di volume
+               troppo grande per l'allocatore
     */
-    Matrice3D(int z, int y, int x) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0)  {
+    Matrice3D(int z, int y, int x, const Alloc &alloc = Alloc()) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _strideY(0), _strideZ(0), _alloc(alloc)  {
         if (z <= 0 || y <= 0 || x <= 0)
             throw Matrice3DOutOfRange("ERRORE: Indici fuori dai limiti della matrice");
    
-        _matrix = new T[z * y * x];
+        Layout layout;
+        // Oltre PTRDIFF_MAX byte la differenza tra due iteratori non sarebbe rappresentabile
+        std::size_t limit = std::min<std::size_t>(alloc_traits::max_size(_alloc),
+                                                  std::size_t(PTRDIFF_MAX) / sizeof(T));
+        std::size_t n = layout_storage(layout, z, y, x, limit);
+        // Come new T[], i tipi banali restano non inizializzati. Nei layout non contigui
+        // il riempimento deve valere T(), quindi costruisco tutto il buffer.
+        if (Layout::contiguous && std::is_trivially_default_constructible<T>::value)
+            _matrix = allocate_storage(n);
+        else
+            build_storage(n, [&](T *p, std::size_t) {
+                alloc_traits::construct(_alloc, p);
+            });
         _sizeX = x;
         _sizeY = y;
         _sizeZ = z;
-        _size = z * y * x;
-        
+        _size = std::size_t(z) * y * x;
+        _strideY = x;
+        _strideZ = std::size_t(x) * y;
+        _layout = layout;
     }
     /**
         Costruttore di conversione da Matrice3D<U> a Matrice3D<T>
 
         @param other Matrice3D<U> da convertire
+        @param alloc allocatore del buffer
 
-        @post _matrix == new T[other.size()]
+        @post _matrix == buffer di other.size() elementi
         @post _sizeX == other.sizeX()
         @post _sizeY == other.sizeY()
         @post _sizeZ == other.sizeZ()
         @post _size == other.size()
         @post this->operator()(i,j,k) = static_cast<T>(other(i, j, k))
 
+        Se other ha un layout diverso gli elementi vengono riordinati (relayout): in questo
+        caso T deve essere costruibile di default.
+
         @throw Matrice3DError possibile eccezione generata dal for
     */
-    template <typename U, typename F>
-    Matrice3D(const Matrice3D<U, F> &other) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0) {
-        _matrix = new T[other.size()];
+    template <typename U, typename F, typename C, typename A, typename L>
+    Matrice3D(const Matrice3D<U, F, C, A, L> &other, const Alloc &alloc = Alloc()) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0), _alloc(alloc) {
+        M3D_STATS_SCOPE(m3dOpConvert, other.size() * sizeof(U));
+        if constexpr (!std::is_same<L, Layout>::value) {
+            if (other.size() == 0)
+                return;
+            try {
+                Matrice3D tmp(other.sizeZ(), other.sizeY(), other.sizeX(), alloc);
+                tmp.relayout_from(other);
+                swap(tmp);
+            }
+            catch (...) {
+                std::cerr << "ERRORE: Costruttore di conversione fallito." << std::endl; 
+                throw Matrice3DError("ERRORE: Costruttore di conversione fallito.");
+            }
+            return;
+        }
+        try{ 
+            // Converto a T e costruisco this con i valori di other: stesso layout,
+            // quindi basta scorrere i due buffer linearmente
+            const U *src = other.data();
+            if constexpr (std::is_same<T, U>::value) {
+                // Stesso tipo (cambiano solo le politiche): copia come il copy constructor
+                copy_storage(src, other.storage_size());
+            }
+            else if constexpr (std::is_arithmetic<T>::value && std::is_arithmetic<U>::value) {
+                // Tipi aritmetici: conversione vettoriale nella memoria non inizializzata
+                if (other.size() > 0) {
+                    _matrix = allocate_storage(other.storage_size());
+                    Matrice3DSimd::convert(_matrix, src, other.storage_size());
+                }
+            }
+            else {
+                build_storage(other.storage_size(), [&](T *p, std::size_t i) {
+                    // Inizializzazione diretta T(src[i]), equivalente a static_cast<T>
+                    alloc_traits::construct(_alloc, p, src[i]);
+                });
+            }
+        }
+        catch (...) {
+            std::cerr << "ERRORE: Costruttore di conversione fallito." << std::endl; 
+            clear();
+            throw Matrice3DError("ERRORE: Costruttore di conversione fallito.");
+        }
         _sizeX = other.sizeX();
         _sizeY = other.sizeY();
         _sizeZ = other.sizeZ();
         _size = other.size();
-        try{ 
-            // Converto a T e assegno a this i valori di other
-            for (int i = 0; i < other.sizeZ(); i++) 
-                for (int j = 0; j < other.sizeY(); j++) 
-                    for (int k = 0; k < other.sizeX(); k++) 
-                        this->operator()(i,j,k) = static_cast<T>(other(i,j,k));       
+        _strideY = other._strideY;
+        _strideZ = other._strideZ;
+        if constexpr (std::is_same<L, Layout>::value)
+            _layout = other._layout;
+    }
+
+    /**
+        Costruttore di conversione con politica di esecuzione sequenziale: equivale
+        al costruttore di conversione.
+
+        @param other Matrice3D<U> da convertire
+        @param alloc allocatore del buffer
+    */
+    template <typename U, typename F, typename C, typename A, typename L>
+    Matrice3D(const Matrice3D<U, F, C, A, L> &other, const m3dSeqPolicy &, const Alloc &alloc = Alloc()) : Matrice3D(other, alloc) {}
+
+    /**
+        Costruttore di conversione con politica di esecuzione parallela: i blocchi di
+        piani z vengono convertiti in parallelo sul pool. Se la conversione U -> T puo'
+        lanciare eccezioni, o se i layout sono diversi, viene eseguita in modo sequenziale.
+
+        @param other Matrice3D<U> da convertire
+        @param policy politica parallela (m3dPar(pool))
+        @param alloc allocatore del buffer
+
+        @post this->operator()(i,j,k) = static_cast<T>(other(i, j, k))
+
+        @throw Matrice3DError possibile eccezione generata dalla conversione
+    */
+    template <typename U, typename F, typename C, typename A, typename L>
+    Matrice3D(const Matrice3D<U, F, C, A, L> &other, const m3dParPolicy &policy, const Alloc &alloc = Alloc()) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0), _alloc(alloc) {
+        if constexpr (!std::is_nothrow_constructible<T, const U &>::value || !std::is_same<L, Layout>::value) {
+            Matrice3D tmp(other, alloc);
+            swap(tmp);
+        }
+        else {
+            M3D_STATS_SCOPE(m3dOpConvert, other.size() * sizeof(U));
+            const U *src = other.data();
+            if (other.size() > 0) {
+                _matrix = allocate_storage(other.storage_size());
+                T *dst = _matrix;
+                m3dForBlocks(policy, other.storage_size(), other.strideZ(), [&](std::size_t b, std::size_t e) {
+                    if constexpr (std::is_arithmetic<T>::value && std::is_arithmetic<U>::value)
+                        Matrice3DSimd::convert(dst + b, src + b, e - b);
+                    else
+                        for (std::size_t i = b; i < e; i++)
+                            alloc_traits::construct(_alloc, dst + i, src[i]);
+                });
+            }
+            _sizeX = other.sizeX();
+            _sizeY = other.sizeY();
+            _sizeZ = other.sizeZ();
+            _size = other.size();
+            _strideY = other._strideY;
+            _strideZ = other._strideZ;
+            _layout = other._layout;
+        }
+    }
+
+    /**
+        Costruttore da espressione element-wise (vedi matrice3d_expr.h): l'intera
+        espressione viene valutata in un unico ciclo, costruendo ogni elemento
+        direttamente con il suo valore. Non vengono create matrici intermedie.
+
+        @param expr espressione da valutare (es. A + B * 2)
+        @param alloc allocatore del buffer
+
+        @post this->operator()(i,j,k) == static_cast<T>(valore dell'espressione in (i,j,k))
+
+        Con un layout non contiguo l'espressione viene valutata in row-major e poi riordinata.
+
+        @throw Matrice3DError possibile eccezione generata dalla costruzione degli elementi
+    */
+    template <class E>
+    Matrice3D(const Matrice3DExpr<E> &expr, const Alloc &alloc = Alloc()) : _matrix(nullptr), _sizeZ(0), _sizeY(0), _sizeX(0), _size(0), _strideY(0), _strideZ(0), _alloc(alloc) {
+        if constexpr (!Layout::contiguous) {
+            Matrice3D tmp(Matrice3D<T, Cmp, Check, Alloc>(expr, alloc), alloc);
+            swap(tmp);
+            return;
+        }
+        const E &e = expr.derived();
+        try {
+            if constexpr (std::is_arithmetic<T>::value) {
+                // Tipi aritmetici: valuto direttamente nella memoria non inizializzata,
+                // con i kernel vettoriali quando l'espressione lo consente
+                if (e.size() > 0) {
+                    _matrix = allocate_storage(e.size());
+                    m3dEvaluate(_matrix, e, e.size());
+                }
+            }
+            else {
+                build_storage(e.size(), [&](T *p, std::size_t i) {
+                    alloc_traits::construct(_alloc, p, e[i]);
+                });
+            }
         }
         catch (...) {
-            std::cerr << "ERRORE: Costruttore di conversione fallito." << std::endl; 
+            std::cerr << "ERRORE: Valutazione dell'espressione fallita." << std::endl;
             clear();
-            throw Matrice3DError("ERRORE: Costruttore di conversione fallito.");
+            throw Matrice3DError("ERRORE: Valutazione dell'espressione fallita.");
+        }
+        _sizeX = e.sizeX();
+        _sizeY = e.sizeY();
+        _sizeZ = e.sizeZ();
+        _size = e.size();
+        _strideY = _sizeX;
+        _strideZ = std::size_t(_sizeX) * _sizeY;
+    }
+
+    /**
+        Operatore di Assegnamento da espressione element-wise. Se le dimensioni coincidono
+        l'espressione viene valutata direttamente nel buffer esistente (senza allocazioni,
+        anche se this compare nell'espressione, es. A = A + B), altrimenti in un nuovo buffer.
+
+        @param expr espressione da valutare
+
+        @return reference alla Matrice3D this
+
+        @throw Matrice3DError possibile eccezione generata dagli assegnamenti
+    */
+    template <class E>
+    Matrice3D& operator=(const Matrice3DExpr<E> &expr) {
+        const E &e = expr.derived();
+        if (!Layout::contiguous || e.sizeZ() != _sizeZ || e.sizeY() != _sizeY || e.sizeX() != _sizeX) {
+            Matrice3D tmp(expr, _alloc);
+            swap(tmp);
+            return *this;
+        }
+        try {
+            if constexpr (Layout::contiguous)
+                m3dEvaluate(_matrix, e, _size);
+        }
+        catch (...) {
+            std::cerr << "ERRORE: Valutazione dell'espressione fallita." << std::endl;
+            clear();
+            throw Matrice3DError("ERRORE: Valutazione dell'espressione fallita.");
         }
+        return *this;
     }
 
+    /**
+        Operatori composti +=, -=, *=, /=: accettano una Matrice3D, un'espressione o
+        uno scalare e vengono valutati direttamente nel buffer di this.
+
+        @param x secondo operando
+
+        @return reference alla Matrice3D this
+
+        @throw Matrice3DInvalidParameters possibile eccezione di dimensioni non compatibili
+    */
+    template <class X> Matrice3D& operator+=(const X &x) { return *this = *this + x; }
+    template <class X> Matrice3D& operator-=(const X &x) { return *this = *this - x; }
+    template <class X> Matrice3D& operator*=(const X &x) { return *this = *this * x; }
+    template <class X> Matrice3D& operator/=(const X &x) { return *this = *this / x; }
+
+    /**
+        Metodo getter per l'allocatore della matrice
+
+        @return Copia dell'allocatore usato dalla Matrice3D
+    */
+    Alloc get_allocator() const { return _alloc; }
+
     /**
         @brief Metodo swap per la classe Matrice3D
 
@@ -225,12 +891,16 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
         @param other la Matrice3D con cui scambiare il contenuto
     */
-    void swap(Matrice3D &other) {
+    void swap(Matrice3D &other) noexcept {
         std::swap(_matrix, other._matrix);
         std::swap(_sizeX, other._sizeX); 
         std::swap(_sizeY, other._sizeY); 
         std::swap(_sizeZ, other._sizeZ); 
         std::swap(_size, other._size); 
+        std::swap(_strideY, other._strideY);
+        std::swap(_strideZ, other._strideZ);
+        std::swap(_alloc, other._alloc);
+        std::swap(_layout, other._layout);
     }
 
     /**
@@ -259,7 +929,20 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
         @return Dimensione Totale della Matrice3D
     */
-    unsigned int size() const { return _size; }
+    std::size_t size() const { return _size; }
+
+    /**
+        Metodo getter per il numero di elementi del buffer data(): size() piu'
+        l'eventuale riempimento del layout
+
+        @return Elementi del buffer della Matrice3D
+    */
+    std::size_t storage_size() const {
+        if constexpr (Layout::contiguous)
+            return _size;
+        else
+            return _layout.capacity();
+    }
 
     /**
         Metodo clear(): Funzione utilizzata per deallocare la memoria occupata
@@ -270,53 +953,239 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
         @post _sizeY == 0
         @post _sizeZ == 0
         @post _size == 0
+        @post _strideY == 0
+        @post _strideZ == 0
 
     */
     void clear() {
-        delete[] _matrix;
+        if (_matrix != nullptr) {
+            std::size_t n = storage_size();
+            destroy_range(_matrix, n);
+            alloc_traits::deallocate(_alloc, _matrix, n);
+        }
         _matrix = nullptr;
         _sizeX = 0;
         _sizeY = 0;
         _sizeZ = 0;
         _size = 0;
+        _strideY = 0;
+        _strideZ = 0;
+        _layout = Layout();
     }
 
     /**
         Operatore ():  Ritorna il valore delle coordinate (z, y, x) della matrice
         E'possibile leggere  il valore di una cella alla posizione (z,y,x). 
+        Il controllo delle coordinate dipende dalla politica Check.
         
         @return Valore delle coordinate (z, y, x)  constante
 
-        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
     */
     const T& operator()(int z, int y, int x) const {
-        // Se le coordinate non sono valide lancio un'eccezione
-        if(z >= _sizeZ || y >= _sizeY || x >= _sizeX || z < 0 || y < 0 || x < 0){
-            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
-        }
-        return _matrix[z * _sizeX * _sizeY + y * _sizeX + x];
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        return _matrix[offset(z, y, x)];
     }
 
     /**
         Operatore ():  Ritorna il valore delle coordinate (z, y, x) della matrice
         E'possibile leggere e scrivere il valore di una cella alla
         posizione (z,y,x). Es: G(1,2,3) = G(2,2,3).
+        Il controllo delle coordinate dipende dalla politica Check.
         
         @return Valore delle coordinate (z, y, x) 
 
-        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
     */
     T& operator()(int z, int y, int x) {
-        // Se le coordinate non sono valide lancio un'eccezione
-        if(z >= _sizeZ || y >= _sizeY || x >= _sizeX || z < 0 || y < 0 || x < 0){
-            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
-        }
-        return _matrix[z * _sizeX * _sizeY + y * _sizeX + x];
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        return _matrix[offset(z, y, x)];
     }
-   
+
+    /**
+        Metodo at_unchecked: Ritorna il valore delle coordinate (z, y, x) senza alcun
+                             controllo, indipendentemente dalla politica Check.
+
+        @pre 0 <= z < sizeZ(), 0 <= y < sizeY(), 0 <= x < sizeX()
+
+        @return Valore delle coordinate (z, y, x) constante
+    */
+    const T& at_unchecked(int z, int y, int x) const {
+        return _matrix[offset(z, y, x)];
+    }
+
+    /**
+        Metodo at_unchecked: Ritorna il valore delle coordinate (z, y, x) senza alcun
+                             controllo, indipendentemente dalla politica Check.
+
+        @pre 0 <= z < sizeZ(), 0 <= y < sizeY(), 0 <= x < sizeX()
+
+        @return Valore delle coordinate (z, y, x)
+    */
+    T& at_unchecked(int z, int y, int x) {
+        return _matrix[offset(z, y, x)];
+    }
+
+    /**
+        Metodo data: Ritorna il puntatore al buffer interno. Con il layout row-major
+                     l'elemento (z, y, x) si trova in data()[z * strideZ() + y * strideY() + x];
+                     con gli altri layout il buffer segue l'ordine del layout e contiene
+                     anche gli elementi di riempimento.
+
+        @return Puntatore al primo elemento della matrice (nullptr se vuota)
+    */
+    T *data() { return _matrix; }
+
+    /**
+        Metodo data: Ritorna il puntatore costante al buffer interno.
+
+        @return Puntatore costante al primo elemento della matrice (nullptr se vuota)
+    */
+    const T *data() const { return _matrix; }
+
+    /**
+        Metodo getter per la distanza tra due righe consecutive nel buffer
+
+        @return Stride di riga (== sizeX())
+    */
+    std::size_t strideY() const { return _strideY; }
+
+    /**
+        Metodo getter per la distanza tra due piani consecutivi nel buffer
+
+        @return Stride di piano (== sizeX() * sizeY())
+    */
+    std::size_t strideZ() const { return _strideZ; }
+   
+    /**
+        Metodo view: Ritorna una vista (senza copia) sull'intera Matrice3D.
+
+        @return Matrice3DView sui dati della matrice
+    */
+    Matrice3DView<T, Cmp> view() {
+        static_assert(Layout::contiguous, "view() richiede il layout row-major");
+        return Matrice3DView<T, Cmp>(_matrix, _sizeZ, _sizeY, _sizeX, _strideZ, _strideY, 1);
+    }
+
+    /**
+        Metodo view: Ritorna una vista in sola lettura (senza copia) sull'intera Matrice3D.
+
+        @return Matrice3DView in sola lettura sui dati della matrice
+    */
+    Matrice3DView<const T, Cmp> view() const {
+        static_assert(Layout::contiguous, "view() richiede il layout row-major");
+        return Matrice3DView<const T, Cmp>(_matrix, _sizeZ, _sizeY, _sizeX, _strideZ, _strideY, 1);
+    }
+
+    /**
+        Metodo view: Ritorna una vista (senza copia) sulla sotto-Matrice3D negli
+                     intervalli di coordinate z1..z2, y1..y2 e x1..x2.
+                     Le scritture sulla vista modificano questa matrice.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Matrice3DView sui dati della matrice
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3DView<T, Cmp> view(int z1, int z2, int y1, int y2, int x1, int x2) {
+        return view().slice(z1, z2, y1, y2, x1, x2);
+    }
+
+    /**
+        Metodo view: Ritorna una vista in sola lettura (senza copia) sulla sotto-Matrice3D
+                     negli intervalli di coordinate z1..z2, y1..y2 e x1..x2.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Matrice3DView in sola lettura sui dati della matrice
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3DView<const T, Cmp> view(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        return view().slice(z1, z2, y1, y2, x1, x2);
+    }
+
+    /**
+        Metodo row: Ritorna la riga (z, y), ovvero gli elementi con x = 0..sizeX()-1,
+                    come intervallo contiguo (iteratori T*) senza copia.
+
+        @return row_range sugli elementi della riga
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate fuori range
+    */
+    row_range row(int z, int y) {
+        static_assert(Layout::contiguous, "row() richiede il layout row-major");
+        check_axis(z < 0 || z >= (int)_sizeZ || y < 0 || y >= (int)_sizeY);
+        return row_range(_matrix + offsetZ(z) + offsetY(y), _sizeX);
+    }
+
+    const_row_range row(int z, int y) const {
+        static_assert(Layout::contiguous, "row() richiede il layout row-major");
+        check_axis(z < 0 || z >= (int)_sizeZ || y < 0 || y >= (int)_sizeY);
+        return const_row_range(_matrix + offsetZ(z) + offsetY(y), _sizeX);
+    }
+
+    /**
+        Metodo col: Ritorna la colonna (z, x), ovvero gli elementi con y = 0..sizeY()-1,
+                    con passo strideY() e iteratori random access.
+
+        @return axis_range sugli elementi della colonna
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate fuori range
+    */
+    axis_range col(int z, int x) {
+        static_assert(Layout::contiguous, "col() richiede il layout row-major");
+        check_axis(z < 0 || z >= (int)_sizeZ || x < 0 || x >= (int)_sizeX);
+        return axis_range(Matrice3DStrideIterator<T>(_matrix + offsetZ(z) + x, _strideY), _sizeY);
+    }
+
+    const_axis_range col(int z, int x) const {
+        static_assert(Layout::contiguous, "col() richiede il layout row-major");
+        check_axis(z < 0 || z >= (int)_sizeZ || x < 0 || x >= (int)_sizeX);
+        return const_axis_range(Matrice3DStrideIterator<const T>(_matrix + offsetZ(z) + x, _strideY), _sizeY);
+    }
+
+    /**
+        Metodo pillar: Ritorna il pilastro (y, x), ovvero gli elementi con z = 0..sizeZ()-1,
+                       con passo strideZ() e iteratori random access.
+
+        @return axis_range sugli elementi del pilastro
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate fuori range
+    */
+    axis_range pillar(int y, int x) {
+        static_assert(Layout::contiguous, "pillar() richiede il layout row-major");
+        check_axis(y < 0 || y >= (int)_sizeY || x < 0 || x >= (int)_sizeX);
+        return axis_range(Matrice3DStrideIterator<T>(_matrix + offsetY(y) + x, _strideZ), _sizeZ);
+    }
+
+    const_axis_range pillar(int y, int x) const {
+        static_assert(Layout::contiguous, "pillar() richiede il layout row-major");
+        check_axis(y < 0 || y >= (int)_sizeY || x < 0 || x >= (int)_sizeX);
+        return const_axis_range(Matrice3DStrideIterator<const T>(_matrix + offsetY(y) + x, _strideZ), _sizeZ);
+    }
+
+    /**
+        Metodi plane, plane_y e plane_x: Ritornano una vista (senza copia) sul piano
+                 z, y o x fissato, con dimensione 1 lungo quell'asse. Le righe, colonne e
+                 pilastri del piano sono disponibili con row(), col() e pillar() della vista.
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinata fuori range
+    */
+    Matrice3DView<T, Cmp> plane(int z) { return view(z, z, 0, (int)_sizeY - 1, 0, (int)_sizeX - 1); }
+    Matrice3DView<T, Cmp> plane_y(int y) { return view(0, (int)_sizeZ - 1, y, y, 0, (int)_sizeX - 1); }
+    Matrice3DView<T, Cmp> plane_x(int x) { return view(0, (int)_sizeZ - 1, 0, (int)_sizeY - 1, x, x); }
+    Matrice3DView<const T, Cmp> plane(int z) const { return view(z, z, 0, (int)_sizeY - 1, 0, (int)_sizeX - 1); }
+    Matrice3DView<const T, Cmp> plane_y(int y) const { return view(0, (int)_sizeZ - 1, y, y, 0, (int)_sizeX - 1); }
+    Matrice3DView<const T, Cmp> plane_x(int x) const { return view(0, (int)_sizeZ - 1, 0, (int)_sizeY - 1, x, x); }
+
     /**
         Metodo slice: Ritorna una sotto-Matrice3D contenente i valori negli intervalli di coordinate z1..z2,
-                      y1..y2 e x1..x2.
+                      y1..y2 e x1..x2. A differenza di view() i valori vengono copiati
+                      in una nuova matrice.
 
         @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
 
@@ -327,27 +1196,24 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
     */
     Matrice3D slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
-        // Controllo gli intervalli nel caso siano invertiti
-        if(z1 > z2 || y1 > y2 || x1 > x2) 
+        M3D_STATS_SCOPE(m3dOpSlice, z1 <= z2 && y1 <= y2 && x1 <= x2 ?
+                        std::uint64_t(z2 - z1 + 1) * (y2 - y1 + 1) * (x2 - x1 + 1) * sizeof(T) : 0);
+        // Controllo degli intervalli delegato alla vista, poi copio una sola volta
+        if constexpr (Layout::contiguous)
+            return view(z1, z2, y1, y2, x1, x2).template materialize<Matrice3D>(_alloc);
+        if(z1 > z2 || y1 > y2 || x1 > x2)
             throw Matrice3DInvalidParameters("ERRORE: Parametri forniti invalidi");
-        // Controllo che gli intervalli siano validi
         if(z1 < 0 || z2 >= _sizeZ || y1 < 0 || y2 >= _sizeY || x1 < 0 || x2 >= _sizeX)
             throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
-        
-        // Aggiungo 1 per l'index che parte da 0
-        // Es. una matrice 3x3x3, con input (0, 1, 0, 2, 0, 1) ritorna una matrice 2x3x2
-        // quindi otteniamo: z2 - z1 + 1 = 2, y2 - y1 + 1 = 3, x2 - x1 + 1 = 2
-        Matrice3D sliced(z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1);
-        // Ciclo partendo dalle coordinate indicate (le più piccole) e
-        // prendo tutto quello che ho in mezzo (fino alle coordinate più grandi)   
-        for(int i = z1; i <= z2; i++)
-            for(int j = y1; j <= y2; j++)
-                for(int k = x1; k <= x2; k++)
-                    // Sottraggo z1, y1 e x1 perchè cosi posso partire da 0 per i tre punti
-                    // e a salire, senza lasciare "buchi" nella matrice
-                    sliced(i - z1, j - y1, k - x1) = this->operator()(i, j, k);
-        
-        return sliced;
+        Matrice3D res(z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1, _alloc);
+        for (unsigned int i = 0; i < res._sizeZ; i++)
+            for (unsigned int j = 0; j < res._sizeY; j++) {
+                std::size_t src = offsetZ(z1 + i) + offsetY(y1 + j);
+                std::size_t dst = res.offsetZ(i) + res.offsetY(j);
+                for (unsigned int k = 0; k < res._sizeX; k++)
+                    res._matrix[dst + res.offsetX(k)] = _matrix[src + offsetX(x1 + k)];
+            }
+        return res;
     }
     
     /**
@@ -360,22 +1226,100 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
 
     */
     bool operator==(const Matrice3D &other) const {
+        M3D_STATS_SCOPE(m3dOpEqual, _size * sizeof(T));
         // Se le dimensioni sono diverse ritorna false (confronto le singole dimensioni
         // in quanto 2x3x2 può risultare uguale a 3x2x2 altrimenti)
         if (_sizeX != other._sizeX || _sizeY != other._sizeY || _sizeZ != other._sizeZ)
             return false;
-        // Altrimenti ciclo su tutti gli elementi e controllo se sono uguali con il funtore
-        for (int i = 0; i < _size; i++)
-            if (!(_cmp(_matrix[i], other._matrix[i])))
-                return false;
-        // Se non entro nel if ritorno true
-        return true;
+        // Layout non contiguo: confronto nell'ordine degli iteratori, saltando il riempimento
+        if constexpr (!Layout::contiguous && !buffer_compare)
+            return std::equal(begin(), end(), other.begin(), _cmp);
+        return equal_range(other, 0, storage_size());
+    }
+
+    /**
+        Metodo equals: come l'operatore ==, con politica di esecuzione.
+                       Con m3dPar(pool) i blocchi di piani vengono confrontati in
+                       parallelo, a tratti di 64K elementi: dopo ogni tratto il blocco
+                       controlla se un altro ha gia' trovato una differenza e in quel
+                       caso si ferma, cosi' le matrici diverse non vengono lette per intero.
+
+        @param other Matrice3D da confrontare
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+        @return true se le due Matrici3D contengono gli stessi valori, false altrimenti
+    */
+    bool equals(const Matrice3D &other, const m3dSeqPolicy &) const {
+        return *this == other;
+    }
+
+    bool equals(const Matrice3D &other, const m3dParPolicy &policy) const {
+        if constexpr (!Layout::contiguous && !buffer_compare)
+            return *this == other;
+        M3D_STATS_SCOPE(m3dOpEqual, _size * sizeof(T));
+        if (_sizeX != other._sizeX || _sizeY != other._sizeY || _sizeZ != other._sizeZ)
+            return false;
+        std::atomic<bool> diverse(false);
+        m3dForBlocks(policy, storage_size(), _strideZ, [&](std::size_t b, std::size_t e) {
+            for (std::size_t s = b; s < e && !diverse.load(std::memory_order_relaxed); s += compare_slice)
+                if (!equal_range(other, s, std::min(e, s + compare_slice)))
+                    diverse.store(true, std::memory_order_relaxed);
+        });
+        return !diverse.load();
+    }
+
+    /**
+        Metodo hash: impronta a 64 bit del contenuto, per riconoscere i volumi duplicati
+                     senza confrontarli elemento per elemento. Matrici con le stesse
+                     dimensioni e uguali secondo == hanno lo stesso hash (per i floating
+                     point -0 e +0 sono equivalenti); hash uguali non garantiscono
+                     l'uguaglianza, va confermata con ==.
+
+                     Il buffer viene diviso in tratti di 64K elementi: con m3dPar(pool)
+                     gli hash dei tratti sono calcolati in parallelo e combinati nello
+                     stesso ordine, quindi il risultato non dipende dalla politica.
+
+                     Il valore non viene tenuto in cache: ogni chiamata rilegge il buffer,
+                     quindi vale anche dopo scritture fatte con puntatori, iteratori o
+                     viste, e piu' thread possono chiamare hash() sulla stessa matrice.
+                     Per scartare in O(1) i duplicati chi confronta molte matrici conserva
+                     gli hash calcolati una volta e chiama == solo se coincidono.
+
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+        @return hash del contenuto e delle dimensioni
+    */
+    template <class Policy = m3dSeqPolicy>
+    std::uint64_t hash(const Policy &policy = m3dSeq) const {
+        static_assert(m3dHashable<T>::value, "hash(): tipo non supportato (vedi m3dBitwiseEqual)");
+        M3D_STATS_SCOPE(m3dOpHash, storage_size() * sizeof(T));
+        std::uint64_t h = m3dHashCombine(m3dHashCombine(m3dHashCombine(0, _sizeZ), _sizeY), _sizeX);
+        std::size_t n = storage_size(), chunks = (n + m3dHashChunk - 1) / m3dHashChunk;
+        auto chunk = [&](std::size_t c) {
+            std::size_t b = c * m3dHashChunk;
+            return m3dHashElements(_matrix + b, std::min(m3dHashChunk, n - b), c);
+        };
+        if constexpr (std::is_same<Policy, m3dParPolicy>::value) {
+            std::vector<std::uint64_t> parziali(chunks);
+            m3dForBlocks(policy, chunks, 1, [&](std::size_t b, std::size_t e) {
+                for (std::size_t c = b; c < e; c++)
+                    parziali[c] = chunk(c);
+            });
+            for (std::size_t c = 0; c < chunks; c++)
+                h = m3dHashCombine(h, parziali[c]);
+        } else
+            for (std::size_t c = 0; c < chunks; c++)
+                h = m3dHashCombine(h, chunk(c));
+        return h;
     }
 
     /**
         Metodo fill: Riempie la Matrice3D con valori presi da una sequenza di dati identificata da
                      iteratori generici. Il riempimento avviene nell’ordine di iterazione
-                     dei dati della matrice. I vecchi valori saranno sovrascritti
+                     dei dati della matrice. I vecchi valori saranno sovrascritti; se la
+                     sequenza e' piu' corta della matrice gli elementi restanti non cambiano.
+                     Da puntatori allo stesso tipo banalmente copiabile la copia avviene
+                     in blocco (anche se la sorgente si sovrappone alla matrice).
 
         @param it, ite ovvero Iteratori generici che identificano la sequenza di dati
 
@@ -384,18 +1328,97 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
     */
     template <typename Iter>
     void fill(Iter it, Iter ite) {
+        M3D_STATS_SCOPE(m3dOpFill, _size * sizeof(T));
+        typedef typename std::remove_cv<typename std::remove_pointer<Iter>::type>::type V;
+        // Sorgente contigua dello stesso tipo banalmente copiabile: copia in blocco
+        // (memmove, la sorgente puo' sovrapporsi alla matrice stessa)
+        if constexpr (Layout::contiguous && std::is_pointer<Iter>::value && std::is_same<V, T>::value &&
+                      std::is_trivially_copyable<T>::value) {
+            if (ite > it)
+                std::memmove(static_cast<void *>(_matrix), it,
+                             std::min<std::size_t>(ite - it, _size) * sizeof(T));
+            return;
+        }
+        // Sorgente contigua di tipo aritmetico: conversione vettoriale in blocco
+        else if constexpr (Layout::contiguous && std::is_pointer<Iter>::value && std::is_arithmetic<T>::value &&
+                           std::is_arithmetic<V>::value) {
+            std::size_t n = 0;
+            if (ite > it)
+                n = (std::size_t)(ite - it) < _size ? (std::size_t)(ite - it) : _size;
+            Matrice3DSimd::convert(_matrix, it, n);
+            return;
+        }
         // Ciclo su tutta la matrice
         // Try catch perchè l'assegnamento potrebbe fallire
         try{
-            for (int i = 0; i < _size; i++) {
-                // Se l'iterator è diverso dall'iterator finale
-                // inserisco il dato dall'iterator
-                // Casto il dato in T perchè l'iterator è generico
-                if(it != ite){
-                    _matrix[i] = static_cast<T>(*it);
-                    it++;
-                }
+            if constexpr (!Layout::contiguous) {
+                // Layout non contiguo: scrivo nell'ordine degli iteratori della matrice
+                for (iterator o = begin(), oe = end(); o != oe && it != ite; ++o, ++it)
+                    *o = static_cast<T>(*it);
+            }
+            else
+            // Mi fermo quando la sequenza finisce (gli elementi successivi restano invariati)
+            // Casto il dato in T perchè l'iterator è generico
+            for (std::size_t i = 0; i < _size && it != ite; i++, ++it)
+                _matrix[i] = static_cast<T>(*it);
+        } catch (...) {
+            std::cerr << "ERRORE: Fill fallito." << std::endl; 
+            clear();
+            throw Matrice3DError("ERRORE: Fill fallito.");
+        }
+    }
+
+    /**
+        Metodo fill con politica di esecuzione. Con m3dPar(pool) gli iteratori devono
+        essere random access: i blocchi di piani vengono riempiti in parallelo leggendo
+        it[i], con lo stesso risultato della versione sequenziale. Con un layout non
+        contiguo il riempimento e' sequenziale.
+
+        @param it, ite Iteratori che identificano la sequenza di dati
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+        @throw Matrice3DError possibile eccezione di riempimento fallito
+    */
+    template <typename Iter>
+    void fill(Iter it, Iter ite, const m3dSeqPolicy &) {
+        fill(it, ite);
+    }
+
+    template <typename Iter>
+    void fill(Iter it, Iter ite, const m3dParPolicy &policy) {
+        static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                      typename std::iterator_traits<Iter>::iterator_category>::value,
+                      "fill parallelo: servono iteratori random access");
+        if constexpr (!Layout::contiguous) {
+            fill(it, ite);
+            return;
+        }
+        std::size_t n = 0;
+        if (ite > it)
+            n = (std::size_t)(ite - it) < _size ? (std::size_t)(ite - it) : _size;
+        T *dst = _matrix;
+        typedef typename std::remove_cv<typename std::remove_pointer<Iter>::type>::type V;
+        if constexpr (std::is_pointer<Iter>::value && std::is_same<V, T>::value) {
+            // Sorgente sovrapposta alla matrice: i blocchi non sono indipendenti
+            std::less<const T *> prima;
+            if (n > 0 && prima(it, dst + n) && prima(dst, it + n)) {
+                fill(it, ite);
+                return;
             }
+        }
+        M3D_STATS_SCOPE(m3dOpFill, _size * sizeof(T));
+        try {
+            m3dForBlocks(policy, n, _strideZ, [&](std::size_t b, std::size_t e) {
+                if constexpr (std::is_pointer<Iter>::value && std::is_same<V, T>::value &&
+                              std::is_trivially_copyable<T>::value)
+                    std::memcpy(static_cast<void *>(dst + b), it + b, (e - b) * sizeof(T));
+                else if constexpr (std::is_pointer<Iter>::value && std::is_arithmetic<T>::value &&
+                                   std::is_arithmetic<V>::value)
+                    Matrice3DSimd::convert(dst + b, it + b, e - b);
+                else
+                    for (std::size_t i = b; i < e; i++)
+                        dst[i] = static_cast<T>(it[i]);
+            });
         } catch (...) {
             std::cerr << "ERRORE: Fill fallito." << std::endl; 
             clear();
@@ -413,26 +1436,268 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
             e di scorrimento dell'iteratore. (per sapere come implementare il begin e end).
             I traits sono derivati automaticamente in quanto l'iteratore è un alias di un
             puntatore (T*).
+            Con un layout non contiguo l'iteratore e' un forward iterator (layout_iterator)
+            che visita gli elementi nello stesso ordine (x, poi y, poi z).
     
     */
-    typedef T* iterator;
-    typedef const T* const_iterator;
+    template <class V> class layout_iterator;
+
+    typedef typename std::conditional<Layout::contiguous, T*, layout_iterator<T> >::type iterator;
+    typedef typename std::conditional<Layout::contiguous, const T*, layout_iterator<const T> >::type const_iterator;
 
     // Metodi membro begin() e end() per l'iterazione
     iterator begin() {
-        return iterator(_matrix);
+        if constexpr (Layout::contiguous)
+            return iterator(_matrix);
+        else
+            return iterator(this, _matrix, 0);
     }
     iterator end() {
-        return iterator(_matrix + _size);
+        if constexpr (Layout::contiguous)
+            return iterator(_matrix + _size);
+        else
+            return iterator(this, _matrix, _size);
     }
 
     // Metodi membro begin() e end() per l'iterazione (const)
     const_iterator begin() const {
-        return const_iterator(_matrix);
+        if constexpr (Layout::contiguous)
+            return const_iterator(_matrix);
+        else
+            return const_iterator(this, _matrix, 0);
     }
     const_iterator end() const {
-        return const_iterator(_matrix + _size);
+        if constexpr (Layout::contiguous)
+            return const_iterator(_matrix + _size);
+        else
+            return const_iterator(this, _matrix, _size);
+    }
+
+    /**
+     @brief Forward iterator dei layout non contigui
+
+            Mantiene le coordinate correnti e l'offset della riga, cosi' l'avanzamento
+            calcola solo l'offset della colonna (e quello della riga a fine riga).
+    */
+    template <class V> class layout_iterator {
+        template <class> friend class layout_iterator;
+
+        const Matrice3D *_m; ///< matrice su cui si itera
+        V *_base; ///< buffer della matrice
+        std::size_t _row; ///< offsetZ(z) + offsetY(y) della riga corrente
+        unsigned int _x; ///< colonna corrente
+        unsigned int _y; ///< riga corrente
+        unsigned int _z; ///< piano corrente
+        std::size_t _i; ///< posizione lineare corrente
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef V* pointer;
+        typedef V& reference;
+
+        layout_iterator() : _m(nullptr), _base(nullptr), _row(0), _x(0), _y(0), _z(0), _i(0) {}
+        layout_iterator(const Matrice3D *m, V *base, std::size_t i) : _m(m), _base(base), _row(0), _x(0), _y(0), _z(0), _i(i) {}
+
+        // Conversione da iterator a const_iterator
+        template <class W, typename = typename std::enable_if<std::is_same<const W, V>::value>::type>
+        layout_iterator(const layout_iterator<W> &other)
+            : _m(other._m), _base(other._base), _row(other._row), _x(other._x), _y(other._y), _z(other._z), _i(other._i) {}
+
+        reference operator*() const { return _base[_row + _m->_layout.offsetX(_x)]; }
+        pointer operator->() const { return &**this; }
+
+        layout_iterator& operator++() {
+            ++_i;
+            // Fine riga: passo alla riga successiva, e a fine piano al piano successivo
+            if (++_x == _m->_sizeX) {
+                _x = 0;
+                if (++_y == _m->_sizeY) {
+                    _y = 0;
+                    ++_z;
+                }
+                _row = _m->_layout.offsetZ(_z) + _m->_layout.offsetY(_y);
+            }
+            return *this;
+        }
+        layout_iterator operator++(int) { layout_iterator tmp(*this); ++(*this); return tmp; }
+
+        bool operator==(const layout_iterator &other) const { return _i == other._i; }
+        bool operator!=(const layout_iterator &other) const { return _i != other._i; }
+    };
+
+    private:
+
+    /**
+        Posizione nel buffer dell'elemento (z, y, x)
+    */
+    std::size_t offset(int z, int y, int x) const {
+        if constexpr (Layout::contiguous)
+            return z * _strideZ + y * _strideY + x;
+        else
+            return _layout.offsetZ(z) + _layout.offsetY(y) + _layout.offsetX(x);
     }
+
+    // Contributi separati di piano, riga e colonna alla posizione nel buffer
+    std::size_t offsetZ(unsigned int z) const {
+        if constexpr (Layout::contiguous)
+            return std::size_t(z) * _strideZ;
+        else
+            return _layout.offsetZ(z);
+    }
+    std::size_t offsetY(unsigned int y) const {
+        if constexpr (Layout::contiguous)
+            return std::size_t(y) * _strideY;
+        else
+            return _layout.offsetY(y);
+    }
+    std::size_t offsetX(unsigned int x) const {
+        if constexpr (Layout::contiguous)
+            return x;
+        else
+            return _layout.offsetX(x);
+    }
+
+    // Coordinate di row(), col() e pillar(): controllate sempre, come per view()
+    static void check_axis(bool outside) {
+        if (outside)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+    }
+
+    /**
+        Prepara layout per un volume z * y * x e ritorna il numero di elementi del buffer
+
+        @throw Matrice3DOutOfRange se il buffer supererebbe limit elementi
+    */
+    static std::size_t layout_storage(Layout &layout, unsigned int z, unsigned int y, unsigned int x,
+                                      std::size_t limit) {
+        std::size_t n = m3dVolume(z, y, x, limit);
+        if constexpr (!Layout::contiguous) {
+            // I layout saturano capacity() invece di andare in overflow
+            layout.resize(z, y, x);
+            n = layout.capacity();
+            if (n > limit)
+                throw Matrice3DOutOfRange("ERRORE: Dimensioni della matrice troppo grandi");
+        }
+        return n;
+    }
+
+    /**
+        Copia in this (convertendo a T) gli elementi di other, che ha le stesse dimensioni
+        e un layout diverso. Il volume viene percorso a blocchi di 8 x 8 x 8 elementi:
+        ogni blocco occupa poche linee di cache in entrambi i layout.
+    */
+    template <class M>
+    void relayout_from(const M &other) {
+        const unsigned int B = 8;
+        const typename M::value_type *src = other._matrix;
+        for (unsigned int z0 = 0; z0 < _sizeZ; z0 += B)
+            for (unsigned int y0 = 0; y0 < _sizeY; y0 += B)
+                for (unsigned int x0 = 0; x0 < _sizeX; x0 += B) {
+                    unsigned int z1 = z0 + B < _sizeZ ? z0 + B : _sizeZ;
+                    unsigned int y1 = y0 + B < _sizeY ? y0 + B : _sizeY;
+                    unsigned int x1 = x0 + B < _sizeX ? x0 + B : _sizeX;
+                    for (unsigned int z = z0; z < z1; z++)
+                        for (unsigned int y = y0; y < y1; y++) {
+                            std::size_t d = offsetZ(z) + offsetY(y);
+                            std::size_t s = other.offsetZ(z) + other.offsetY(y);
+                            for (unsigned int x = x0; x < x1; x++)
+                                _matrix[d + offsetX(x)] = static_cast<T>(src[s + other.offsetX(x)]);
+                        }
+                }
+    }
+
+    /**
+        Alloca (senza costruire) un buffer di n elementi
+    */
+    T *allocate_storage(std::size_t n) {
+        M3D_STATS_EVENT(m3dOpAlloc, n * sizeof(T));
+        return alloc_traits::allocate(_alloc, n);
+    }
+
+    /**
+        Alloca n elementi non inizializzati e li costruisce uno ad uno con build(p, i).
+        Se una costruzione fallisce distrugge gli elementi gia' costruiti, libera la
+        memoria e rilancia l'eccezione, lasciando _matrix invariato.
+    */
+    template <typename Build>
+    void build_storage(std::size_t n, Build build) {
+        if (n == 0)
+            return;
+        T *p = allocate_storage(n);
+        std::size_t i = 0;
+        try {
+            for (; i < n; i++)
+                build(p + i, i);
+        }
+        catch (...) {
+            destroy_range(p, i);
+            alloc_traits::deallocate(_alloc, p, n);
+            throw;
+        }
+        _matrix = p;
+    }
+
+    /**
+        Alloca _matrix con la copia dei primi n elementi di src. I tipi banalmente
+        copiabili vengono copiati in blocco con memcpy; per i tipi che non lanciano
+        eccezioni nella copia non serve la gestione della costruzione parziale.
+    */
+    void copy_storage(const T *src, std::size_t n) {
+        if (n == 0)
+            return;
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            _matrix = allocate_storage(n);
+            std::memcpy(static_cast<void *>(_matrix), src, n * sizeof(T));
+        }
+        else if constexpr (std::is_nothrow_copy_constructible<T>::value) {
+            T *p = allocate_storage(n);
+            for (std::size_t i = 0; i < n; i++)
+                alloc_traits::construct(_alloc, p + i, src[i]);
+            _matrix = p;
+        }
+        else
+            build_storage(n, [&](T *p, std::size_t i) {
+                alloc_traits::construct(_alloc, p, src[i]);
+            });
+    }
+
+    /**
+        Distrugge i primi n elementi di p (nulla da fare per i tipi banali)
+    */
+    void destroy_range(T *p, std::size_t n) {
+        if (!std::is_trivially_destructible<T>::value)
+            for (std::size_t i = 0; i < n; i++)
+                alloc_traits::destroy(_alloc, p + i);
+    }
+};
+
+/**
+    @brief Trait che riconosce i funtori "vettoriali": oltre a operator() espongono
+           apply(Q *dst, const T *src, n), che trasforma n elementi contigui in blocco.
+*/
+template <class F, class Q, class T, class = void> struct m3dHasApply {
+    static const bool value = false;
+};
+
+template <class F, class Q, class T>
+struct m3dHasApply<F, Q, T, decltype(std::declval<const F &>().apply((Q *)nullptr, (const T *)nullptr, std::size_t()))> {
+    static const bool value = true;
+};
+
+/**
+    @brief Funtore di clamp: limita un valore all'intervallo [lo, hi]
+
+    Usato con trasform sfrutta i kernel vettoriali di Matrice3DSimd.
+    Es. trasform<float>(A, m3dClamp<float>(0.0f, 1.0f))
+*/
+template <class T> struct m3dClamp {
+    T lo; ///< limite inferiore
+    T hi; ///< limite superiore
+    m3dClamp(T lo, T hi) : lo(lo), hi(hi) {}
+    T operator()(T v) const { return v < lo ? lo : (hi < v ? hi : v); }
+    void apply(T *dst, const T *src, std::size_t n) const { Matrice3DSimd::clamp(dst, src, lo, hi, n); }
 };
 
 /**
@@ -440,24 +1705,243 @@ template <class T, class Cmp = defaultCmp> class Matrice3D
     ritorna una nuova Matrice3D B (su tipi Q) i cui elementi sono ottenuti applicando il funtore agli
     elementi di A: B(i,j,k) = F(A(i,j,k))
 
+    Il risultato viene scritto direttamente in B in un unico passaggio, con una sola
+    allocazione (quella di B) e senza copie intermedie di A.
+
     @param A Matrice3D su tipi T, F funtore generico
     
     @return Matrice3D B su tipi Q con il funtore applicato
 
 */
-template <typename Q, typename FQ = defaultCmp, typename T, typename FT, typename F>
-Matrice3D<Q, FQ> trasform(const Matrice3D<T, FT> &A, F funz) {
-    // Variabile di appoggio per non modificare A
-    Matrice3D<T, FT> tmp(A); 
-    typename Matrice3D<T, FT>::iterator i, ie;
-    // Applico il funtore funz a tutti gli elementi di tmp (copia di A)
-    for (i = tmp.begin(), ie = tmp.end(); i != ie; ++i) 
-        *i = funz(*i);
-    // Converto in Q e il suo funtore di confronto
-    Matrice3D<Q, FQ> B(tmp); 
+template <typename Q, typename FQ = defaultCmp, typename T, typename... PT, typename F>
+Matrice3D<Q, FQ> trasform(const Matrice3D<T, PT...> &A, F funz) {
+    M3D_STATS_SCOPE(m3dOpTrasform, A.size() * sizeof(T));
+    // Matrice vuota: non c'e' nulla da allocare
+    if (A.size() == 0)
+        return Matrice3D<Q, FQ>();
+    Matrice3D<Q, FQ> B(A.sizeZ(), A.sizeY(), A.sizeX());
+    // Funtore con versione vettoriale (es. m3dClamp): lo applico all'intero buffer
+    if constexpr (m3dHasApply<F, Q, T>::value && Matrice3D<T, PT...>::layout_type::contiguous) {
+        funz.apply(B.data(), A.data(), A.size());
+        return B;
+    }
+    typename Matrice3D<T, PT...>::const_iterator i = A.begin(), ie = A.end();
+    typename Matrice3D<Q, FQ>::iterator o = B.begin();
+    // Applico il funtore funz agli elementi di A e converto in Q
+    for (; i != ie; ++i, ++o)
+        *o = static_cast<Q>(funz(*i));
+    return B;
+}
+
+/**
+    Metodo GLOBALE transform con politica di esecuzione sequenziale: equivale a trasform(A, funz).
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, typename... PT, typename F>
+Matrice3D<Q, FQ> trasform(const Matrice3D<T, PT...> &A, F funz, const m3dSeqPolicy &) {
+    return trasform<Q, FQ>(A, funz);
+}
+
+/**
+    Metodo GLOBALE transform con politica di esecuzione parallela: i blocchi di piani z
+    di A vengono trasformati in parallelo sul pool. Il funtore viene chiamato da piu'
+    thread contemporaneamente, quindi non deve modificare uno stato condiviso.
+    Il risultato e' identico a quello di trasform(A, funz). Se A ha un layout non
+    contiguo la trasformazione e' sequenziale.
+
+    @param A Matrice3D su tipi T, F funtore generico, policy politica m3dPar(pool)
+
+    @return Matrice3D B su tipi Q con il funtore applicato
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, typename... PT, typename F>
+Matrice3D<Q, FQ> trasform(const Matrice3D<T, PT...> &A, F funz, const m3dParPolicy &policy) {
+    if constexpr (!Matrice3D<T, PT...>::layout_type::contiguous)
+        return trasform<Q, FQ>(A, funz);
+    M3D_STATS_SCOPE(m3dOpTrasform, A.size() * sizeof(T));
+    if (A.size() == 0)
+        return Matrice3D<Q, FQ>();
+    Matrice3D<Q, FQ> B(A.sizeZ(), A.sizeY(), A.sizeX());
+    const T *in = A.data();
+    Q *out = B.data();
+    m3dForBlocks(policy, A.size(), A.strideZ(), [&](std::size_t b, std::size_t e) {
+        if constexpr (m3dHasApply<F, Q, T>::value)
+            funz.apply(out + b, in + b, e - b);
+        else
+            for (std::size_t i = b; i < e; i++)
+                out[i] = static_cast<Q>(funz(in[i]));
+    });
     return B;
 }
 
+/**
+    @brief Trait di trasform a piu' ingressi: la versione vettoriale apply() del funtore
+           si usa solo con un ingresso (vedi m3dHasApply).
+*/
+template <class F, class Q, class... T> struct m3dTrasformApply {
+    static const bool value = false;
+};
+
+template <class F, class Q, class T> struct m3dTrasformApply<F, Q, T> : m3dHasApply<F, Q, T> {};
+
+/**
+    Trasforma gli elementi in [b, e) dei buffer in: out[i] = F(in[i]...). I buffer arrivano
+    come parametri, cosi' il compilatore non deve rileggerli dopo ogni scrittura in out.
+*/
+template <typename Q, typename F, typename... T>
+void m3dTrasformRange(Q *out, F &funz, std::size_t b, std::size_t e, const T *... in) {
+    if constexpr (m3dTrasformApply<F, Q, T...>::value)
+        funz.apply(out + b, (in + b)..., e - b);
+    else
+        for (std::size_t i = b; i < e; i++)
+            out[i] = static_cast<Q>(funz(in[i]...));
+}
+
+/**
+    Scrive in B gli elementi F(A(i,j,k), ...) delle matrici di ingresso A..., in un unico
+    passaggio. Le dimensioni vengono controllate una sola volta; B viene riallocata solo
+    se le sue dimensioni sono diverse da quelle degli ingressi, quindi un B gia' pronto
+    non costa allocazioni. B puo' coincidere con uno degli ingressi.
+    Con i layout non contigui il ciclo e' sulle coordinate e sequenziale.
+
+    @throw Matrice3DInvalidParameters possibile eccezione di dimensioni diverse
+*/
+template <typename Q, typename... PQ, typename F, class Policy, class M, class... R>
+void m3dTrasformInto(Matrice3D<Q, PQ...> &B, F &funz, const Policy &policy, const M &A, const R &... altre) {
+    typedef Matrice3D<Q, PQ...> Out;
+    unsigned int z = A.sizeZ(), y = A.sizeY(), x = A.sizeX();
+    bool uguali[] = { true, (altre.sizeZ() == z && altre.sizeY() == y && altre.sizeX() == x)... };
+    for (bool u : uguali)
+        if (!u)
+            throw Matrice3DInvalidParameters("ERRORE: Dimensioni delle matrici diverse");
+    M3D_STATS_SCOPE(m3dOpTrasform, A.size() * sizeof(typename M::value_type));
+    if (A.size() == 0) {
+        B.clear();
+        return;
+    }
+    if (B.sizeZ() != z || B.sizeY() != y || B.sizeX() != x)
+        B = Out(z, y, x, B.get_allocator());
+    if constexpr (Out::layout_type::contiguous && M::layout_type::contiguous &&
+                  (R::layout_type::contiguous && ...)) {
+        Q *out = B.data();
+        m3dForBlocks(policy, A.size(), A.strideZ(), [&](std::size_t b, std::size_t e) {
+            m3dTrasformRange(out, funz, b, e, A.data(), altre.data()...);
+        });
+    }
+    else
+        for (unsigned int k = 0; k < z; k++)
+            for (unsigned int j = 0; j < y; j++)
+                for (unsigned int i = 0; i < x; i++)
+                    B.at_unchecked(k, j, i) = static_cast<Q>(funz(A.at_unchecked(k, j, i), altre.at_unchecked(k, j, i)...));
+}
+
+/**
+    Metodo GLOBALE transform_inplace: sostituisce ogni elemento di M con F(M(i,j,k)),
+    riusando il buffer di M (nessuna allocazione). Con m3dPar(pool) i blocchi di piani
+    vengono trasformati in parallelo; i funtori vettoriali (es. m3dClamp) lavorano
+    direttamente sul buffer.
+
+    @param M Matrice3D da trasformare, F funtore generico, policy politica di esecuzione
+*/
+template <typename T, typename... PT, typename F, class Policy = m3dSeqPolicy>
+void trasform_inplace(Matrice3D<T, PT...> &M, F funz, const Policy &policy = m3dSeq) {
+    m3dTrasformInto(M, funz, policy, M);
+}
+
+/**
+    Metodo GLOBALE transform con matrice di uscita: B(i,j,k) = F(A(i,j,k)), scritto in una
+    B esistente. Se B ha gia' le dimensioni di A non viene allocato nulla: in una pipeline
+    la stessa B si puo' riusare a ogni fotogramma.
+
+    @param A Matrice3D su tipi T, F funtore generico, B Matrice3D di uscita,
+           policy politica di esecuzione
+*/
+template <typename Q, typename... PQ, typename T, typename... PT, typename F, class Policy = m3dSeqPolicy>
+void trasform(const Matrice3D<T, PT...> &A, F funz, Matrice3D<Q, PQ...> &B, const Policy &policy = m3dSeq) {
+    m3dTrasformInto(B, funz, policy, A);
+}
+
+/**
+    Metodi GLOBALI transform a due e tre ingressi: C(i,j,k) = F(A(i,j,k), B(i,j,k)) e
+    D(i,j,k) = F(A(i,j,k), B(i,j,k), C(i,j,k)). Le dimensioni vengono controllate una
+    volta, poi tutti gli ingressi sono letti in un unico ciclo fuso: nessuna matrice
+    intermedia e nessun accesso con l'operatore (). Le versioni con la matrice di uscita
+    come ultimo argomento matrice non allocano se ha gia' le dimensioni giuste.
+
+    @return Matrice3D su tipi Q con il funtore applicato
+
+    @throw Matrice3DInvalidParameters possibile eccezione di dimensioni diverse
+*/
+template <typename Q, typename FQ = defaultCmp, class Policy = m3dSeqPolicy,
+          typename T1, typename... P1, typename T2, typename... P2, typename F>
+Matrice3D<Q, FQ> trasform(const Matrice3D<T1, P1...> &A, const Matrice3D<T2, P2...> &B, F funz,
+                          const Policy &policy = m3dSeq) {
+    Matrice3D<Q, FQ> C;
+    m3dTrasformInto(C, funz, policy, A, B);
+    return C;
+}
+
+template <typename Q, typename FQ = defaultCmp, class Policy = m3dSeqPolicy, typename T1, typename... P1,
+          typename T2, typename... P2, typename T3, typename... P3, typename F>
+Matrice3D<Q, FQ> trasform(const Matrice3D<T1, P1...> &A, const Matrice3D<T2, P2...> &B,
+                          const Matrice3D<T3, P3...> &C, F funz, const Policy &policy = m3dSeq) {
+    Matrice3D<Q, FQ> D;
+    m3dTrasformInto(D, funz, policy, A, B, C);
+    return D;
+}
+
+template <typename Q, typename... PQ, typename T1, typename... P1, typename T2, typename... P2,
+          typename F, class Policy = m3dSeqPolicy>
+void trasform(const Matrice3D<T1, P1...> &A, const Matrice3D<T2, P2...> &B, F funz,
+              Matrice3D<Q, PQ...> &C, const Policy &policy = m3dSeq) {
+    m3dTrasformInto(C, funz, policy, A, B);
+}
+
+template <typename Q, typename... PQ, typename T1, typename... P1, typename T2, typename... P2,
+          typename T3, typename... P3, typename F, class Policy = m3dSeqPolicy>
+void trasform(const Matrice3D<T1, P1...> &A, const Matrice3D<T2, P2...> &B, const Matrice3D<T3, P3...> &C,
+              F funz, Matrice3D<Q, PQ...> &D, const Policy &policy = m3dSeq) {
+    m3dTrasformInto(D, funz, policy, A, B, C);
+}
+
+/**
+    Metodi GLOBALI transform a N ingressi: gli ingressi sono passati come tupla
+    (std::tie(A, B, C, D), o std::forward_as_tuple con matrici temporanee) e il funtore
+    riceve un elemento da ognuno, nell'ordine:
+    R(i,j,k) = F(A(i,j,k), B(i,j,k), C(i,j,k), D(i,j,k), ...). Come per due e tre
+    ingressi le dimensioni vengono controllate una volta e il ciclo e' unico; la
+    versione con la matrice di uscita non alloca se ha gia' le dimensioni giuste.
+
+    Es. trasform<float>(std::tie(A, B, C, D), funz, R, m3dPar(pool));
+
+    @return Matrice3D su tipi Q con il funtore applicato
+
+    @throw Matrice3DInvalidParameters possibile eccezione di dimensioni diverse
+*/
+template <typename Q, typename FQ = defaultCmp, class Policy = m3dSeqPolicy, typename... M, typename F>
+Matrice3D<Q, FQ> trasform(const std::tuple<M...> &ingressi, F funz, const Policy &policy = m3dSeq) {
+    static_assert(sizeof...(M) > 0, "trasform: serve almeno una matrice in ingresso");
+    Matrice3D<Q, FQ> R;
+    std::apply([&](const auto &... in) { m3dTrasformInto(R, funz, policy, in...); }, ingressi);
+    return R;
+}
+
+template <typename Q, typename... PQ, typename... M, typename F, class Policy = m3dSeqPolicy>
+void trasform(const std::tuple<M...> &ingressi, F funz, Matrice3D<Q, PQ...> &R, const Policy &policy = m3dSeq) {
+    static_assert(sizeof...(M) > 0, "trasform: serve almeno una matrice in ingresso");
+    std::apply([&](const auto &... in) { m3dTrasformInto(R, funz, policy, in...); }, ingressi);
+}
+
+#include "matrice3d_expr.h" // operatori aritmetici element-wise
+#include "matrice3d_io.h" // save, load, load_mapped
+#include "matrice3d_stream.h" // Matrice3DStream
+#include "matrice3d_stencil.h" // convolve, stencil
+#include "matrice3d_reduce.h" // sum, mean, minimum, maximum, argmin, argmax
+#include "matrice3d_sparse.h" // Matrice3DSparse
+#include "matrice3d_fixed.h" // Matrice3DFixed
+#include "matrice3d_permute.h" // permute, transpose, permuted_view
+#include "matrice3d_cow.h" // Matrice3DCow
+#include "matrice3d_compressed.h" // Matrice3DCompressed
+#include "matrice3d_pyramid.h" // Matrice3DPyramid
+
 #endif
 
 
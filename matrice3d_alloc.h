@@ -0,0 +1,204 @@
+#ifndef MATRICE3D_ALLOC_H
+#define MATRICE3D_ALLOC_H
+
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <new> // operator new allineato, bad_alloc
+#include <vector> // blocchi dell'arena
+
+/**
+    @brief Allocatore allineato di default della Matrice3D
+
+    Alloca memoria NON inizializzata allineata a Align byte (64 di default, ovvero
+    una linea di cache e la larghezza di un registro AVX-512). La costruzione degli
+    elementi e' lasciata alla Matrice3D, che la esegue solo dove serve.
+
+*/
+template <class T, std::size_t Align = 64> struct alignedAllocator {
+    typedef T value_type;
+
+    template <class U> struct rebind { typedef alignedAllocator<U, Align> other; };
+
+    alignedAllocator() noexcept {}
+    template <class U> alignedAllocator(const alignedAllocator<U, Align> &) noexcept {}
+
+    /**
+        Alloca lo spazio per n elementi di tipo T senza costruirli
+
+        @param n numero di elementi
+
+        @return puntatore allineato ad Align byte
+
+        @throw std::bad_alloc se la memoria non e' disponibile
+    */
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    /**
+        Libera lo spazio ottenuto con allocate()
+
+        @param p puntatore restituito da allocate()
+    */
+    void deallocate(T *p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <class U> bool operator==(const alignedAllocator<U, Align> &) const noexcept { return true; }
+    template <class U> bool operator!=(const alignedAllocator<U, Align> &) const noexcept { return false; }
+};
+
+/**
+    @brief Classe Matrice3DArena: arena di memoria a puntatore crescente (bump)
+
+    Pensata per le molte Matrice3D temporanee create durante l'elaborazione di un frame:
+    le allocazioni avanzano un puntatore dentro blocchi pre-allocati, le deallocazioni
+    non fanno nulla e reset() rende di nuovo disponibile tutta la memoria in O(1).
+    Quando un blocco e' pieno ne viene allocato uno nuovo, che resta all'arena e viene
+    riutilizzato dopo il reset: a regime un frame non esegue allocazioni di sistema.
+
+    Tutte le matrici allocate nell'arena devono essere distrutte prima di reset()
+    o della distruzione dell'arena. L'arena non e' thread-safe.
+
+*/
+class Matrice3DArena {
+    /// Blocco di memoria dell'arena
+    struct Block {
+        char *ptr; ///< inizio del blocco
+        std::size_t size; ///< dimensione del blocco in byte
+    };
+
+    std::vector<Block> _blocks; ///< blocchi allocati
+    std::size_t _blockSize; ///< dimensione minima di un nuovo blocco
+    std::size_t _current; ///< indice del blocco corrente
+    std::size_t _offset; ///< byte gia' usati nel blocco corrente
+
+    static const std::size_t blockAlign = 64; ///< allineamento di ogni blocco
+
+    public:
+
+    /**
+        Costruttore dell'arena
+
+        @param blockSize dimensione (in byte) dei blocchi allocati dall'arena
+
+        @post capacity() == blockSize
+    */
+    explicit Matrice3DArena(std::size_t blockSize = 1 << 20) : _blockSize(blockSize), _current(0), _offset(0) {
+        addBlock(blockSize);
+    }
+
+    /**
+        Distruttore: libera tutti i blocchi
+    */
+    ~Matrice3DArena() {
+        for (std::size_t i = 0; i < _blocks.size(); i++)
+            ::operator delete(_blocks[i].ptr, std::align_val_t(blockAlign));
+    }
+
+    Matrice3DArena(const Matrice3DArena &) = delete;
+    Matrice3DArena &operator=(const Matrice3DArena &) = delete;
+
+    /**
+        Riserva bytes byte allineati ad align (potenza di 2, al massimo 64)
+
+        @return puntatore alla memoria riservata
+
+        @throw std::bad_alloc se non e' possibile allocare un nuovo blocco
+    */
+    void *allocate(std::size_t bytes, std::size_t align) {
+        while (true) {
+            Block &b = _blocks[_current];
+            std::size_t start = (_offset + align - 1) & ~(align - 1);
+            if (start + bytes <= b.size) {
+                _offset = start + bytes;
+                return b.ptr + start;
+            }
+            // Il blocco corrente e' pieno: passo al successivo, se necessario lo creo
+            if (_current + 1 == _blocks.size())
+                addBlock(bytes > _blockSize ? bytes : _blockSize);
+            _current++;
+            _offset = 0;
+        }
+    }
+
+    /**
+        Le deallocazioni singole non liberano memoria: viene recuperata da reset()
+    */
+    void deallocate(void *, std::size_t) noexcept {}
+
+    /**
+        Rende di nuovo disponibile tutta la memoria dell'arena, senza liberare i blocchi
+
+        @post used() == 0
+    */
+    void reset() noexcept {
+        _current = 0;
+        _offset = 0;
+    }
+
+    /**
+        @return byte complessivamente allocati dall'arena
+    */
+    std::size_t capacity() const {
+        std::size_t c = 0;
+        for (std::size_t i = 0; i < _blocks.size(); i++)
+            c += _blocks[i].size;
+        return c;
+    }
+
+    /**
+        @return byte in uso (inclusi i blocchi precedenti a quello corrente)
+    */
+    std::size_t used() const {
+        std::size_t u = _offset;
+        for (std::size_t i = 0; i < _current; i++)
+            u += _blocks[i].size;
+        return u;
+    }
+
+    private:
+
+    void addBlock(std::size_t size) {
+        Block b;
+        b.ptr = static_cast<char *>(::operator new(size, std::align_val_t(blockAlign)));
+        b.size = size;
+        try {
+            _blocks.push_back(b);
+        }
+        catch (...) {
+            ::operator delete(b.ptr, std::align_val_t(blockAlign));
+            throw;
+        }
+    }
+};
+
+/**
+    @brief Allocatore che prende la memoria da una Matrice3DArena
+
+    Es. Matrice3D<float, defaultCmp, checkedAccess, arenaAllocator<float> > m(z, y, x, arenaAllocator<float>(arena));
+
+*/
+template <class T, std::size_t Align = 64> struct arenaAllocator {
+    typedef T value_type;
+
+    template <class U> struct rebind { typedef arenaAllocator<U, Align> other; };
+
+    Matrice3DArena *arena; ///< arena da cui allocare
+
+    arenaAllocator(Matrice3DArena &a) noexcept : arena(&a) {}
+    template <class U> arenaAllocator(const arenaAllocator<U, Align> &other) noexcept : arena(other.arena) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), Align > alignof(T) ? Align : alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U> bool operator==(const arenaAllocator<U, Align> &other) const noexcept { return arena == other.arena; }
+    template <class U> bool operator!=(const arenaAllocator<U, Align> &other) const noexcept { return arena != other.arena; }
+};
+
+#endif
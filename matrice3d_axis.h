@@ -0,0 +1,109 @@
+#ifndef MATRICE3D_AXIS_H
+#define MATRICE3D_AXIS_H
+
+#include <cstddef> // size_t, ptrdiff_t
+#include <iterator> // random_access_iterator_tag, iterator_traits
+#include <type_traits> // remove_const, enable_if, is_convertible
+
+/**
+    @brief Random access iterator con passo costante
+
+    Scorre gli elementi di un asse della Matrice3D (una colonna, un pilastro lungo z o
+    una riga di una vista) avanzando di stride elementi. L'iteratore tiene il puntatore
+    al primo elemento dell'asse e la posizione corrente: l'indirizzo viene calcolato solo
+    quando si accede all'elemento, cosi' end() e le posizioni fuori dall'asse (ad es.
+    prima del primo elemento nelle iterazioni all'indietro) non formano puntatori fuori
+    dal buffer. Gli iteratori confrontati o sottratti devono scorrere lo stesso asse.
+*/
+template <class V> class Matrice3DStrideIterator
+{
+    template <class> friend class Matrice3DStrideIterator;
+
+    V *_base; ///< primo elemento dell'asse
+    std::ptrdiff_t _stride; ///< distanza tra due elementi consecutivi
+    std::ptrdiff_t _index; ///< posizione corrente lungo l'asse
+
+    public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<V>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef V* pointer;
+    typedef V& reference;
+
+    Matrice3DStrideIterator() : _base(nullptr), _stride(1), _index(0) {}
+    Matrice3DStrideIterator(V *base, std::ptrdiff_t stride, std::ptrdiff_t index = 0)
+        : _base(base), _stride(stride), _index(index) {}
+
+    // Conversione da iteratore in scrittura a iteratore in sola lettura
+    template <class W, typename = typename std::enable_if<std::is_same<const W, V>::value>::type>
+    Matrice3DStrideIterator(const Matrice3DStrideIterator<W> &other)
+        : _base(other._base), _stride(other._stride), _index(other._index) {}
+
+    /// Puntatore all'elemento corrente (solo per posizioni interne all'asse)
+    V *base() const { return _base + _index * _stride; }
+    std::ptrdiff_t stride() const { return _stride; } ///< passo in elementi
+    std::ptrdiff_t index() const { return _index; } ///< posizione lungo l'asse
+
+    reference operator*() const { return _base[_index * _stride]; }
+    pointer operator->() const { return base(); }
+    reference operator[](difference_type n) const { return _base[(_index + n) * _stride]; }
+
+    Matrice3DStrideIterator& operator++() { ++_index; return *this; }
+    Matrice3DStrideIterator& operator--() { --_index; return *this; }
+    Matrice3DStrideIterator operator++(int) { Matrice3DStrideIterator tmp(*this); ++_index; return tmp; }
+    Matrice3DStrideIterator operator--(int) { Matrice3DStrideIterator tmp(*this); --_index; return tmp; }
+
+    Matrice3DStrideIterator& operator+=(difference_type n) { _index += n; return *this; }
+    Matrice3DStrideIterator& operator-=(difference_type n) { _index -= n; return *this; }
+    Matrice3DStrideIterator operator+(difference_type n) const { return Matrice3DStrideIterator(_base, _stride, _index + n); }
+    Matrice3DStrideIterator operator-(difference_type n) const { return Matrice3DStrideIterator(_base, _stride, _index - n); }
+    friend Matrice3DStrideIterator operator+(difference_type n, const Matrice3DStrideIterator &it) { return it + n; }
+
+    difference_type operator-(const Matrice3DStrideIterator &other) const { return _index - other._index; }
+
+    bool operator==(const Matrice3DStrideIterator &other) const { return _index == other._index; }
+    bool operator!=(const Matrice3DStrideIterator &other) const { return _index != other._index; }
+    bool operator<(const Matrice3DStrideIterator &other) const { return _index < other._index; }
+    bool operator>(const Matrice3DStrideIterator &other) const { return _index > other._index; }
+    bool operator<=(const Matrice3DStrideIterator &other) const { return _index <= other._index; }
+    bool operator>=(const Matrice3DStrideIterator &other) const { return _index >= other._index; }
+};
+
+/**
+    @brief Intervallo di elementi lungo un asse della Matrice3D
+
+    Coppia (primo iteratore, numero di elementi) che non possiede i dati: resta valida
+    finche' la matrice di origine non viene distrutta o riallocata. Con I = T* (righe,
+    contigue) i cicli sono cicli su puntatori e il compilatore li puo' vettorizzare; con
+    I = Matrice3DStrideIterator<T> (colonne e pilastri) ogni passo e' una somma.
+    begin() ed end() si possono passare agli algoritmi standard e a Matrice3D::fill().
+*/
+template <class I> class Matrice3DRange
+{
+    I _begin; ///< primo elemento
+    std::size_t _size; ///< numero di elementi
+
+    public:
+    typedef I iterator; ///< iteratore dell'intervallo
+    typedef typename std::iterator_traits<I>::value_type value_type; ///< tipo degli elementi
+    typedef typename std::iterator_traits<I>::reference reference; ///< riferimento a un elemento
+
+    Matrice3DRange() : _begin(), _size(0) {}
+    Matrice3DRange(I begin, std::size_t size) : _begin(begin), _size(size) {}
+
+    // Conversione da intervallo in scrittura a intervallo in sola lettura
+    template <class J, typename = typename std::enable_if<std::is_convertible<J, I>::value &&
+                                                          !std::is_same<J, I>::value>::type>
+    Matrice3DRange(const Matrice3DRange<J> &other) : _begin(other.begin()), _size(other.size()) {}
+
+    I begin() const { return _begin; } ///< primo elemento
+    I end() const { return _begin + std::ptrdiff_t(_size); } ///< dopo l'ultimo elemento
+    std::size_t size() const { return _size; } ///< numero di elementi
+    bool empty() const { return _size == 0; } ///< true se non ci sono elementi
+
+    reference operator[](std::size_t i) const { return _begin[std::ptrdiff_t(i)]; }
+    reference front() const { return *_begin; }
+    reference back() const { return _begin[std::ptrdiff_t(_size) - 1]; }
+};
+
+#endif
@@ -0,0 +1,844 @@
+#ifndef MATRICE3D_COMPRESSED_H
+#define MATRICE3D_COMPRESSED_H
+
+#include <cstddef> // size_t, ptrdiff_t
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring> // memcpy
+#include <algorithm> // min, equal
+#include <iterator> // forward_iterator_tag
+#include <type_traits> // is_trivially_copyable, make_signed, conditional
+#include <vector> // blocchi codificati, slot della cache
+#include "matrice3d.h" // Matrice3D, defaultCmp, checkedAccess, m3dForBlocks, m3dHasApply
+
+/**
+    @brief Codifiche dei blocchi della Matrice3DCompressed
+
+    Ogni blocco inizia con un byte che indica la codifica, scelta dall'encoder come la
+    piu' corta, e termina con m3dCodecPad byte di riempimento. Le codifiche sono:
+    - m3dCodecConst: tutti gli elementi uguali, memorizzato il solo valore;
+    - m3dCodecRle: coppie (lunghezza della sequenza in varint, valore);
+    - m3dCodecPacked: valore base seguito dalle differenze dalla base (frame of
+      reference) impacchettate con il numero minimo di bit;
+    - m3dCodecDelta: primo valore seguito dalle differenze tra elementi consecutivi
+      (zigzag) impacchettate con il numero minimo di bit, adatto ai gradienti;
+    - m3dCodecRaw: elementi non compressi, usata anche quando le altre codifiche
+      risparmiano meno di 1/16 dello spazio (la decodifica e' una copia).
+
+    I codec lavorano sulla rappresentazione in bit degli elementi (parole senza segno
+    da 1, 2, 4 o 8 byte), quindi valgono per qualsiasi tipo banalmente copiabile di
+    quelle dimensioni; le differenze sono calcolate modulo 2^bit.
+*/
+enum Matrice3DCodec { m3dCodecConst, m3dCodecRle, m3dCodecPacked, m3dCodecDelta, m3dCodecRaw };
+
+/// Parola senza segno con la stessa dimensione degli elementi
+template <std::size_t S> struct m3dCodecWord;
+template <> struct m3dCodecWord<1> { typedef std::uint8_t type; };
+template <> struct m3dCodecWord<2> { typedef std::uint16_t type; };
+template <> struct m3dCodecWord<4> { typedef std::uint32_t type; };
+template <> struct m3dCodecWord<8> { typedef std::uint64_t type; };
+
+/// Bit necessari a rappresentare v (0 per v == 0)
+inline unsigned int m3dBitWidth(std::uint64_t v) {
+    unsigned int w = 0;
+    for (; v; v >>= 1)
+        w++;
+    return w;
+}
+
+/// Byte di riempimento in coda a ogni blocco: la lettura dei bit legge sempre 8 byte
+static const std::size_t m3dCodecPad = 8;
+
+/// Lettura e scrittura di 8 byte in ordine little-endian
+inline std::uint64_t m3dLoad64(const unsigned char *p) {
+    std::uint64_t x;
+    std::memcpy(&x, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    return x;
+}
+
+inline void m3dStore64(unsigned char *p, std::uint64_t x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    std::memcpy(p, &x, 8);
+}
+
+/**
+    @brief Scrittura sequenziale di valori da w bit (w <= 64) in un buffer
+
+    I bit si accumulano in un registro da 64 bit scritto in memoria solo quando e'
+    pieno: niente letture e scritture sovrapposte sugli stessi byte.
+*/
+class m3dBitPacker {
+    unsigned char *_p; ///< prossimi 8 byte da scrivere
+    std::uint64_t _acc; ///< bit in attesa
+    unsigned int _n; ///< numero di bit in attesa (< 64)
+
+    public:
+
+    explicit m3dBitPacker(unsigned char *p) : _p(p), _acc(0), _n(0) {}
+
+    /// Accoda i w bit bassi di v (gli altri bit devono essere a zero)
+    void put(std::uint64_t v, unsigned int w) {
+        _acc |= v << _n;
+        if (_n + w < 64) {
+            _n += w;
+            return;
+        }
+        m3dStore64(_p, _acc);
+        _p += 8;
+        unsigned int used = 64 - _n;
+        _acc = used < 64 ? v >> used : 0;
+        _n = _n + w - 64;
+    }
+
+    /// Scrive i bit rimasti (fino a 8 byte: serve il riempimento in coda al buffer)
+    void finish() {
+        if (_n)
+            m3dStore64(_p, _acc);
+    }
+};
+
+/// Legge w bit (w <= 56) dalla posizione di bit pos di p
+inline std::uint64_t m3dGetBits(const unsigned char *p, std::size_t pos, unsigned int w) {
+    return (m3dLoad64(p + (pos >> 3)) >> (pos & 7)) & ((std::uint64_t(1) << w) - 1);
+}
+
+/// Come m3dGetBits, per qualsiasi w <= 64
+inline std::uint64_t m3dGetBitsWide(const unsigned char *p, std::size_t pos, unsigned int w) {
+    if (w > 56)
+        return m3dGetBits(p, pos, 32) | (m3dGetBits(p, pos + 32, w - 32) << 32);
+    return m3dGetBits(p, pos, w);
+}
+
+/// Differenza d (in complemento a 2 su S byte) codificata zigzag: valori piccoli in modulo -> pochi bit
+template <class W>
+inline W m3dZigzag(W d) {
+    typedef typename std::make_signed<W>::type SW;
+    return W(W(d << 1) ^ W(SW(d) >> (sizeof(W) * 8 - 1)));
+}
+
+template <class W>
+inline W m3dUnzigzag(std::uint64_t z) {
+    return W((z >> 1) ^ (~(z & 1) + 1));
+}
+
+/// Byte di un intero in varint (7 bit per byte)
+inline std::size_t m3dVarintSize(std::uint64_t v) {
+    std::size_t n = 1;
+    for (; v >= 0x80; v >>= 7)
+        n++;
+    return n;
+}
+
+/**
+    Codifica gli n elementi di v (n > 0) in out, con la codifica piu' corta.
+
+    @return codifica usata
+*/
+template <class W>
+Matrice3DCodec m3dEncodeBlock(const W *v, std::size_t n, std::vector<unsigned char> &out) {
+    typedef typename std::make_signed<W>::type SW;
+    const std::size_t S = sizeof(W);
+    // Statistiche senza salti (vettorizzabili): sequenze, estremi con e senza segno, differenze
+    std::size_t runs = 1;
+    W umin = v[0], umax = v[0], zmax = 0;
+    SW smin = SW(v[0]), smax = SW(v[0]);
+    for (std::size_t i = 1; i < n; i++) {
+        W x = v[i];
+        runs += x != v[i - 1];
+        umin = std::min(umin, x);
+        umax = std::max(umax, x);
+        smin = std::min(smin, SW(x));
+        smax = std::max(smax, SW(x));
+        zmax = std::max(zmax, m3dZigzag(W(x - v[i - 1])));
+    }
+    // Frame of reference: la base con l'intervallo piu' stretto (senza o con segno)
+    W urange = W(umax - umin), srange = W(W(smax) - W(smin));
+    W base = urange <= srange ? umin : W(smin);
+    unsigned int pw = m3dBitWidth(std::min(urange, srange)), dw = m3dBitWidth(zmax);
+
+    std::size_t cost[5];
+    cost[m3dCodecConst] = runs == 1 ? 1 + S : ~std::size_t(0);
+    cost[m3dCodecPacked] = 2 + S + (n * pw + 7) / 8;
+    cost[m3dCodecDelta] = 2 + S + ((n - 1) * dw + 7) / 8;
+    cost[m3dCodecRaw] = 1 + n * S;
+    // Ogni sequenza costa almeno 1 + S byte: la dimensione esatta dell'RLE serve solo
+    // se puo' battere le altre codifiche
+    cost[m3dCodecRle] = 1 + runs * (1 + S);
+    if (cost[m3dCodecRle] < std::min(cost[m3dCodecPacked], cost[m3dCodecDelta])) {
+        cost[m3dCodecRle] = 1;
+        for (std::size_t i = 0; i < n;) {
+            std::size_t j = i + 1;
+            while (j < n && v[j] == v[i])
+                j++;
+            cost[m3dCodecRle] += m3dVarintSize(j - i) + S;
+            i = j;
+        }
+    } else
+        cost[m3dCodecRle] = ~std::size_t(0);
+    int c = m3dCodecConst;
+    for (int k = 1; k < 5; k++)
+        if (cost[k] < cost[c])
+            c = k;
+    // Un risparmio inferiore a 1/16 non ripaga la decodifica: meglio una copia
+    if (cost[c] + cost[m3dCodecRaw] / 16 > cost[m3dCodecRaw])
+        c = m3dCodecRaw;
+
+    // Buffer a zero della dimensione esatta, piu' il riempimento per la lettura dei bit
+    out.assign(cost[c] + m3dCodecPad, 0);
+    unsigned char *p = out.data();
+    *p++ = (unsigned char)c;
+    auto word = [&](W x) {
+        std::memcpy(p, &x, S);
+        p += S;
+    };
+    switch (c) {
+        case m3dCodecConst:
+            word(v[0]);
+            break;
+        case m3dCodecRle:
+            for (std::size_t i = 0; i < n;) {
+                std::size_t j = i + 1;
+                while (j < n && v[j] == v[i])
+                    j++;
+                std::uint64_t len = j - i;
+                for (; len >= 0x80; len >>= 7)
+                    *p++ = (unsigned char)(len | 0x80);
+                *p++ = (unsigned char)len;
+                word(v[i]);
+                i = j;
+            }
+            break;
+        case m3dCodecPacked:
+            word(base);
+            *p++ = (unsigned char)pw;
+            {
+                m3dBitPacker bits(p);
+                for (std::size_t i = 0; i < n; i++)
+                    bits.put(W(v[i] - base), pw);
+                bits.finish();
+            }
+            break;
+        case m3dCodecDelta:
+            word(v[0]);
+            *p++ = (unsigned char)dw;
+            {
+                m3dBitPacker bits(p);
+                for (std::size_t i = 1; i < n; i++)
+                    bits.put(m3dZigzag(W(v[i] - v[i - 1])), dw);
+                bits.finish();
+            }
+            break;
+        default:
+            for (std::size_t i = 0; i < n; i++)
+                word(v[i]);
+    }
+    return Matrice3DCodec(c);
+}
+
+/**
+    Decodifica in v gli n elementi codificati da m3dEncodeBlock in in
+*/
+template <class W>
+void m3dDecodeBlock(const unsigned char *in, std::size_t n, W *v) {
+    const std::size_t S = sizeof(W);
+    int c = *in++;
+    auto word = [&]() {
+        W x;
+        std::memcpy(&x, in, S);
+        in += S;
+        return x;
+    };
+    switch (c) {
+        case m3dCodecConst:
+            std::fill(v, v + n, word());
+            break;
+        case m3dCodecRle:
+            for (std::size_t i = 0; i < n;) {
+                std::uint64_t len = 0;
+                for (unsigned int shift = 0; ; shift += 7) {
+                    unsigned char b = *in++;
+                    len |= std::uint64_t(b & 0x7F) << shift;
+                    if (b < 0x80)
+                        break;
+                }
+                W x = word();
+                std::fill(v + i, v + i + len, x);
+                i += len;
+            }
+            break;
+        case m3dCodecPacked: {
+            W base = word();
+            unsigned int w = *in++;
+            if (w <= 56)
+                for (std::size_t i = 0; i < n; i++)
+                    v[i] = W(base + W(m3dGetBits(in, i * w, w)));
+            else
+                for (std::size_t i = 0; i < n; i++)
+                    v[i] = W(base + W(m3dGetBitsWide(in, i * w, w)));
+            break;
+        }
+        case m3dCodecDelta: {
+            v[0] = word();
+            unsigned int w = *in++;
+            if (w <= 56)
+                for (std::size_t i = 1; i < n; i++)
+                    v[i] = W(v[i - 1] + m3dUnzigzag<W>(m3dGetBits(in, (i - 1) * w, w)));
+            else
+                for (std::size_t i = 1; i < n; i++)
+                    v[i] = W(v[i - 1] + m3dUnzigzag<W>(m3dGetBitsWide(in, (i - 1) * w, w)));
+            break;
+        }
+        default:
+            std::memcpy(v, in, n * S);
+    }
+}
+
+/**
+    @brief Classe Matrice3DCompressed: Matrice3D compressa in memoria
+
+    Pensata per volumi molto ridondanti (etichette, maschere): gli elementi, in ordine
+    row-major, sono divisi in blocchi di B elementi consecutivi, ognuno codificato in
+    modo indipendente con la codifica piu' corta (vedi Matrice3DCodec). Un blocco
+    costante occupa pochi byte, un blocco con pochi valori diversi pochi bit per elemento.
+
+    Gli elementi si leggono e scrivono decodificando i blocchi in una piccola cache LRU
+    di slot (come gli slab della Matrice3DStream): un blocco modificato viene ricodificato
+    quando esce dalla cache o con flush(). L'operatore () e gli iteratori non costanti
+    ritornano un Matrice3DElementRef: un blocco viene segnato come modificato solo se un
+    suo elemento viene assegnato, non quando viene letto. I riferimenti const T& delle
+    versioni costanti restano validi solo fino al prossimo accesso a un altro blocco.
+    La classe non e' thread-safe (anche le letture aggiornano la cache).
+
+    Gli iteratori scorrono i blocchi in ordine, decodificando ogni blocco una sola volta;
+    trasform() decodifica, trasforma e ricodifica un blocco alla volta, senza passare
+    dalla cache e, con m3dPar(pool), con piu' blocchi in parallelo.
+
+    @tparam B elementi per blocco
+
+*/
+template <class T, class Cmp = defaultCmp, class Check = checkedAccess, unsigned int B = 4096>
+class Matrice3DCompressed
+{
+    static_assert(std::is_trivially_copyable<T>::value &&
+                  (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                  "Matrice3DCompressed: servono elementi banalmente copiabili da 1, 2, 4 o 8 byte");
+    static_assert(B > 0, "Matrice3DCompressed: i blocchi devono contenere almeno un elemento");
+
+    typedef typename m3dCodecWord<sizeof(T)>::type W;
+
+    template <class> friend class Matrice3DElementRef;
+
+    /// Slot della cache: contiene un blocco decodificato
+    struct Slot {
+        std::vector<T> data; ///< elementi del blocco
+        long index; ///< blocco contenuto (-1 se vuoto)
+        bool dirty; ///< modificato rispetto alla codifica
+        unsigned long stamp; ///< ultimo utilizzo (per l'LRU)
+    };
+
+    unsigned int _sizeX; ///< dimensione X
+    unsigned int _sizeY; ///< dimensione Y
+    unsigned int _sizeZ; ///< dimensione Z
+    std::size_t _size; ///< dimensione totale
+    mutable std::vector<std::vector<unsigned char> > _blocks; ///< blocchi codificati
+    mutable std::vector<Slot> _slots; ///< cache dei blocchi decodificati
+    mutable std::vector<int> _slotOf; ///< slot di ogni blocco (-1 se non in cache)
+    mutable unsigned long _clock; ///< cambi di blocco: timbri dell'LRU e validita' degli iteratori
+    mutable long _last; ///< ultimo blocco usato (accesso veloce)
+    mutable int _lastSlot; ///< slot dell'ultimo blocco usato
+    mutable unsigned long _decodes; ///< blocchi decodificati nella cache
+    mutable unsigned long _encodes; ///< blocchi ricodificati dalla cache
+    Cmp _cmp; ///< funtore di confronto
+
+    public:
+
+    static constexpr unsigned int block_elements = B; ///< elementi per blocco
+
+    typedef T value_type; ///< tipo degli elementi
+    typedef Matrice3DElementRef<Matrice3DCompressed> reference; ///< riferimento in lettura e scrittura
+
+    /**
+        Costruttore: Matrice3DCompressed z * y * x con tutti gli elementi a value
+
+        @param z, y, x dimensioni
+        @param value valore iniziale degli elementi
+        @param slots blocchi decodificati nella cache (almeno 1)
+
+        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida
+    */
+    Matrice3DCompressed(int z, int y, int x, const T &value = T(), unsigned int slots = 4) {
+        if (z <= 0 || y <= 0 || x <= 0)
+            throw Matrice3DOutOfRange("ERRORE: Indici fuori dai limiti della matrice");
+        init(z, y, x, slots);
+        std::vector<T> buf(B, value);
+        for (std::size_t b = 0; b < _blocks.size(); b++)
+            write_block(b, buf.data());
+    }
+
+    /**
+        Costruttore da una Matrice3D (qualsiasi layout): la matrice viene codificata un
+        blocco alla volta.
+
+        @param m Matrice3D da comprimere
+        @param slots blocchi decodificati nella cache (almeno 1)
+    */
+    template <class C, class Ch, class A, class L>
+    explicit Matrice3DCompressed(const Matrice3D<T, C, Ch, A, L> &m, unsigned int slots = 4) {
+        init(m.sizeZ(), m.sizeY(), m.sizeX(), slots);
+        std::vector<T> buf(B);
+        typename Matrice3D<T, C, Ch, A, L>::const_iterator it = m.begin();
+        for (std::size_t b = 0; b < _blocks.size(); b++) {
+            std::size_t n = block_length(b);
+            for (std::size_t i = 0; i < n; i++, ++it)
+                buf[i] = *it;
+            write_block(b, buf.data());
+        }
+    }
+
+    unsigned int sizeX() const { return _sizeX; } ///< dimensione X
+    unsigned int sizeY() const { return _sizeY; } ///< dimensione Y
+    unsigned int sizeZ() const { return _sizeZ; } ///< dimensione Z
+    std::size_t size() const { return _size; } ///< dimensione totale
+    std::size_t blocks() const { return _blocks.size(); } ///< numero di blocchi
+    unsigned int slots() const { return (unsigned int)_slots.size(); } ///< blocchi nella cache
+    unsigned long decodes() const { return _decodes; } ///< blocchi decodificati nella cache
+    unsigned long encodes() const { return _encodes; } ///< blocchi ricodificati dalla cache
+
+    /**
+        @return elementi del blocco b (l'ultimo puo' essere piu' corto)
+    */
+    std::size_t block_length(std::size_t b) const {
+        return std::min<std::size_t>(B, _size - b * B);
+    }
+
+    /**
+        @return byte occupati dai blocchi codificati (compresa la gestione dei vettori)
+    */
+    std::size_t compressed_bytes() const {
+        std::size_t n = _blocks.capacity() * sizeof(_blocks[0]);
+        for (std::size_t b = 0; b < _blocks.size(); b++)
+            n += _blocks[b].capacity();
+        return n;
+    }
+
+    /**
+        @return memoria totale: blocchi codificati piu' cache
+    */
+    std::size_t memory() const {
+        return compressed_bytes() + _slots.size() * std::size_t(B) * sizeof(T);
+    }
+
+    /**
+        @return codifica usata dal blocco b (le modifiche ancora in cache non contano)
+    */
+    Matrice3DCodec codec(std::size_t b) const { return Matrice3DCodec(_blocks[b][0]); }
+
+    /**
+        Operatore (): Ritorna il valore delle coordinate (z, y, x), in lettura e scrittura.
+        Il blocco che lo contiene viene decodificato se necessario e segnato come
+        modificato solo quando l'elemento viene assegnato.
+
+        @return Riferimento all'elemento delle coordinate (z, y, x)
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    reference operator()(int z, int y, int x) {
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        return reference(this, (std::size_t(z) * _sizeY + y) * _sizeX + x);
+    }
+
+    /**
+        Operatore (): Ritorna il valore delle coordinate (z, y, x) in sola lettura
+
+        @return Valore delle coordinate (z, y, x), valido fino all'accesso a un altro blocco
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    const T& operator()(int z, int y, int x) const {
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        std::size_t i = (std::size_t(z) * _sizeY + y) * _sizeX + x;
+        return block(i / B)[i % B];
+    }
+
+    /**
+        Puntatore agli elementi decodificati del blocco b, caricato nella cache se
+        necessario. Usato da iteratori e slice per lavorare a blocchi interi.
+        La versione costante e' in sola lettura; quella non costante segna il blocco
+        come modificato, quindi verra' ricodificato.
+
+        @param b indice del blocco
+
+        @return elementi del blocco, validi fino all'accesso a un altro blocco
+    */
+    const T *block(std::size_t b) const { return use(b).data.data(); }
+
+    T *block(std::size_t b) {
+        Slot &slot = use(b);
+        slot.dirty = true;
+        return slot.data.data();
+    }
+
+    /**
+        Copia in out gli elementi del blocco b senza modificare la cache: si puo' chiamare
+        da piu' thread contemporaneamente se nessuno modifica la matrice.
+
+        @param b indice del blocco
+        @param out buffer di almeno block_length(b) elementi
+    */
+    void read_block(std::size_t b, T *out) const {
+        if (_slotOf[b] >= 0)
+            std::copy(_slots[_slotOf[b]].data.begin(), _slots[_slotOf[b]].data.begin() + block_length(b), out);
+        else
+            decode(b, out);
+    }
+
+    /**
+        Sostituisce il blocco b con i valori in in (ricodificandolo), scartando la sua
+        eventuale copia nella cache. Blocchi diversi si possono scrivere da thread diversi
+        se la cache non li contiene.
+
+        @param b indice del blocco
+        @param in block_length(b) elementi
+    */
+    void write_block(std::size_t b, const T *in) {
+        if (_slotOf[b] >= 0) {
+            Slot &slot = _slots[_slotOf[b]];
+            _slotOf[b] = -1;
+            slot.index = -1;
+            slot.dirty = false;
+            if (_last == (long)b)
+                _last = -1;
+            ++_clock;
+        }
+        encode(b, in, _blocks[b]);
+    }
+
+    /**
+        Metodo flush: ricodifica i blocchi modificati presenti nella cache (che restano
+        nella cache, non piu' segnati come modificati)
+    */
+    void flush() const {
+        for (std::size_t i = 0; i < _slots.size(); i++)
+            write_back(_slots[i]);
+        // I puntatori ai blocchi gia' dati in scrittura non li segnerebbero piu' modificati
+        _last = -1;
+        ++_clock;
+    }
+
+    /**
+        Metodo slice: Ritorna la sotto-Matrice3D negli intervalli di coordinate z1..z2,
+                      y1..y2 e x1..x2, decodificando ogni blocco interessato una volta.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Matrice3D con i valori negli intervalli
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3D<T, Cmp> slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        if(z1 > z2 || y1 > y2 || x1 > x2)
+            throw Matrice3DInvalidParameters("ERRORE: Parametri forniti invalidi");
+        if(z1 < 0 || z2 >= _sizeZ || y1 < 0 || y2 >= _sizeY || x1 < 0 || x2 >= _sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+        Matrice3D<T, Cmp> res(z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1);
+        T *out = res.data();
+        for (int i = z1; i <= z2; i++)
+            for (int j = y1; j <= y2; j++) {
+                // Una riga puo' attraversare piu' blocchi
+                std::size_t s = (std::size_t(i) * _sizeY + j) * _sizeX + x1, e = s + (x2 - x1 + 1);
+                while (s < e) {
+                    std::size_t b = s / B, t = std::min(e, (b + 1) * B);
+                    const T *in = block(b) + (s - b * B);
+                    out = std::copy(in, in + (t - s), out);
+                    s = t;
+                }
+            }
+        return res;
+    }
+
+    /**
+        Metodo materialize: decomprime l'intera matrice in una Matrice3D
+
+        @return Matrice3D con gli stessi valori
+    */
+    Matrice3D<T, Cmp> materialize() const {
+        if (_size == 0)
+            return Matrice3D<T, Cmp>();
+        Matrice3D<T, Cmp> res(_sizeZ, _sizeY, _sizeX);
+        for (std::size_t b = 0; b < _blocks.size(); b++)
+            read_block(b, res.data() + b * B);
+        return res;
+    }
+
+    /**
+        Operator ==: Verifica che due Matrice3DCompressed contengano gli stessi valori.
+                     I blocchi con la stessa codifica sono uguali senza decodificarli
+                     (se il confronto e' quello di default e T non e' floating point).
+
+        @param other Matrice3DCompressed da confrontare
+
+        @return true se le due matrici contengono gli stessi valori, false altrimenti
+    */
+    bool operator==(const Matrice3DCompressed &other) const {
+        if (_sizeX != other._sizeX || _sizeY != other._sizeY || _sizeZ != other._sizeZ)
+            return false;
+        flush();
+        other.flush();
+        std::vector<T> a(B), b(B);
+        for (std::size_t k = 0; k < _blocks.size(); k++) {
+            if (std::is_same<Cmp, defaultCmp>::value && !std::is_floating_point<T>::value &&
+                _blocks[k] == other._blocks[k])
+                continue;
+            std::size_t n = block_length(k);
+            read_block(k, a.data());
+            other.read_block(k, b.data());
+            if (!std::equal(a.begin(), a.begin() + n, b.begin(), _cmp))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     @brief Forward iterator della Matrice3DCompressed
+
+            Scorre gli elementi nell'ordine della Matrice3D (x, poi y, poi z), un blocco
+            alla volta: ogni blocco viene decodificato una sola volta.
+    */
+    template <class V> class compressed_iterator {
+        template <class> friend class compressed_iterator;
+
+        typedef typename std::conditional<std::is_const<V>::value, const Matrice3DCompressed, Matrice3DCompressed>::type M;
+
+        M *_m; ///< matrice su cui si itera
+        std::size_t _i; ///< posizione lineare corrente
+        mutable const T *_data; ///< elementi del blocco corrente nella cache
+        mutable std::size_t _start; ///< posizione del primo elemento di _data
+        mutable std::size_t _stop; ///< fine del blocco corrente (0 se nessun blocco)
+        mutable unsigned long _clock; ///< _clock della matrice quando _data era valido
+
+        /// Carica il blocco di _i: serve solo al cambio di blocco o se la cache e' cambiata
+        void refresh() const {
+            std::size_t b = _i / B;
+            _data = static_cast<const Matrice3DCompressed *>(_m)->block(b);
+            _start = b * B;
+            _stop = _start + _m->block_length(b);
+            _clock = _m->_clock;
+        }
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef typename std::conditional<std::is_const<V>::value, const T&,
+                                          Matrice3DElementRef<Matrice3DCompressed> >::type reference;
+
+        compressed_iterator() : _m(nullptr), _i(0), _data(nullptr), _start(0), _stop(0), _clock(0) {}
+        compressed_iterator(M *m, std::size_t i)
+            : _m(m), _i(i), _data(nullptr), _start(0), _stop(0), _clock(0) {}
+
+        // Conversione da iterator a const_iterator
+        template <class X, typename = typename std::enable_if<std::is_same<const X, V>::value>::type>
+        compressed_iterator(const compressed_iterator<X> &other)
+            : _m(other._m), _i(other._i), _data(nullptr), _start(0), _stop(0), _clock(0) {}
+
+        /**
+            Il puntatore al blocco resta valido finche' la matrice non cambia blocco
+            (anche per accessi fatti da altri iteratori o con operator()). In scrittura
+            ritorna un riferimento che segna il blocco solo se assegnato.
+        */
+        reference operator*() const {
+            if constexpr (std::is_const<V>::value)
+                return *operator->();
+            else
+                return reference(_m, _i);
+        }
+        pointer operator->() const {
+            if (_i >= _stop || _i < _start || _m->_clock != _clock)
+                refresh();
+            return _data + (_i - _start);
+        }
+
+        compressed_iterator& operator++() { ++_i; return *this; }
+        compressed_iterator operator++(int) { compressed_iterator tmp(*this); ++_i; return tmp; }
+
+        bool operator==(const compressed_iterator &other) const { return _i == other._i; }
+        bool operator!=(const compressed_iterator &other) const { return _i != other._i; }
+    };
+
+    typedef compressed_iterator<T> iterator;
+    typedef compressed_iterator<const T> const_iterator;
+
+    // Metodi membro begin() e end() per l'iterazione
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, _size); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _size); }
+
+    private:
+
+    // Slot del blocco b, decodificato se necessario
+    Slot &use(std::size_t b) const {
+        // Il timbro LRU cambia solo al cambio di blocco: lo slot corrente e' sempre il piu' recente
+        if ((long)b != _last) {
+            _lastSlot = acquire(b);
+            _last = (long)b;
+            _slots[_lastSlot].stamp = ++_clock;
+        }
+        return _slots[_lastSlot];
+    }
+
+    // Elemento in posizione lineare i: in lettura (il blocco resta pulito) o in scrittura
+    const T& load_element(std::size_t i) const { return block(i / B)[i % B]; }
+    T& store_element(std::size_t i) { return block(i / B)[i % B]; }
+
+    void init(unsigned int z, unsigned int y, unsigned int x, unsigned int slots) {
+        _sizeZ = z;
+        _sizeY = y;
+        _sizeX = x;
+        _size = std::size_t(z) * y * x;
+        std::size_t n = (_size + B - 1) / B;
+        _blocks.assign(n, std::vector<unsigned char>());
+        _slotOf.assign(n, -1);
+        _slots.assign(slots > 0 ? slots : 1, Slot{std::vector<T>(), -1, false, 0});
+        _clock = 0;
+        _last = -1;
+        _lastSlot = -1;
+        _decodes = 0;
+        _encodes = 0;
+    }
+
+    /// Gli interi si leggono direttamente come parole senza segno (aliasing consentito)
+    static constexpr bool word_alias = std::is_integral<T>::value &&
+        std::is_same<typename std::make_unsigned<typename std::conditional<std::is_integral<T>::value, T, int>::type>::type,
+                     W>::value;
+
+    // Codifica gli elementi del blocco b in out
+    void encode(std::size_t b, const T *in, std::vector<unsigned char> &out) const {
+        std::size_t n = block_length(b);
+        if constexpr (word_alias)
+            m3dEncodeBlock(reinterpret_cast<const W *>(in), n, out);
+        else {
+            std::vector<W> w(n);
+            std::memcpy(w.data(), in, n * sizeof(T));
+            m3dEncodeBlock(w.data(), n, out);
+        }
+        out.shrink_to_fit();
+    }
+
+    // Decodifica gli elementi del blocco b in out
+    void decode(std::size_t b, T *out) const {
+        std::size_t n = block_length(b);
+        if constexpr (word_alias)
+            m3dDecodeBlock(_blocks[b].data(), n, reinterpret_cast<W *>(out));
+        else {
+            std::vector<W> w(n);
+            m3dDecodeBlock(_blocks[b].data(), n, w.data());
+            std::memcpy(out, w.data(), n * sizeof(T));
+        }
+    }
+
+    /**
+        Ritorna lo slot del blocco b, decodificandolo se necessario
+    */
+    int acquire(std::size_t b) const {
+        int slot = _slotOf[b];
+        if (slot >= 0)
+            return slot;
+        slot = victim();
+        Slot &s = _slots[slot];
+        write_back(s);
+        if (s.index >= 0)
+            _slotOf[s.index] = -1;
+        s.index = -1;
+        if (s.data.empty())
+            s.data.resize(B);
+        decode(b, s.data.data());
+        s.index = (long)b;
+        _slotOf[b] = slot;
+        _decodes++;
+        return slot;
+    }
+
+    /**
+        Slot da liberare: uno vuoto, altrimenti quello usato meno di recente
+    */
+    int victim() const {
+        int best = 0;
+        for (int i = 0; i < (int)_slots.size(); i++) {
+            if (_slots[i].index < 0)
+                return i;
+            if (_slots[i].stamp < _slots[best].stamp)
+                best = i;
+        }
+        return best;
+    }
+
+    // Ricodifica lo slot se modificato
+    void write_back(Slot &slot) const {
+        if (slot.index < 0 || !slot.dirty)
+            return;
+        encode((std::size_t)slot.index, slot.data.data(), _blocks[slot.index]);
+        slot.dirty = false;
+        _encodes++;
+    }
+};
+
+/**
+    Trasformazione a blocchi: ogni blocco di A viene decodificato, trasformato e
+    codificato nel risultato, secondo la politica. La cache di A non viene modificata.
+*/
+template <class Q, class FQ, class U, class C, class Ch, unsigned int B, class F, class Policy>
+Matrice3DCompressed<Q, FQ, Ch, B> m3dCompressedTrasform(const Matrice3DCompressed<U, C, Ch, B> &A, F funz, const Policy &policy) {
+    Matrice3DCompressed<Q, FQ, Ch, B> res(A.sizeZ(), A.sizeY(), A.sizeX(), Q(), A.slots());
+    m3dForBlocks(policy, A.blocks(), 1, [&](std::size_t b, std::size_t e) {
+        std::vector<U> in(B);
+        std::vector<Q> out(B);
+        for (std::size_t k = b; k < e; k++) {
+            std::size_t n = A.block_length(k);
+            A.read_block(k, in.data());
+            if constexpr (m3dHasApply<F, Q, U>::value)
+                funz.apply(out.data(), in.data(), n);
+            else
+                for (std::size_t i = 0; i < n; i++)
+                    out[i] = static_cast<Q>(funz(in[i]));
+            res.write_block(k, out.data());
+        }
+    });
+    return res;
+}
+
+/**
+    Metodo GLOBALE transform per la Matrice3DCompressed: B(i,j,k) = F(A(i,j,k)), con B
+    compressa con gli stessi blocchi. Un blocco alla volta viene decodificato, trasformato
+    e ricodificato, quindi la memoria aggiuntiva e' di pochi blocchi.
+
+    @param A Matrice3DCompressed su tipi T, F funtore generico
+
+    @return Matrice3DCompressed B su tipi Q con il funtore applicato
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DCompressed<Q, FQ, Ch, B> trasform(const Matrice3DCompressed<T, C, Ch, B> &A, F funz) {
+    return m3dCompressedTrasform<Q, FQ>(A, funz, m3dSeq);
+}
+
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DCompressed<Q, FQ, Ch, B> trasform(const Matrice3DCompressed<T, C, Ch, B> &A, F funz, const m3dSeqPolicy &) {
+    return m3dCompressedTrasform<Q, FQ>(A, funz, m3dSeq);
+}
+
+/**
+    Metodo GLOBALE transform per la Matrice3DCompressed con politica parallela: i blocchi
+    vengono decodificati, trasformati e ricodificati in parallelo sul pool.
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DCompressed<Q, FQ, Ch, B> trasform(const Matrice3DCompressed<T, C, Ch, B> &A, F funz, const m3dParPolicy &policy) {
+    return m3dCompressedTrasform<Q, FQ>(A, funz, policy);
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef MATRICE3D_COW_H
+#define MATRICE3D_COW_H
+
+#include <atomic> // atomic
+#include <utility> // move, swap
+#include "matrice3d.h" // Matrice3D, defaultCmp, checkedAccess, alignedAllocator, rowMajorLayout
+
+/**
+    @brief Classe Matrice3DCow: Matrice3D con buffer condiviso copy-on-write
+
+    Le copie di una Matrice3DCow condividono lo stesso buffer, con un contatore di
+    riferimenti atomico: passare un volume per valore a molti consumatori in sola
+    lettura costa O(1). Il buffer viene duplicato solo al primo accesso in scrittura
+    di una copia che lo condivide:
+
+    - operator(), at_unchecked(), data(), begin(), end() non costanti, fill() e
+      matrix_mut() staccano la copia (una sola volta, poi il buffer e' esclusivo);
+    - operator(), at_unchecked(), data(), cbegin(), cend(), begin() ed end() costanti,
+      ==, slice() e matrix() non copiano mai. Per iterare in sola lettura su un oggetto
+      non costante si usano cbegin()/cend() (o std::as_const);
+    - swap() scambia solo i buffer, senza copie.
+
+    Il contatore e' thread-safe: oggetti diversi che condividono un buffer si possono
+    copiare, leggere e modificare da thread diversi. Come per gli altri contenitori, lo
+    stesso oggetto non va modificato da piu' thread contemporaneamente.
+
+    Riferimenti, puntatori e iteratori ottenuti con un accesso in scrittura valgono
+    finche' l'oggetto non viene copiato: dopo una copia il buffer torna condiviso e
+    scrivere attraverso di essi modificherebbe anche la copia.
+
+*/
+template <class T, class Cmp = defaultCmp, class Check = checkedAccess, class Alloc = alignedAllocator<T>,
+          class Layout = rowMajorLayout>
+class Matrice3DCow
+{
+    public:
+
+    typedef Matrice3D<T, Cmp, Check, Alloc, Layout> matrix_type; ///< matrice condivisa
+    typedef T value_type; ///< tipo degli elementi
+    typedef typename matrix_type::iterator iterator; ///< iteratore in scrittura
+    typedef typename matrix_type::const_iterator const_iterator; ///< iteratore in lettura
+
+    private:
+
+    /// Buffer condiviso: la matrice e il numero di Matrice3DCow che la usano
+    struct Block {
+        std::atomic<unsigned int> refs;
+        matrix_type m;
+
+        template <class... Args>
+        explicit Block(Args &&...args) : refs(1), m(std::forward<Args>(args)...) {}
+    };
+
+    Block *_block; ///< buffer condiviso (mai nullptr)
+
+    /**
+        Buffer vuoto comune alle Matrice3DCow vuote e spostate: il suo riferimento
+        statico non viene mai rilasciato, quindi non viene mai distrutto qui.
+    */
+    static Block *empty() {
+        static Block b;
+        b.refs.fetch_add(1, std::memory_order_relaxed);
+        return &b;
+    }
+
+    /// Rilascia il buffer, distruggendolo se era l'ultimo riferimento
+    void release() {
+        if (_block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete _block;
+    }
+
+    /**
+        Rende il buffer esclusivo prima di una scrittura. L'acquire sul contatore rende
+        visibili le scritture fatte dai possessori precedenti che hanno gia' rilasciato.
+    */
+    void detach() {
+        if (_block->refs.load(std::memory_order_acquire) != 1) {
+            Block *b = new Block(_block->m);
+            release();
+            _block = b;
+        }
+    }
+
+    public:
+
+    /**
+        Costruttore di default: Matrice3DCow vuota (nessuna allocazione)
+    */
+    Matrice3DCow() noexcept : _block(empty()) {}
+
+    /**
+        Costruttore: Matrice3DCow z * y * x (come il costruttore secondario della Matrice3D)
+
+        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida
+    */
+    Matrice3DCow(int z, int y, int x) : _block(new Block(z, y, x)) {}
+
+    /**
+        Costruttore da una Matrice3D: la matrice viene copiata (o spostata) nel buffer
+        condiviso.
+
+        @param m Matrice3D di partenza
+    */
+    explicit Matrice3DCow(const matrix_type &m) : _block(new Block(m)) {}
+    explicit Matrice3DCow(matrix_type &&m) : _block(new Block(std::move(m))) {}
+
+    /**
+        Copy constructor: condivide il buffer di other in O(1)
+
+        @param other Matrice3DCow da copiare
+    */
+    Matrice3DCow(const Matrice3DCow &other) : _block(other._block) {
+        _block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+        Move constructor: other resta una Matrice3DCow vuota
+    */
+    Matrice3DCow(Matrice3DCow &&other) noexcept : _block(empty()) {
+        swap(other);
+    }
+
+    /**
+        Operatore di Assegnamento: condivide il buffer di other in O(1)
+    */
+    Matrice3DCow& operator=(const Matrice3DCow &other) {
+        Matrice3DCow tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    Matrice3DCow& operator=(Matrice3DCow &&other) noexcept {
+        Matrice3DCow tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    /**
+        Distruttore: il buffer viene liberato con l'ultimo riferimento
+    */
+    ~Matrice3DCow() {
+        release();
+    }
+
+    /**
+        Metodo swap: scambia i buffer (condivisi o meno) senza copiarli
+    */
+    void swap(Matrice3DCow &other) noexcept {
+        std::swap(_block, other._block);
+    }
+
+    unsigned int sizeZ() const { return _block->m.sizeZ(); } ///< dimensione Z
+    unsigned int sizeY() const { return _block->m.sizeY(); } ///< dimensione Y
+    unsigned int sizeX() const { return _block->m.sizeX(); } ///< dimensione X
+    std::size_t size() const { return _block->m.size(); } ///< dimensione totale
+
+    /**
+        @return numero di Matrice3DCow che condividono il buffer (indicativo se altri
+                thread stanno copiando o distruggendo le copie)
+    */
+    unsigned int use_count() const { return _block->refs.load(std::memory_order_relaxed); }
+
+    /**
+        @return true se il buffer e' condiviso con altre Matrice3DCow
+    */
+    bool shared() const { return use_count() > 1; }
+
+    /**
+        Metodo matrix: la matrice condivisa in sola lettura (nessuna copia)
+    */
+    const matrix_type &matrix() const { return _block->m; }
+
+    /**
+        Metodo matrix_mut: la matrice in scrittura, staccata dalle altre copie
+    */
+    matrix_type &matrix_mut() {
+        detach();
+        return _block->m;
+    }
+
+    /**
+        Operatore (): lettura senza copie, scrittura dopo aver staccato il buffer
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    const T& operator()(int z, int y, int x) const { return _block->m(z, y, x); }
+
+    T& operator()(int z, int y, int x) {
+        detach();
+        return _block->m(z, y, x);
+    }
+
+    const T& at_unchecked(int z, int y, int x) const { return _block->m.at_unchecked(z, y, x); }
+
+    T& at_unchecked(int z, int y, int x) {
+        detach();
+        return _block->m.at_unchecked(z, y, x);
+    }
+
+    const T *data() const { return _block->m.data(); } ///< buffer in sola lettura
+
+    /// Buffer in scrittura (staccato dalle altre copie)
+    T *data() {
+        detach();
+        return _block->m.data();
+    }
+
+    // Metodi membro begin() e end(): le versioni non costanti staccano il buffer
+    iterator begin() { detach(); return _block->m.begin(); }
+    iterator end() { detach(); return _block->m.end(); }
+    const_iterator begin() const { return _block->m.begin(); }
+    const_iterator end() const { return _block->m.end(); }
+    const_iterator cbegin() const { return _block->m.begin(); }
+    const_iterator cend() const { return _block->m.end(); }
+
+    /**
+        Metodo fill: come Matrice3D::fill, dopo aver staccato il buffer
+
+        @param it, ite Iteratori che identificano la sequenza di dati
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+    */
+    template <class Iter, class... Policy>
+    void fill(Iter it, Iter ite, const Policy &...policy) {
+        detach();
+        _block->m.fill(it, ite, policy...);
+    }
+
+    /**
+        Metodo slice: sotto-matrice (una nuova Matrice3D) senza staccare il buffer
+    */
+    matrix_type slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        return _block->m.slice(z1, z2, y1, y2, x1, x2);
+    }
+
+    /**
+        Operator ==: confronto dei valori con il funtore Cmp
+    */
+    bool operator==(const Matrice3DCow &other) const {
+        return _block->m == other._block->m;
+    }
+};
+
+#endif
@@ -0,0 +1,312 @@
+#ifndef MATRICE3D_EXPR_H
+#define MATRICE3D_EXPR_H
+
+#include <cmath> // fma
+#include "matrice3d.h"
+
+/**
+    @brief Expression template per le operazioni aritmetiche element-wise
+
+    Gli operatori +, -, *, / tra Matrice3D (e tra Matrice3D e scalari) non calcolano
+    nulla: costruiscono un albero di nodi leggeri che descrive l'espressione.
+    Il calcolo avviene una sola volta, quando l'espressione viene assegnata (o usata
+    per costruire) una Matrice3D, con un unico ciclo che valuta l'intera espressione
+    elemento per elemento senza matrici temporanee intermedie.
+
+    Ogni nodo espone sizeZ(), sizeY(), sizeX(), size() e operator[](i), ovvero il
+    valore dell'i-esimo elemento nell'ordine del buffer. Le dimensioni degli operandi
+    vengono verificate alla costruzione del nodo.
+
+    I nodi contengono un puntatore ai dati delle matrici: l'espressione va valutata
+    prima che le matrici coinvolte vengano distrutte (come avviene assegnandola
+    nella stessa istruzione in cui e' scritta).
+
+*/
+template <class E> struct Matrice3DExpr {
+    const E &derived() const { return static_cast<const E &>(*this); }
+};
+
+/**
+    @brief Nodo foglia: gli elementi di una Matrice3D
+*/
+template <class T> class Matrice3DTerminal : public Matrice3DExpr<Matrice3DTerminal<T> > {
+    const T *_data; ///< buffer della matrice
+    unsigned int _sizeZ, _sizeY, _sizeX; ///< dimensioni della matrice
+
+    public:
+    typedef T value_type;
+
+    template <class M>
+    explicit Matrice3DTerminal(const M &m) : _data(m.data()), _sizeZ(m.sizeZ()), _sizeY(m.sizeY()), _sizeX(m.sizeX()) {}
+
+    unsigned int sizeZ() const { return _sizeZ; }
+    unsigned int sizeY() const { return _sizeY; }
+    unsigned int sizeX() const { return _sizeX; }
+    std::size_t size() const { return std::size_t(_sizeZ) * _sizeY * _sizeX; }
+    const T &operator[](std::size_t i) const { return _data[i]; }
+    const T *data() const { return _data; }
+};
+
+/**
+    @brief Nodo foglia: uno scalare ripetuto su tutte le coordinate
+*/
+template <class S> class Matrice3DScalar : public Matrice3DExpr<Matrice3DScalar<S> > {
+    S _value; ///< valore dello scalare
+    unsigned int _sizeZ, _sizeY, _sizeX; ///< dimensioni dell'altro operando
+
+    public:
+    typedef S value_type;
+
+    template <class E>
+    Matrice3DScalar(const S &value, const E &shape) : _value(value), _sizeZ(shape.sizeZ()), _sizeY(shape.sizeY()), _sizeX(shape.sizeX()) {}
+
+    unsigned int sizeZ() const { return _sizeZ; }
+    unsigned int sizeY() const { return _sizeY; }
+    unsigned int sizeX() const { return _sizeX; }
+    std::size_t size() const { return std::size_t(_sizeZ) * _sizeY * _sizeX; }
+    const S &operator[](std::size_t) const { return _value; }
+    const S &value() const { return _value; }
+};
+
+/**
+    @brief Nodo interno: operazione binaria Op applicata elemento per elemento
+
+    @throw Matrice3DInvalidParameters se gli operandi hanno dimensioni diverse
+*/
+template <class Op, class L, class R> class Matrice3DBinary : public Matrice3DExpr<Matrice3DBinary<Op, L, R> > {
+    L _l; ///< operando sinistro
+    R _r; ///< operando destro
+
+    public:
+    typedef decltype(Op()(std::declval<typename L::value_type>(), std::declval<typename R::value_type>())) value_type;
+
+    Matrice3DBinary(const L &l, const R &r) : _l(l), _r(r) {
+        if (l.sizeZ() != r.sizeZ() || l.sizeY() != r.sizeY() || l.sizeX() != r.sizeX())
+            throw Matrice3DInvalidParameters("ERRORE: Dimensioni delle matrici non compatibili");
+    }
+
+    unsigned int sizeZ() const { return _l.sizeZ(); }
+    unsigned int sizeY() const { return _l.sizeY(); }
+    unsigned int sizeX() const { return _l.sizeX(); }
+    std::size_t size() const { return _l.size(); }
+    value_type operator[](std::size_t i) const { return Op()(_l[i], _r[i]); }
+    const L &left() const { return _l; }
+    const R &right() const { return _r; }
+};
+
+/**
+    @brief Nodo interno: operazione unaria Op applicata elemento per elemento
+*/
+template <class Op, class E> class Matrice3DUnary : public Matrice3DExpr<Matrice3DUnary<Op, E> > {
+    E _e; ///< operando
+
+    public:
+    typedef decltype(Op()(std::declval<typename E::value_type>())) value_type;
+
+    explicit Matrice3DUnary(const E &e) : _e(e) {}
+
+    unsigned int sizeZ() const { return _e.sizeZ(); }
+    unsigned int sizeY() const { return _e.sizeY(); }
+    unsigned int sizeX() const { return _e.sizeX(); }
+    std::size_t size() const { return _e.size(); }
+    value_type operator[](std::size_t i) const { return Op()(_e[i]); }
+};
+
+/// Funtori delle operazioni element-wise
+struct m3dAdd { template <class A, class B> auto operator()(const A &a, const B &b) const -> decltype(a + b) { return a + b; } };
+struct m3dSub { template <class A, class B> auto operator()(const A &a, const B &b) const -> decltype(a - b) { return a - b; } };
+struct m3dMul { template <class A, class B> auto operator()(const A &a, const B &b) const -> decltype(a * b) { return a * b; } };
+struct m3dDiv { template <class A, class B> auto operator()(const A &a, const B &b) const -> decltype(a / b) { return a / b; } };
+struct m3dNeg { template <class A> auto operator()(const A &a) const -> decltype(-a) { return -a; } };
+
+/**
+    @brief Trait che riconosce gli operandi degli operatori element-wise
+           (Matrice3D di qualsiasi tipo e nodi di espressione) e li converte in nodi.
+*/
+template <class X, class = void> struct m3dOperand {
+    static const bool value = false;
+};
+
+template <class T, class Cmp, class Check, class Alloc> struct m3dOperand<Matrice3D<T, Cmp, Check, Alloc> > {
+    static const bool value = true;
+    typedef Matrice3DTerminal<T> node;
+    static node make(const Matrice3D<T, Cmp, Check, Alloc> &m) { return node(m); }
+};
+
+template <class E> struct m3dOperand<E, typename std::enable_if<std::is_base_of<Matrice3DExpr<E>, E>::value>::type> {
+    static const bool value = true;
+    typedef E node;
+    static const E &make(const E &e) { return e; }
+};
+
+/// Gli scalari ammessi sono i tipi aritmetici
+template <class S> struct m3dScalar {
+    static const bool value = std::is_arithmetic<S>::value;
+};
+
+/**
+    Genera l'operatore OP (funtore FUN) nelle tre forme:
+    operando OP operando, operando OP scalare e scalare OP operando.
+*/
+#define MATRICE3D_BINARY_OPERATOR(OP, FUN)                                                              \
+template <class L, class R>                                                                            \
+typename std::enable_if<m3dOperand<L>::value && m3dOperand<R>::value,                                  \
+    Matrice3DBinary<FUN, typename m3dOperand<L>::node, typename m3dOperand<R>::node> >::type           \
+operator OP(const L &l, const R &r) {                                                                  \
+    return Matrice3DBinary<FUN, typename m3dOperand<L>::node, typename m3dOperand<R>::node>(           \
+        m3dOperand<L>::make(l), m3dOperand<R>::make(r));                                               \
+}                                                                                                      \
+template <class L, class S>                                                                            \
+typename std::enable_if<m3dOperand<L>::value && m3dScalar<S>::value,                                   \
+    Matrice3DBinary<FUN, typename m3dOperand<L>::node, Matrice3DScalar<S> > >::type                    \
+operator OP(const L &l, const S &s) {                                                                  \
+    typename m3dOperand<L>::node n = m3dOperand<L>::make(l);                                           \
+    return Matrice3DBinary<FUN, typename m3dOperand<L>::node, Matrice3DScalar<S> >(                    \
+        n, Matrice3DScalar<S>(s, n));                                                                  \
+}                                                                                                      \
+template <class S, class R>                                                                            \
+typename std::enable_if<m3dScalar<S>::value && m3dOperand<R>::value,                                   \
+    Matrice3DBinary<FUN, Matrice3DScalar<S>, typename m3dOperand<R>::node> >::type                     \
+operator OP(const S &s, const R &r) {                                                                  \
+    typename m3dOperand<R>::node n = m3dOperand<R>::make(r);                                           \
+    return Matrice3DBinary<FUN, Matrice3DScalar<S>, typename m3dOperand<R>::node>(                     \
+        Matrice3DScalar<S>(s, n), n);                                                                  \
+}
+
+MATRICE3D_BINARY_OPERATOR(+, m3dAdd)
+MATRICE3D_BINARY_OPERATOR(-, m3dSub)
+MATRICE3D_BINARY_OPERATOR(*, m3dMul)
+MATRICE3D_BINARY_OPERATOR(/, m3dDiv)
+
+#undef MATRICE3D_BINARY_OPERATOR
+
+/**
+    Operatore - unario: opposto elemento per elemento
+*/
+template <class E>
+typename std::enable_if<m3dOperand<E>::value, Matrice3DUnary<m3dNeg, typename m3dOperand<E>::node> >::type
+operator-(const E &e) {
+    return Matrice3DUnary<m3dNeg, typename m3dOperand<E>::node>(m3dOperand<E>::make(e));
+}
+
+/**
+    @brief Funtore fma: a * b + c, con un solo arrotondamento per float e double
+*/
+struct m3dFmaOp {
+    template <class A, class B, class C>
+    auto operator()(const A &a, const B &b, const C &c) const -> decltype(a * b + c) { return a * b + c; }
+    float operator()(float a, float b, float c) const { return std::fma(a, b, c); }
+    double operator()(double a, double b, double c) const { return std::fma(a, b, c); }
+};
+
+/**
+    @brief Nodo interno: fused multiply-add a * b + c elemento per elemento
+
+    @throw Matrice3DInvalidParameters se gli operandi hanno dimensioni diverse
+*/
+template <class A, class B, class C> class Matrice3DFma : public Matrice3DExpr<Matrice3DFma<A, B, C> > {
+    A _a; ///< primo fattore
+    B _b; ///< secondo fattore
+    C _c; ///< addendo
+
+    public:
+    typedef decltype(m3dFmaOp()(std::declval<typename A::value_type>(), std::declval<typename B::value_type>(),
+                                std::declval<typename C::value_type>())) value_type;
+
+    Matrice3DFma(const A &a, const B &b, const C &c) : _a(a), _b(b), _c(c) {
+        if (a.sizeZ() != b.sizeZ() || a.sizeY() != b.sizeY() || a.sizeX() != b.sizeX() ||
+            a.sizeZ() != c.sizeZ() || a.sizeY() != c.sizeY() || a.sizeX() != c.sizeX())
+            throw Matrice3DInvalidParameters("ERRORE: Dimensioni delle matrici non compatibili");
+    }
+
+    unsigned int sizeZ() const { return _a.sizeZ(); }
+    unsigned int sizeY() const { return _a.sizeY(); }
+    unsigned int sizeX() const { return _a.sizeX(); }
+    std::size_t size() const { return _a.size(); }
+    value_type operator[](std::size_t i) const { return m3dFmaOp()(_a[i], _b[i], _c[i]); }
+    const A &first() const { return _a; }
+    const B &second() const { return _b; }
+    const C &third() const { return _c; }
+};
+
+/**
+    @brief Nodo interno: clamp elemento per elemento nell'intervallo [lo, hi]
+*/
+template <class E, class S> class Matrice3DClamp : public Matrice3DExpr<Matrice3DClamp<E, S> > {
+    E _e; ///< operando
+    S _lo; ///< limite inferiore
+    S _hi; ///< limite superiore
+
+    public:
+    typedef typename E::value_type value_type;
+
+    Matrice3DClamp(const E &e, const S &lo, const S &hi) : _e(e), _lo(lo), _hi(hi) {}
+
+    unsigned int sizeZ() const { return _e.sizeZ(); }
+    unsigned int sizeY() const { return _e.sizeY(); }
+    unsigned int sizeX() const { return _e.sizeX(); }
+    std::size_t size() const { return _e.size(); }
+    value_type operator[](std::size_t i) const {
+        value_type v = _e[i];
+        return v < _lo ? _lo : (_hi < v ? _hi : v);
+    }
+    const E &operand() const { return _e; }
+    const S &lo() const { return _lo; }
+    const S &hi() const { return _hi; }
+};
+
+/**
+    fma(a, b, c): espressione a * b + c con un solo arrotondamento (vedi std::fma)
+*/
+template <class A, class B, class C>
+typename std::enable_if<m3dOperand<A>::value && m3dOperand<B>::value && m3dOperand<C>::value,
+    Matrice3DFma<typename m3dOperand<A>::node, typename m3dOperand<B>::node, typename m3dOperand<C>::node> >::type
+fma(const A &a, const B &b, const C &c) {
+    return Matrice3DFma<typename m3dOperand<A>::node, typename m3dOperand<B>::node, typename m3dOperand<C>::node>(
+        m3dOperand<A>::make(a), m3dOperand<B>::make(b), m3dOperand<C>::make(c));
+}
+
+/**
+    clamp(e, lo, hi): espressione con gli elementi di e limitati all'intervallo [lo, hi]
+*/
+template <class E, class S>
+typename std::enable_if<m3dOperand<E>::value && m3dScalar<S>::value,
+    Matrice3DClamp<typename m3dOperand<E>::node, S> >::type
+clamp(const E &e, const S &lo, const S &hi) {
+    return Matrice3DClamp<typename m3dOperand<E>::node, S>(m3dOperand<E>::make(e), lo, hi);
+}
+
+/**
+    @brief Valutazione di un'espressione nel buffer dst (n elementi)
+
+    La versione generica esegue un unico ciclo scalare sull'intera espressione.
+    Le forme piu' comuni su operandi dello stesso tipo aritmetico (A + B, A * B,
+    fma(A, B, C), clamp(A, lo, hi)) usano invece i kernel vettoriali di Matrice3DSimd.
+*/
+template <class T, class E>
+void m3dEvaluate(T *dst, const E &e, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++)
+        dst[i] = static_cast<T>(e[i]);
+}
+
+template <class T>
+void m3dEvaluate(T *dst, const Matrice3DBinary<m3dAdd, Matrice3DTerminal<T>, Matrice3DTerminal<T> > &e, std::size_t n) {
+    Matrice3DSimd::add(dst, e.left().data(), e.right().data(), n);
+}
+
+template <class T>
+void m3dEvaluate(T *dst, const Matrice3DBinary<m3dMul, Matrice3DTerminal<T>, Matrice3DTerminal<T> > &e, std::size_t n) {
+    Matrice3DSimd::mul(dst, e.left().data(), e.right().data(), n);
+}
+
+template <class T>
+void m3dEvaluate(T *dst, const Matrice3DFma<Matrice3DTerminal<T>, Matrice3DTerminal<T>, Matrice3DTerminal<T> > &e, std::size_t n) {
+    Matrice3DSimd::fma(dst, e.first().data(), e.second().data(), e.third().data(), n);
+}
+
+template <class T>
+void m3dEvaluate(T *dst, const Matrice3DClamp<Matrice3DTerminal<T>, T> &e, std::size_t n) {
+    Matrice3DSimd::clamp(dst, e.operand().data(), e.lo(), e.hi(), n);
+}
+
+#endif
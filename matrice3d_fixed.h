@@ -0,0 +1,232 @@
+#ifndef MATRICE3D_FIXED_H
+#define MATRICE3D_FIXED_H
+
+#include <cstddef> // size_t
+#include <type_traits> // is_trivially_copyable
+#include <utility> // index_sequence
+#include "matrice3d.h" // Matrice3D, defaultCmp, checkedAccess
+
+/**
+    Chiama f(i) per i = 0 .. N-1. Fino a 64 elementi le chiamate vengono espanse a
+    tempo di compilazione (nessun ciclo), oltre resta un ciclo con limite costante.
+*/
+template <std::size_t N, class F, std::size_t... I>
+constexpr void m3dUnroll(F &f, std::index_sequence<I...>) {
+    (f(I), ...);
+}
+
+template <std::size_t N, class F>
+constexpr void m3dUnroll(F f) {
+    if constexpr (N <= 64)
+        m3dUnroll<N>(f, std::make_index_sequence<N>());
+    else
+        for (std::size_t i = 0; i < N; i++)
+            f(i);
+}
+
+/**
+    @brief Classe Matrice3DFixed: Matrice3D con dimensioni note a tempo di compilazione
+
+    Le dimensioni Z, Y, X e gli stride sono costanti (constexpr) e gli elementi stanno
+    dentro l'oggetto (sullo stack o nel contenitore che lo ospita): nessuna allocazione
+    dinamica, copia banale per i tipi banali e cicli di lunghezza nota che il
+    compilatore puo' srotolare. Pensata per i blocchi piccoli (3x3x3, 4x4x4) creati in
+    grande numero.
+
+    Gli elementi sono in row-major: l'elemento (z, y, x) si trova in
+    data()[z * strideZ() + y * strideY() + x]. Alla costruzione valgono T().
+
+    Si converte da e verso la Matrice3D dinamica (costruttore esplicito e operatore di
+    conversione), si confronta con == anche con una Matrice3D e supporta trasform().
+
+*/
+template <class T, unsigned int Z, unsigned int Y, unsigned int X, class Cmp = defaultCmp, class Check = checkedAccess>
+class Matrice3DFixed
+{
+    static_assert(Z > 0 && Y > 0 && X > 0, "Matrice3DFixed: le dimensioni devono essere positive");
+    // Il volume e' noto a tempo di compilazione: indici e size() restano a 32 bit
+    static_assert((unsigned long long)Z * Y * X <= 0xffffffffULL, "Matrice3DFixed: volume oltre 2^32 elementi");
+
+    T _data[Z * Y * X]; ///< elementi in row-major
+
+    public:
+
+    typedef T value_type; ///< tipo degli elementi
+    typedef T *iterator; ///< iteratore (puntatore, come la Matrice3D row-major)
+    typedef const T *const_iterator; ///< iteratore costante
+
+    static constexpr unsigned int sizeZ() { return Z; } ///< dimensione Z
+    static constexpr unsigned int sizeY() { return Y; } ///< dimensione Y
+    static constexpr unsigned int sizeX() { return X; } ///< dimensione X
+    static constexpr unsigned int size() { return Z * Y * X; } ///< dimensione totale
+    static constexpr unsigned int strideY() { return X; } ///< distanza tra due righe
+    static constexpr unsigned int strideZ() { return X * Y; } ///< distanza tra due piani
+
+    /**
+        Costruttore di default: tutti gli elementi valgono T()
+    */
+    constexpr Matrice3DFixed() : _data() {}
+
+    /**
+        Costruttore: tutti gli elementi valgono value
+
+        @param value valore degli elementi
+    */
+    constexpr explicit Matrice3DFixed(const T &value) : _data() {
+        for (unsigned int i = 0; i < size(); i++)
+            _data[i] = value;
+    }
+
+    /**
+        Costruttore di conversione da Matrice3DFixed<U> con le stesse dimensioni
+
+        @param other Matrice3DFixed da convertire
+        @post this->operator()(i,j,k) = static_cast<T>(other(i, j, k))
+    */
+    template <class U, class C, class Ch>
+    constexpr explicit Matrice3DFixed(const Matrice3DFixed<U, Z, Y, X, C, Ch> &other) : _data() {
+        const U *src = other.data();
+        m3dUnroll<size()>([&](std::size_t i) { _data[i] = static_cast<T>(src[i]); });
+    }
+
+    /**
+        Costruttore di conversione da una Matrice3D dinamica (qualsiasi layout)
+
+        @param other Matrice3D da convertire, con dimensioni Z x Y x X
+        @post this->operator()(i,j,k) = static_cast<T>(other(i, j, k))
+
+        @throw Matrice3DInvalidParameters se le dimensioni sono diverse
+    */
+    template <class U, class C, class Ch, class A, class L>
+    explicit Matrice3DFixed(const Matrice3D<U, C, Ch, A, L> &other) : _data() {
+        if (other.sizeZ() != Z || other.sizeY() != Y || other.sizeX() != X)
+            throw Matrice3DInvalidParameters("ERRORE: Dimensioni diverse da quelle della Matrice3DFixed");
+        typename Matrice3D<U, C, Ch, A, L>::const_iterator it = other.begin();
+        for (unsigned int i = 0; i < size(); i++, ++it)
+            _data[i] = static_cast<T>(*it);
+    }
+
+    /**
+        Operatore di conversione in una Matrice3D dinamica (qualsiasi tipo e politiche),
+        es. Matrice3D<double> d = f;
+
+        @return Matrice3D con gli stessi valori convertiti in U
+    */
+    template <class U, class C, class Ch, class A, class L>
+    operator Matrice3D<U, C, Ch, A, L>() const {
+        Matrice3D<U, C, Ch, A, L> res(Z, Y, X);
+        typename Matrice3D<U, C, Ch, A, L>::iterator it = res.begin();
+        for (unsigned int i = 0; i < size(); i++, ++it)
+            *it = static_cast<U>(_data[i]);
+        return res;
+    }
+
+    /**
+        Operatore (): Ritorna il valore delle coordinate (z, y, x).
+        Il controllo delle coordinate dipende dalla politica Check.
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    const T& operator()(int z, int y, int x) const {
+        Check::check(z, y, x, Z, Y, X);
+        return _data[(z * Y + y) * X + x];
+    }
+
+    T& operator()(int z, int y, int x) {
+        Check::check(z, y, x, Z, Y, X);
+        return _data[(z * Y + y) * X + x];
+    }
+
+    /**
+        Metodo at_unchecked: Ritorna il valore delle coordinate (z, y, x) senza controlli.
+        Utilizzabile nelle espressioni costanti.
+
+        @pre 0 <= z < Z, 0 <= y < Y, 0 <= x < X
+    */
+    constexpr const T& at_unchecked(unsigned int z, unsigned int y, unsigned int x) const {
+        return _data[(z * Y + y) * X + x];
+    }
+
+    constexpr T& at_unchecked(unsigned int z, unsigned int y, unsigned int x) {
+        return _data[(z * Y + y) * X + x];
+    }
+
+    constexpr T *data() { return _data; } ///< puntatore al primo elemento
+    constexpr const T *data() const { return _data; } ///< puntatore costante al primo elemento
+
+    // Metodi membro begin() e end() per l'iterazione
+    constexpr iterator begin() { return _data; }
+    constexpr iterator end() { return _data + size(); }
+    constexpr const_iterator begin() const { return _data; }
+    constexpr const_iterator end() const { return _data + size(); }
+
+    /**
+        Metodo fill: copia nella matrice i valori della sequenza [it, ite), al massimo
+        size() valori; gli elementi successivi restano invariati.
+
+        @param it, ite iteratori di inizio e fine della sequenza
+    */
+    template <class Iter>
+    void fill(Iter it, Iter ite) {
+        for (unsigned int i = 0; i < size() && it != ite; i++, ++it)
+            _data[i] = static_cast<T>(*it);
+    }
+
+    /**
+        Operator ==: Verifica che due Matrice3DFixed contengano gli stessi valori
+        (le dimensioni coincidono per costruzione).
+
+        @param other Matrice3DFixed da confrontare
+
+        @return true se le due matrici contengono gli stessi valori, false altrimenti
+    */
+    constexpr bool operator==(const Matrice3DFixed &other) const {
+        Cmp cmp;
+        bool equal = true;
+        m3dUnroll<size()>([&](std::size_t i) { equal = equal && cmp(_data[i], other._data[i]); });
+        return equal;
+    }
+};
+
+/**
+    Operator ==: confronto tra una Matrice3DFixed e una Matrice3D dinamica (in entrambi
+    gli ordini), con il funtore della Matrice3DFixed.
+
+    @return true se le dimensioni e i valori coincidono, false altrimenti
+*/
+template <class T, unsigned int Z, unsigned int Y, unsigned int X, class Cmp, class Check, class... PT>
+bool operator==(const Matrice3DFixed<T, Z, Y, X, Cmp, Check> &a, const Matrice3D<T, PT...> &b) {
+    if (b.sizeZ() != Z || b.sizeY() != Y || b.sizeX() != X)
+        return false;
+    Cmp cmp;
+    typename Matrice3D<T, PT...>::const_iterator it = b.begin();
+    for (unsigned int i = 0; i < a.size(); i++, ++it)
+        if (!cmp(a.data()[i], *it))
+            return false;
+    return true;
+}
+
+template <class T, unsigned int Z, unsigned int Y, unsigned int X, class Cmp, class Check, class... PT>
+bool operator==(const Matrice3D<T, PT...> &a, const Matrice3DFixed<T, Z, Y, X, Cmp, Check> &b) {
+    return b == a;
+}
+
+/**
+    Metodo GLOBALE transform per la Matrice3DFixed: B(i,j,k) = F(A(i,j,k)), con le
+    stesse dimensioni e senza allocazioni. Il ciclo ha lunghezza costante.
+
+    @param A Matrice3DFixed su tipi T, F funtore generico
+
+    @return Matrice3DFixed B su tipi Q con il funtore applicato
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, unsigned int Z, unsigned int Y, unsigned int X,
+          class C, class Ch, typename F>
+Matrice3DFixed<Q, Z, Y, X, FQ, Ch> trasform(const Matrice3DFixed<T, Z, Y, X, C, Ch> &A, F funz) {
+    Matrice3DFixed<Q, Z, Y, X, FQ, Ch> B;
+    const T *in = A.data();
+    Q *out = B.data();
+    m3dUnroll<Z * Y * X>([&](std::size_t i) { out[i] = static_cast<Q>(funz(in[i])); });
+    return B;
+}
+
+#endif
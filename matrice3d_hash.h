@@ -0,0 +1,103 @@
+#ifndef MATRICE3D_HASH_H
+#define MATRICE3D_HASH_H
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstring> // memcpy
+#include <type_traits> // is_integral, is_enum, is_same, has_unique_object_representations
+
+/**
+    @brief Trait dei tipi la cui uguaglianza (operatore ==) coincide con quella dei byte
+
+    Vale per interi, enum e puntatori. Per questi tipi, con defaultCmp, l'operatore ==
+    della Matrice3D confronta i buffer con memcmp e hash() puo' lavorare sui byte.
+    Si puo' specializzare per i propri tipi senza byte di riempimento il cui operatore
+    == confronta tutti i campi, es.
+
+        template <> struct m3dBitwiseEqual<Voxel> : std::true_type {};
+*/
+template <class T> struct m3dBitwiseEqual
+    : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+/**
+    @brief Trait dei tipi per cui la Matrice3D calcola hash(): quelli confrontabili byte
+           a byte, float e double (con -0 e +0 resi uguali prima dell'hash).
+
+    long double e' escluso: su x86 occupa 16 byte di cui 6 di riempimento, che finirebbero
+    nell'hash con valori arbitrari.
+*/
+template <class T> struct m3dHashable
+    : std::integral_constant<bool, m3dBitwiseEqual<T>::value || std::is_same<T, float>::value ||
+                                   std::is_same<T, double>::value> {};
+
+static const std::size_t m3dHashChunk = std::size_t(1) << 16; ///< elementi per hash parziale
+
+static const std::uint64_t m3dHashPrime1 = 0x9E3779B185EBCA87ULL;
+static const std::uint64_t m3dHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+/// Mescolamento finale a 64 bit (avalanche)
+inline std::uint64_t m3dHashMix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/// Combina l'hash h con il valore v (dipende dall'ordine)
+inline std::uint64_t m3dHashCombine(std::uint64_t h, std::uint64_t v) {
+    return m3dHashMix(h ^ (v + m3dHashPrime1 + (h << 6) + (h >> 2)));
+}
+
+/**
+    Hash di bytes byte: quattro accumulatori indipendenti su parole da 8 byte (come
+    xxHash64), cosi' il ciclo procede alla velocita' della memoria.
+*/
+inline std::uint64_t m3dHashBytes(const void *data, std::size_t bytes, std::uint64_t seed) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    std::uint64_t a[4] = {seed + m3dHashPrime1 + m3dHashPrime2, seed + m3dHashPrime2, seed, seed - m3dHashPrime1};
+    std::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+        for (int k = 0; k < 4; k++) {
+            std::uint64_t w;
+            std::memcpy(&w, p + i + 8 * k, 8);
+            a[k] += w * m3dHashPrime2;
+            a[k] = (a[k] << 31) | (a[k] >> 33);
+            a[k] *= m3dHashPrime1;
+        }
+    std::uint64_t h = m3dHashCombine(m3dHashCombine(a[0], a[1]), m3dHashCombine(a[2], a[3]));
+    for (; i < bytes; i += 8) {
+        std::uint64_t w = 0;
+        std::memcpy(&w, p + i, bytes - i < 8 ? bytes - i : 8);
+        h = m3dHashCombine(h, w);
+    }
+    return m3dHashCombine(h, bytes);
+}
+
+/**
+    Hash di n elementi consecutivi. Per i floating point gli elementi uguali secondo ==
+    devono avere lo stesso hash: -0 viene sostituito con +0 (a blocchi in un buffer).
+*/
+template <class T>
+std::uint64_t m3dHashElements(const T *data, std::size_t n, std::uint64_t seed) {
+    static_assert(m3dHashable<T>::value, "hash(): tipo non supportato (vedi m3dBitwiseEqual)");
+    if constexpr (std::is_floating_point<T>::value) {
+        const std::size_t B = 256;
+        T buffer[B];
+        std::uint64_t h = seed;
+        for (std::size_t i = 0; i < n; i += B) {
+            std::size_t c = n - i < B ? n - i : B;
+            for (std::size_t k = 0; k < c; k++)
+                buffer[k] = data[i + k] == T(0) ? T(0) : data[i + k];
+            h = m3dHashBytes(buffer, c * sizeof(T), h);
+        }
+        return h;
+    } else {
+        static_assert(!std::is_class<T>::value || std::has_unique_object_representations<T>::value,
+                      "m3dBitwiseEqual: il tipo ha byte di riempimento");
+        return m3dHashBytes(data, n * sizeof(T), seed);
+    }
+}
+
+#endif
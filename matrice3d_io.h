@@ -0,0 +1,408 @@
+#ifndef MATRICE3D_IO_H
+#define MATRICE3D_IO_H
+
+#include <cstdint> // uint8_t, uint16_t, uint32_t, uint64_t
+#include <climits> // INT_MAX
+#include <cstring> // memcpy, memcmp
+#include <fstream> // ifstream, ofstream
+#include <memory> // shared_ptr
+#include <string> // string
+#include "matrice3d.h" // Matrice3D
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+#define MATRICE3D_MMAP 1
+#endif
+
+/**
+    @brief Formato binario dei file Matrice3D (versione 1)
+
+    Il file inizia con un header di 64 byte seguito dal buffer della matrice, copiato
+    byte per byte nell'ordine del layout (compreso l'eventuale riempimento), a partire
+    da dataOffset. Il buffer e' quindi allineato a 64 byte anche quando il file viene
+    mappato in memoria.
+
+    Tutti i campi sono scritti nell'ordine dei byte della macchina che ha salvato il
+    file; byteOrder (0x01020304) permette di riconoscere un file scritto con l'ordine
+    opposto, che load() converte durante la lettura.
+
+*/
+struct Matrice3DFileHeader {
+    char magic[4]; ///< "M3DF"
+    std::uint32_t byteOrder; ///< 0x01020304 nell'ordine dei byte di chi ha scritto
+    std::uint16_t version; ///< versione del formato
+    std::uint8_t type; ///< tipo degli elementi (vedi m3dTypeCode)
+    std::uint8_t typeSize; ///< sizeof del tipo degli elementi
+    std::uint8_t layout; ///< 0 row-major, 1 a mattoni, 2 Morton
+    std::uint8_t layoutParam; ///< lato dei mattoni per il layout a mattoni
+    std::uint16_t reserved0; ///< riservato (0)
+    std::uint64_t sizeZ; ///< dimensione Z
+    std::uint64_t sizeY; ///< dimensione Y
+    std::uint64_t sizeX; ///< dimensione X
+    std::uint64_t count; ///< elementi del buffer (storage_size())
+    std::uint64_t dataOffset; ///< posizione del buffer nel file
+    std::uint64_t reserved1; ///< riservato (0)
+
+    static const std::uint32_t nativeOrder = 0x01020304;
+    static const std::uint16_t currentVersion = 1;
+    static const std::uint64_t dataAlignment = 64; ///< allineamento di dataOffset
+};
+
+static_assert(sizeof(Matrice3DFileHeader) == 64, "Matrice3DFileHeader deve occupare 64 byte");
+
+/**
+    Codice del tipo degli elementi nel file: solo i tipi aritmetici sono salvabili.
+    1/2 int8/uint8, 3/4 int16/uint16, 5/6 int32/uint32, 7/8 int64/uint64, 9 float, 10 double
+*/
+template <class T> constexpr std::uint8_t m3dTypeCode() {
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && sizeof(T) <= 8,
+                  "Matrice3D: solo i tipi aritmetici possono essere salvati su file");
+    if (std::is_floating_point<T>::value)
+        return sizeof(T) == 4 ? 9 : 10;
+    std::uint8_t base = sizeof(T) == 1 ? 1 : sizeof(T) == 2 ? 3 : sizeof(T) == 4 ? 5 : 7;
+    return std::is_signed<T>::value ? base : base + 1;
+}
+
+/**
+    Codice e parametro del layout nel file
+*/
+template <class Layout> struct m3dLayoutCode;
+
+template <> struct m3dLayoutCode<rowMajorLayout> {
+    static const std::uint8_t code = 0;
+    static const std::uint8_t param = 0;
+};
+
+template <unsigned int B> struct m3dLayoutCode<tiledLayout<B> > {
+    static_assert(B < 256, "tiledLayout: mattoni troppo grandi per il formato su file");
+    static const std::uint8_t code = 1;
+    static const std::uint8_t param = B;
+};
+
+template <> struct m3dLayoutCode<mortonLayout> {
+    static const std::uint8_t code = 2;
+    static const std::uint8_t param = 0;
+};
+
+/**
+    Inverte l'ordine dei byte di n elementi di size byte ciascuno
+*/
+inline void m3dByteSwap(void *data, std::size_t size, std::size_t n) {
+    unsigned char *p = static_cast<unsigned char *>(data);
+    for (std::size_t i = 0; i < n; i++, p += size)
+        for (std::size_t a = 0, b = size - 1; a < b; a++, b--) {
+            unsigned char t = p[a];
+            p[a] = p[b];
+            p[b] = t;
+        }
+}
+
+/**
+    @brief Classe Matrice3DMapping: file Matrice3D mappato in memoria
+
+    La mappatura e' privata (MAP_PRIVATE): in sola lettura le scritture non sono
+    ammesse, in copy-on-write le pagine modificate vengono copiate e il file su disco
+    non cambia. Le pagine vengono lette dal disco solo al primo accesso.
+
+*/
+class Matrice3DMapping {
+    void *_base; ///< inizio della mappatura
+    std::size_t _length; ///< byte mappati
+    char *_data; ///< inizio del buffer della matrice
+    std::size_t _bytes; ///< byte del buffer della matrice
+    bool _taken; ///< il buffer e' gia' stato consegnato a una Matrice3D
+
+    public:
+
+    /**
+        Mappa il file a partire da 0 fino alla fine del buffer della matrice
+
+        @param file percorso del file
+        @param offset posizione del buffer della matrice nel file
+        @param bytes byte del buffer della matrice
+        @param writable true per il copy-on-write, false per la sola lettura
+
+        @throw Matrice3DError se il file non puo' essere mappato
+    */
+    Matrice3DMapping(const std::string &file, std::size_t offset, std::size_t bytes, bool writable)
+        : _base(nullptr), _length(offset + bytes), _data(nullptr), _bytes(bytes), _taken(false) {
+#ifdef MATRICE3D_MMAP
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw Matrice3DError("ERRORE: Impossibile aprire il file");
+        void *p = ::mmap(nullptr, _length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw Matrice3DError("ERRORE: Impossibile mappare il file");
+        _base = p;
+        _data = static_cast<char *>(p) + offset;
+#else
+        (void)writable;
+        throw Matrice3DError("ERRORE: Mappatura dei file non disponibile su questa piattaforma");
+#endif
+    }
+
+    ~Matrice3DMapping() {
+#ifdef MATRICE3D_MMAP
+        if (_base != nullptr)
+            ::munmap(_base, _length);
+#endif
+    }
+
+    Matrice3DMapping(const Matrice3DMapping &) = delete;
+    Matrice3DMapping &operator=(const Matrice3DMapping &) = delete;
+
+    /**
+        Consegna il buffer mappato alla prima allocazione della dimensione giusta
+
+        @return puntatore al buffer, o nullptr se gia' consegnato o di dimensione diversa
+    */
+    void *take(std::size_t bytes) {
+        if (_taken || bytes != _bytes)
+            return nullptr;
+        _taken = true;
+        return _data;
+    }
+
+    /**
+        @return true se p appartiene al buffer mappato
+    */
+    bool contains(const void *p) const {
+        const char *c = static_cast<const char *>(p);
+        return _data != nullptr && c >= _data && c < _data + _bytes;
+    }
+};
+
+/**
+    @brief Allocatore delle Matrice3D mappate su file
+
+    La prima allocazione della dimensione del file riceve il buffer mappato, senza
+    alcuna lettura; la costruzione di default non sovrascrive gli elementi mappati.
+    Le altre allocazioni (es. le copie, che partono da un allocatore senza mappatura)
+    usano la memoria allineata di alignedAllocator. Il file resta mappato finche'
+    esiste la matrice (o una copia dell'allocatore che lo usa).
+
+*/
+template <class T> struct mappedAllocator {
+    typedef T value_type;
+
+    template <class U> struct rebind { typedef mappedAllocator<U> other; };
+
+    std::shared_ptr<Matrice3DMapping> mapping; ///< file mappato (nullptr: solo heap)
+
+    mappedAllocator() noexcept {}
+    explicit mappedAllocator(const std::shared_ptr<Matrice3DMapping> &m) noexcept : mapping(m) {}
+    template <class U> mappedAllocator(const mappedAllocator<U> &other) noexcept : mapping(other.mapping) {}
+
+    T *allocate(std::size_t n) {
+        if (mapping)
+            if (void *p = mapping->take(n * sizeof(T)))
+                return static_cast<T *>(p);
+        return alignedAllocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        if (mapping && mapping->contains(p))
+            mapping.reset();
+        else
+            alignedAllocator<T>().deallocate(p, n);
+    }
+
+    template <class U, class... Args> void construct(U *p, Args &&... args) {
+        // La costruzione di default lascia intatti i valori letti dal file
+        if constexpr (sizeof...(Args) == 0)
+            if (mapping && mapping->contains(p))
+                return;
+        ::new ((void *)p) U(std::forward<Args>(args)...);
+    }
+
+    // Le copie di una matrice mappata vivono sull'heap
+    mappedAllocator select_on_container_copy_construction() const { return mappedAllocator(); }
+
+    template <class U> bool operator==(const mappedAllocator<U> &other) const noexcept { return mapping == other.mapping; }
+    template <class U> bool operator!=(const mappedAllocator<U> &other) const noexcept { return mapping != other.mapping; }
+};
+
+/**
+    Matrice3D mappata su file (vedi load_mapped)
+*/
+template <class T, class Layout = rowMajorLayout>
+using Matrice3DMapped = Matrice3D<T, defaultCmp, checkedAccess, mappedAllocator<T>, Layout>;
+
+/**
+    Modalita' di mappatura: sola lettura o copy-on-write
+*/
+enum Matrice3DMapMode { m3dReadOnly, m3dCopyOnWrite };
+
+/**
+    Metodo GLOBALE save: Salva la Matrice3D m nel file binario file
+
+    @param m Matrice3D su un tipo aritmetico
+    @param file percorso del file (sovrascritto se esiste)
+
+    @throw Matrice3DError possibile eccezione di scrittura fallita
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+void save(const Matrice3D<T, Cmp, Check, Alloc, Layout> &m, const std::string &file) {
+    Matrice3DFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, "M3DF", 4);
+    h.byteOrder = Matrice3DFileHeader::nativeOrder;
+    h.version = Matrice3DFileHeader::currentVersion;
+    h.type = m3dTypeCode<T>();
+    h.typeSize = sizeof(T);
+    h.layout = m3dLayoutCode<Layout>::code;
+    h.layoutParam = m3dLayoutCode<Layout>::param;
+    h.sizeZ = m.sizeZ();
+    h.sizeY = m.sizeY();
+    h.sizeX = m.sizeX();
+    h.count = m.storage_size();
+    h.dataOffset = sizeof(h);
+    std::ofstream out(file.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    if (h.count > 0)
+        out.write(reinterpret_cast<const char *>(m.data()), std::streamsize(h.count * sizeof(T)));
+    out.close();
+    if (!out)
+        throw Matrice3DError("ERRORE: Scrittura del file fallita");
+}
+
+/**
+    Legge e controlla l'header del file per una Matrice3D di tipo M.
+    Ritorna true se il file e' stato scritto con l'ordine dei byte opposto.
+
+    Prima che venga allocato qualsiasi buffer controlla anche che le dimensioni siano
+    valide (1..INT_MAX, o tutte 0 per una matrice vuota), che count sia il numero di
+    elementi del buffer del layout e che il file contenga tutti i count elementi: un
+    header corrotto non puo' causare allocazioni piu' grandi del file.
+*/
+template <class M>
+bool m3dReadHeader(std::ifstream &in, Matrice3DFileHeader &h) {
+    typedef typename M::value_type T;
+    typedef typename M::layout_type Layout;
+    if (!in.read(reinterpret_cast<char *>(&h), sizeof(h)) || std::memcmp(h.magic, "M3DF", 4) != 0)
+        throw Matrice3DError("ERRORE: Il file non e' un file Matrice3D");
+    bool swapped = h.byteOrder != Matrice3DFileHeader::nativeOrder;
+    if (swapped) {
+        m3dByteSwap(&h.byteOrder, 4, 1);
+        if (h.byteOrder != Matrice3DFileHeader::nativeOrder)
+            throw Matrice3DError("ERRORE: Ordine dei byte del file non valido");
+        m3dByteSwap(&h.version, 2, 1);
+        m3dByteSwap(&h.sizeZ, 8, 6);
+    }
+    if (h.version > Matrice3DFileHeader::currentVersion)
+        throw Matrice3DError("ERRORE: Versione del file non supportata");
+    if (h.type != m3dTypeCode<T>() || h.typeSize != sizeof(T))
+        throw Matrice3DError("ERRORE: Tipo degli elementi del file diverso da quello della matrice");
+    if (h.layout != m3dLayoutCode<Layout>::code || h.layoutParam != m3dLayoutCode<Layout>::param)
+        throw Matrice3DError("ERRORE: Layout del file diverso da quello della matrice");
+    // Dimensioni e numero di elementi coerenti con il layout
+    std::uint64_t expected = 0;
+    if (h.sizeZ != 0 || h.sizeY != 0 || h.sizeX != 0) {
+        if (h.sizeZ < 1 || h.sizeZ > INT_MAX || h.sizeY < 1 || h.sizeY > INT_MAX || h.sizeX < 1 || h.sizeX > INT_MAX)
+            throw Matrice3DError("ERRORE: Dimensioni del file non valide");
+        try {
+            expected = m3dVolume(h.sizeZ, h.sizeY, h.sizeX);
+        }
+        catch (Matrice3DOutOfRange &) {
+            throw Matrice3DError("ERRORE: Dimensioni del file non valide");
+        }
+        if constexpr (!Layout::contiguous) {
+            Layout layout;
+            layout.resize(unsigned(h.sizeZ), unsigned(h.sizeY), unsigned(h.sizeX));
+            expected = layout.capacity();
+        }
+    }
+    if (h.count != expected)
+        throw Matrice3DError("ERRORE: Dimensioni del file non valide");
+    // Buffer allineato: load_mapped() e Matrice3DStream usano base + dataOffset come T*
+    if (h.dataOffset % Matrice3DFileHeader::dataAlignment != 0)
+        throw Matrice3DError("ERRORE: Posizione del buffer nel file non allineata");
+    // Il file deve contenere l'header e tutto il buffer (somma e prodotto senza overflow)
+    std::streamoff pos = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::uint64_t fileSize = std::uint64_t(in.tellg());
+    in.seekg(pos);
+    if (h.count > 0 && (h.dataOffset < sizeof(h) || h.dataOffset > fileSize ||
+                        h.count > (fileSize - h.dataOffset) / sizeof(T)))
+        throw Matrice3DError("ERRORE: File troncato");
+    return swapped;
+}
+
+/**
+    Metodo GLOBALE load: Legge una Matrice3D di tipo M dal file binario file.
+    Il tipo degli elementi e il layout devono coincidere con quelli del file; per un
+    tipo diverso si legge il tipo del file e si usa il costruttore di conversione.
+
+    Es. Matrice3D<float> m = load<Matrice3D<float> >("volume.m3d");
+
+    @param file percorso del file
+    @param alloc allocatore della Matrice3D letta
+
+    @return Matrice3D con i valori del file
+
+    @throw Matrice3DError possibile eccezione di lettura fallita o di file non compatibile
+*/
+template <class M>
+M load(const std::string &file, const typename M::allocator_type &alloc = typename M::allocator_type()) {
+    typedef typename M::value_type T;
+    std::ifstream in(file.c_str(), std::ios::binary);
+    if (!in)
+        throw Matrice3DError("ERRORE: Impossibile aprire il file");
+    Matrice3DFileHeader h;
+    bool swapped = m3dReadHeader<M>(in, h);
+    if (h.count == 0)
+        return M(alloc);
+    M m(int(h.sizeZ), int(h.sizeY), int(h.sizeX), alloc);
+    in.seekg(std::streamoff(h.dataOffset));
+    if (!in.read(reinterpret_cast<char *>(m.data()), std::streamsize(h.count * sizeof(T))))
+        throw Matrice3DError("ERRORE: Lettura del file fallita");
+    if (swapped)
+        m3dByteSwap(m.data(), sizeof(T), h.count);
+    return m;
+}
+
+/**
+    Metodo GLOBALE load_mapped: Apre il file binario file come Matrice3D mappata in
+    memoria, senza leggerlo: il tempo di apertura non dipende dalla dimensione del file
+    e le pagine vengono caricate al primo accesso.
+
+    Es. const Matrice3DMapped<float> m = load_mapped<Matrice3DMapped<float> >("volume.m3d");
+
+    In sola lettura (m3dReadOnly) scrivere nella matrice termina il programma (SIGSEGV):
+    conviene dichiararla const. In copy-on-write le scritture restano in memoria.
+    Il file deve essere stato scritto con l'ordine dei byte di questa macchina.
+
+    @param file percorso del file
+    @param mode m3dReadOnly o m3dCopyOnWrite
+
+    @return Matrice3D M (con allocatore mappedAllocator) sui dati del file
+
+    @throw Matrice3DError possibile eccezione di file non compatibile o non mappabile
+*/
+template <class M>
+M load_mapped(const std::string &file, Matrice3DMapMode mode = m3dReadOnly) {
+    typedef typename M::value_type T;
+    typedef typename M::allocator_type A;
+    static_assert(std::is_same<A, mappedAllocator<T> >::value, "load_mapped: serve una Matrice3D con mappedAllocator");
+    Matrice3DFileHeader h;
+    {
+        std::ifstream in(file.c_str(), std::ios::binary);
+        if (!in)
+            throw Matrice3DError("ERRORE: Impossibile aprire il file");
+        if (m3dReadHeader<M>(in, h))
+            throw Matrice3DError("ERRORE: Il file ha un ordine dei byte diverso: usare load()");
+    }
+    if (h.count == 0)
+        return M();
+    A alloc(std::make_shared<Matrice3DMapping>(file, h.dataOffset, h.count * sizeof(T), mode == m3dCopyOnWrite));
+    M m(int(h.sizeZ), int(h.sizeY), int(h.sizeX), alloc);
+    if (!alloc.mapping->contains(m.data()))
+        throw Matrice3DError("ERRORE: Dimensioni del file non valide");
+    return m;
+}
+
+#endif
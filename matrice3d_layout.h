@@ -0,0 +1,196 @@
+#ifndef MATRICE3D_LAYOUT_H
+#define MATRICE3D_LAYOUT_H
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+
+/**
+    @brief Politiche di layout della memoria della Matrice3D
+
+    Il layout stabilisce in quale posizione del buffer si trova l'elemento (z, y, x).
+    Tutti i layout sono separabili: la posizione e' offsetZ(z) + offsetY(y) + offsetX(x),
+    quindi nei cicli annidati gli offset di piano e di riga si calcolano una sola volta.
+
+    - rowMajorLayout (default): x, poi y, poi z. Il buffer e' contiguo e la Matrice3D
+      usa direttamente i propri stride.
+    - tiledLayout<B>: il volume e' diviso in mattoni B x B x B (B potenza di 2) memorizzati
+      uno dopo l'altro, row-major all'interno del mattone. Il vicino lungo z dista B * B
+      elementi invece di un piano intero.
+    - mortonLayout: ordine Z (Morton), con i bit delle coordinate intercalati. Elementi
+      vicini nello spazio restano vicini in memoria a tutte le scale.
+
+    I layout non contigui arrotondano le dimensioni (a multipli di B, o a potenze di 2 per
+    il Morton), quindi capacity() puo' superare z * y * x. Gli elementi di riempimento
+    valgono T() e non sono raggiungibili da operatore (), iteratori, slice() e ==.
+
+    Interfaccia di un layout non contiguo:
+    - static const bool contiguous = false
+    - void resize(unsigned int z, unsigned int y, unsigned int x)
+    - std::size_t capacity() const: elementi del buffer
+    - std::size_t offsetZ(unsigned int z) const, offsetY(y), offsetX(x)
+
+*/
+struct rowMajorLayout {
+    static const bool contiguous = true; ///< buffer contiguo, indirizzato con gli stride della matrice
+};
+
+/**
+    Prodotto a * b, saturato a SIZE_MAX se non sta in std::size_t: un layout troppo
+    grande risulta in una capacity() che nessun allocatore accetta, mai in un buffer
+    piu' piccolo del volume.
+*/
+inline std::size_t m3dMulSat(std::size_t a, std::size_t b) {
+    return a != 0 && b > std::size_t(-1) / a ? std::size_t(-1) : a * b;
+}
+
+/**
+    @brief Layout a mattoni B x B x B
+*/
+template <unsigned int B = 8> class tiledLayout {
+    static_assert(B > 0 && (B & (B - 1)) == 0, "tiledLayout: B deve essere una potenza di 2");
+
+    static const std::size_t brick = std::size_t(B) * B * B; ///< elementi di un mattone
+
+    std::size_t _brickY; ///< distanza tra due righe di mattoni
+    std::size_t _brickZ; ///< distanza tra due piani di mattoni
+    std::size_t _capacity; ///< elementi del buffer
+
+    public:
+
+    static const bool contiguous = false;
+
+    tiledLayout() : _brickY(0), _brickZ(0), _capacity(0) {}
+
+    /**
+        Calcola il layout per un volume di z * y * x elementi
+
+        @post capacity() == z, y, x arrotondati a multipli di B e moltiplicati
+              (SIZE_MAX se il prodotto non sta in std::size_t)
+    */
+    void resize(unsigned int z, unsigned int y, unsigned int x) {
+        _brickY = (std::size_t(x) + B - 1) / B * brick;
+        _brickZ = m3dMulSat((std::size_t(y) + B - 1) / B, _brickY);
+        _capacity = m3dMulSat((std::size_t(z) + B - 1) / B, _brickZ);
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    std::size_t offsetX(unsigned int x) const { return x / B * brick + x % B; }
+    std::size_t offsetY(unsigned int y) const { return y / B * _brickY + y % B * B; }
+    std::size_t offsetZ(unsigned int z) const { return z / B * _brickZ + z % B * B * B; }
+};
+
+/**
+    @brief Layout in ordine Morton (Z-order)
+
+    Ogni asse viene arrotondato alla potenza di 2 successiva. Al livello di bit i vengono
+    emessi, nell'ordine x, y, z, i bit degli assi che hanno ancora bit a quel livello:
+    finche' tutti e tre gli assi hanno bit l'intercalamento e' a tre vie, poi a due e infine
+    restano i bit dell'asse piu' lungo. Cosi' capacity() e' il prodotto delle dimensioni
+    arrotondate (e non il cubo della piu' grande) anche per volumi molto schiacciati.
+
+*/
+class mortonLayout {
+    unsigned int _low; ///< livelli a tre assi (bit dell'asse piu' corto)
+    unsigned int _mid; ///< livello in cui finiscono i livelli a due assi
+    std::uint64_t _lowMask; ///< bit di coordinata dei livelli a tre assi
+    std::uint64_t _midMask; ///< bit di coordinata dei livelli a due assi (dopo lo shift di _low)
+    unsigned int _shift3[3]; ///< posizione del primo bit di x, y, z nei livelli a tre assi
+    unsigned int _shift2[3]; ///< posizione del primo bit di x, y, z nei livelli a due assi
+    unsigned int _shift1; ///< posizione del primo bit dei livelli a un asse
+    std::size_t _capacity; ///< elementi del buffer
+
+    public:
+
+    static const bool contiguous = false;
+
+    mortonLayout() : _low(0), _mid(0), _lowMask(0), _midMask(0), _shift1(0), _capacity(0) {
+        for (int a = 0; a < 3; a++)
+            _shift3[a] = _shift2[a] = 0;
+    }
+
+    /**
+        Calcola il layout per un volume di z * y * x elementi
+
+        @post capacity() == prodotto di z, y, x arrotondati alla potenza di 2 successiva
+              (SIZE_MAX se il prodotto non sta in std::size_t)
+    */
+    void resize(unsigned int z, unsigned int y, unsigned int x) {
+        unsigned int bits[3] = { log2ceil(x), log2ceil(y), log2ceil(z) };
+        // Assi ordinati per numero di bit (a parita', nell'ordine x, y, z)
+        unsigned int order[3] = { 0, 1, 2 };
+        for (int i = 1; i < 3; i++)
+            for (int j = i; j > 0 && bits[order[j]] < bits[order[j - 1]]; j--) {
+                unsigned int t = order[j];
+                order[j] = order[j - 1];
+                order[j - 1] = t;
+            }
+        _low = bits[order[0]];
+        _mid = bits[order[1]];
+        _lowMask = (std::uint64_t(1) << _low) - 1;
+        _midMask = (std::uint64_t(1) << (_mid - _low)) - 1;
+        for (unsigned int a = 0; a < 3; a++)
+            _shift3[a] = a;
+        // Nei livelli a due assi restano gli assi order[1] e order[2], sempre nell'ordine x, y, z
+        unsigned int first = order[1] < order[2] ? order[1] : order[2];
+        unsigned int second = order[1] < order[2] ? order[2] : order[1];
+        _shift2[order[0]] = 0;
+        _shift2[first] = 3 * _low;
+        _shift2[second] = 3 * _low + 1;
+        _shift1 = 3 * _low + 2 * (_mid - _low);
+        unsigned int total = bits[0] + bits[1] + bits[2];
+        _capacity = total < sizeof(std::size_t) * 8 ? std::size_t(1) << total : std::size_t(-1);
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    std::size_t offsetX(unsigned int x) const { return offset(x, 0); }
+    std::size_t offsetY(unsigned int y) const { return offset(y, 1); }
+    std::size_t offsetZ(unsigned int z) const { return offset(z, 2); }
+
+    private:
+
+    /**
+        Offset del contributo della coordinata c sull'asse a (0 = x, 1 = y, 2 = z).
+        I bit oltre quelli dell'asse sono nulli, quindi per gli assi corti le parti a due
+        e a un asse valgono 0 senza bisogno di casi particolari.
+    */
+    std::size_t offset(unsigned int c, unsigned int a) const {
+        std::uint64_t v = c;
+        return (spread3(v & _lowMask) << _shift3[a]) |
+               (spread2((v >> _low) & _midMask) << _shift2[a]) |
+               ((v >> _mid) << _shift1);
+    }
+
+    /// Sposta il bit i di v (fino a 21 bit) in posizione 3 * i
+    static std::uint64_t spread3(std::uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffULL;
+        v = (v | v << 16) & 0x1f0000ff0000ffULL;
+        v = (v | v << 8) & 0x100f00f00f00f00fULL;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+        v = (v | v << 2) & 0x1249249249249249ULL;
+        return v;
+    }
+
+    /// Sposta il bit i di v (fino a 32 bit) in posizione 2 * i
+    static std::uint64_t spread2(std::uint64_t v) {
+        v &= 0xffffffffULL;
+        v = (v | v << 16) & 0x0000ffff0000ffffULL;
+        v = (v | v << 8) & 0x00ff00ff00ff00ffULL;
+        v = (v | v << 4) & 0x0f0f0f0f0f0f0f0fULL;
+        v = (v | v << 2) & 0x3333333333333333ULL;
+        v = (v | v << 1) & 0x5555555555555555ULL;
+        return v;
+    }
+
+    /// Numero di bit necessari per le coordinate 0..n-1
+    static unsigned int log2ceil(unsigned int n) {
+        unsigned int b = 0;
+        while ((std::uint64_t(1) << b) < n)
+            b++;
+        return b;
+    }
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef MATRICE3D_PARALLEL_H
+#define MATRICE3D_PARALLEL_H
+
+#include <cstddef> // size_t
+#include <vector> // thread
+#include <thread> // thread, hardware_concurrency
+#include <mutex> // mutex, unique_lock
+#include <condition_variable> // condition_variable
+#include <atomic> // atomic
+#include <functional> // function
+#include <exception> // exception_ptr
+
+/**
+    @brief Classe Matrice3DThreadPool: pool di thread persistente
+
+    I thread vengono creati una sola volta e riutilizzati da tutte le operazioni
+    parallele della Matrice3D, evitando il costo di creazione ad ogni chiamata.
+    parallelFor() divide un intervallo di indici in blocchi che vengono distribuiti
+    tra i thread del pool e il thread chiamante, e ritorna quando tutti i blocchi
+    sono stati eseguiti. Se un blocco lancia un'eccezione, la prima viene rilanciata
+    al chiamante dopo il completamento degli altri blocchi.
+
+    Le chiamate a parallelFor() da thread diversi vengono serializzate; una chiamata
+    annidata (da dentro un blocco) non e' ammessa.
+
+*/
+class Matrice3DThreadPool {
+    std::vector<std::thread> _threads; ///< thread del pool
+    std::mutex _mutex; ///< protegge lo stato del lavoro corrente
+    std::mutex _submit; ///< serializza le chiamate a parallelFor
+    std::condition_variable _wake; ///< sveglia i thread per un nuovo lavoro
+    std::condition_variable _done; ///< segnala la fine del lavoro al chiamante
+    const std::function<void(std::size_t)> *_job; ///< lavoro corrente (eseguito per blocco)
+    std::size_t _chunks; ///< numero di blocchi del lavoro corrente
+    std::atomic<std::size_t> _next; ///< prossimo blocco da eseguire
+    unsigned int _busy; ///< thread che non hanno ancora finito il lavoro corrente
+    unsigned long _generation; ///< contatore dei lavori (per svegliare i thread)
+    bool _stop; ///< richiesta di terminazione
+    std::exception_ptr _error; ///< prima eccezione lanciata da un blocco
+
+    public:
+
+    /**
+        Costruttore: avvia threads - 1 thread (il chiamante partecipa al lavoro)
+
+        @param threads numero totale di thread che eseguono il lavoro (almeno 1)
+    */
+    explicit Matrice3DThreadPool(unsigned int threads = std::thread::hardware_concurrency())
+        : _job(nullptr), _chunks(0), _next(0), _busy(0), _generation(0), _stop(false) {
+        if (threads == 0)
+            threads = 1;
+        for (unsigned int i = 1; i < threads; i++)
+            _threads.push_back(std::thread(&Matrice3DThreadPool::worker, this));
+    }
+
+    /**
+        Distruttore: termina e attende tutti i thread
+    */
+    ~Matrice3DThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (std::size_t i = 0; i < _threads.size(); i++)
+            _threads[i].join();
+    }
+
+    Matrice3DThreadPool(const Matrice3DThreadPool &) = delete;
+    Matrice3DThreadPool &operator=(const Matrice3DThreadPool &) = delete;
+
+    /**
+        @return numero di thread che eseguono il lavoro (chiamante compreso)
+    */
+    unsigned int size() const { return (unsigned int)_threads.size() + 1; }
+
+    /**
+        Esegue f(b, e) su blocchi [b, e) che coprono [0, n). Ogni blocco (tranne
+        l'ultimo) contiene un multiplo di unit indici, cosi' i confini dei blocchi
+        coincidono con quelli dei piani della matrice quando unit e' lo stride di piano.
+
+        @param n numero di indici
+        @param unit granularita' dei blocchi
+        @param f funzione chiamata (anche in parallelo) su ogni blocco
+    */
+    template <class F>
+    void parallelFor(std::size_t n, std::size_t unit, F f) {
+        if (n == 0)
+            return;
+        if (unit == 0)
+            unit = 1;
+        std::size_t units = (n + unit - 1) / unit;
+        // Alcuni blocchi per thread, per bilanciare il carico
+        std::size_t chunks = size() * 4 < units ? size() * 4 : units;
+        std::size_t per = (units + chunks - 1) / chunks * unit;
+        chunks = (n + per - 1) / per;
+        if (chunks == 1 || _threads.empty()) {
+            f(std::size_t(0), n);
+            return;
+        }
+        std::function<void(std::size_t)> job = [&](std::size_t c) {
+            std::size_t b = c * per;
+            f(b, b + per < n ? b + per : n);
+        };
+        run(job, chunks);
+    }
+
+    private:
+
+    void run(const std::function<void(std::size_t)> &job, std::size_t chunks) {
+        std::unique_lock<std::mutex> submit(_submit);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job = &job;
+            _chunks = chunks;
+            _next = 0;
+            _error = nullptr;
+            _busy = (unsigned int)_threads.size();
+            _generation++;
+        }
+        _wake.notify_all();
+        execute();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _busy == 0; });
+        _job = nullptr;
+        if (_error) {
+            std::exception_ptr e = _error;
+            _error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+    // Esegue blocchi finche' ce ne sono
+    void execute() {
+        std::size_t c;
+        while ((c = _next++) < _chunks) {
+            try {
+                (*_job)(c);
+            }
+            catch (...) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (!_error)
+                    _error = std::current_exception();
+            }
+        }
+    }
+
+    void worker() {
+        unsigned long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&] { return _stop || _generation != seen; });
+                if (_stop)
+                    return;
+                seen = _generation;
+            }
+            execute();
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (--_busy == 0)
+                _done.notify_one();
+        }
+    }
+};
+
+/**
+    @brief Politiche di esecuzione delle operazioni di massa della Matrice3D
+
+    - m3dSeq: esecuzione sequenziale nel thread chiamante.
+    - m3dPar(pool): esecuzione parallela sul pool, a blocchi di piani z.
+
+    Il risultato e' identico nei due casi: ogni blocco scrive una porzione
+    disgiunta del risultato con le stesse operazioni della versione sequenziale.
+*/
+struct m3dSeqPolicy {};
+
+struct m3dParPolicy {
+    Matrice3DThreadPool *pool; ///< pool su cui eseguire
+};
+
+static const m3dSeqPolicy m3dSeq = m3dSeqPolicy();
+
+inline m3dParPolicy m3dPar(Matrice3DThreadPool &pool) {
+    m3dParPolicy p;
+    p.pool = &pool;
+    return p;
+}
+
+/**
+    Esegue f(b, e) su [0, n) secondo la politica: sequenziale in un solo blocco,
+    parallela a blocchi multipli di unit.
+*/
+template <class F>
+void m3dForBlocks(const m3dSeqPolicy &, std::size_t n, std::size_t, F f) {
+    if (n > 0)
+        f(std::size_t(0), n);
+}
+
+template <class F>
+void m3dForBlocks(const m3dParPolicy &p, std::size_t n, std::size_t unit, F f) {
+    p.pool->parallelFor(n, unit, f);
+}
+
+#endif
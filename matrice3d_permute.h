@@ -0,0 +1,160 @@
+#ifndef MATRICE3D_PERMUTE_H
+#define MATRICE3D_PERMUTE_H
+
+#include <cstddef> // size_t, ptrdiff_t
+#include <algorithm> // copy, min, max
+#include "matrice3d.h" // Matrice3D, Matrice3DView, Matrice3DSimd, m3dForBlocks
+#include "matrice3d_reduce.h" // Matrice3DAxis
+
+/**
+    @brief Permutazione degli assi della Matrice3D
+
+    permute(A, a0, a1, a2) ritorna la matrice con gli assi riordinati: il piano del
+    risultato scorre l'asse a0 di A, la riga l'asse a1 e la colonna l'asse a2.
+    Es. permute(A, m3dAxisX, m3dAxisZ, m3dAxisY) ha dimensioni sizeX() x sizeZ() x sizeY()
+    e B(k, i, j) == A(i, j, k). transpose(A) inverte l'ordine degli assi (x, y, z).
+
+    Se la x resta l'ultimo asse il risultato si copia a righe intere. Altrimenti ogni
+    piano (o riga) del risultato e' la trasposta 2D di un piano di A: la trasposta viene
+    divisa ricorsivamente a meta' lungo il lato maggiore (cache-oblivious) fino a blocchi
+    di 32 x 32, trasposti a tile nei registri da Matrice3DSimd::transpose.
+    Con m3dPar(pool) strisce di righe indipendenti vengono copiate in parallelo.
+
+    permuted_view(A, a0, a1, a2) ritorna invece una Matrice3DView sugli stessi dati con
+    gli stride permutati: nessuna copia, conveniente quando si legge solo una piccola
+    parte degli elementi.
+
+*/
+static const std::size_t m3dTransposeLeaf = 32; ///< lato massimo dei blocchi trasposti direttamente
+static const std::size_t m3dTransposeStrip = 64; ///< righe di una striscia (unita' di lavoro parallela)
+
+/**
+    Controlla che (a0, a1, a2) sia una permutazione degli assi
+
+    @throw Matrice3DInvalidParameters se un asse manca o e' ripetuto
+*/
+inline void m3dCheckAxes(Matrice3DAxis a0, Matrice3DAxis a1, Matrice3DAxis a2) {
+    if (a0 == a1 || a0 == a2 || a1 == a2 || a0 < m3dAxisZ || a1 < m3dAxisZ || a2 < m3dAxisZ ||
+        a0 > m3dAxisX || a1 > m3dAxisX || a2 > m3dAxisX)
+        throw Matrice3DInvalidParameters("ERRORE: Gli assi non sono una permutazione di z, y, x");
+}
+
+/**
+    Trasposta 2D cache-oblivious: dst[i * ldd + j] = src[j * lds + i] per i < m, j < n.
+    Divide a meta' il lato maggiore (a multipli di 8, allineati alle tile SIMD).
+*/
+template <class T>
+void m3dTranspose(T *dst, std::size_t ldd, const T *src, std::size_t lds, std::size_t m, std::size_t n) {
+    if (m <= m3dTransposeLeaf && n <= m3dTransposeLeaf) {
+        Matrice3DSimd::transpose(dst, ldd, src, lds, m, n);
+        return;
+    }
+    if (m >= n) {
+        std::size_t h = (m / 2 + 7) & ~std::size_t(7);
+        m3dTranspose(dst, ldd, src, lds, h, n);
+        m3dTranspose(dst + h * ldd, ldd, src + h, lds, m - h, n);
+    } else {
+        std::size_t h = (n / 2 + 7) & ~std::size_t(7);
+        m3dTranspose(dst, ldd, src, lds, m, h);
+        m3dTranspose(dst + h, ldd, src + h * lds, lds, m, n - h);
+    }
+}
+
+/**
+    Copia in out (row-major, dimensioni d[0] x d[1] x d[2]) gli elementi di in che
+    hanno stride s[0], s[1], s[2] lungo gli assi del risultato. Uno degli stride vale 1.
+*/
+template <class T, class Policy>
+void m3dPermuteCopy(T *out, const T *in, const std::size_t d[3], const std::size_t s[3], const Policy &policy) {
+    // La colonna resta contigua: copia a righe
+    if (s[2] == 1) {
+        m3dForBlocks(policy, d[0] * d[1], 1, [&](std::size_t b, std::size_t e) {
+            for (std::size_t r = b; r < e; r++) {
+                const T *row = in + (r / d[1]) * s[0] + (r % d[1]) * s[1];
+                std::copy(row, row + d[2], out + r * d[2]);
+            }
+        });
+        return;
+    }
+    // L'asse contiguo di in e' p (piano o riga del risultato), q l'altro: per ogni
+    // indice lungo q trasposta 2D tra l'asse p e la colonna del risultato
+    std::size_t p = s[0] == 1 ? 0 : 1, q = 1 - p;
+    std::size_t os[2] = {d[1] * d[2], d[2]};
+    std::size_t m = d[p], strips = (m + m3dTransposeStrip - 1) / m3dTransposeStrip;
+    m3dForBlocks(policy, d[q] * strips, 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t c = b / strips; c * strips < e; c++) {
+            std::size_t u0 = std::max(b, c * strips) - c * strips, u1 = std::min(e, (c + 1) * strips) - c * strips;
+            std::size_t i0 = u0 * m3dTransposeStrip, i1 = std::min(u1 * m3dTransposeStrip, m);
+            m3dTranspose(out + c * os[q] + i0 * os[p], os[p], in + c * s[q] + i0, s[2], i1 - i0, d[2]);
+        }
+    });
+}
+
+/**
+    Metodo GLOBALE permute: Ritorna una nuova Matrice3D con gli assi riordinati, in cui
+    il piano scorre l'asse a0 di A, la riga l'asse a1 e la colonna l'asse a2.
+
+    @param A Matrice3D da permutare
+    @param a0, a1, a2 permutazione degli assi m3dAxisZ, m3dAxisY, m3dAxisX
+    @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+    @return Matrice3D con gli assi permutati
+
+    @throw Matrice3DInvalidParameters se gli assi non sono una permutazione
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout, class Policy = m3dSeqPolicy>
+Matrice3D<T, Cmp> permute(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis a0, Matrice3DAxis a1,
+                          Matrice3DAxis a2, const Policy &policy = m3dSeq) {
+    m3dCheckAxes(a0, a1, a2);
+    if constexpr (!Layout::contiguous)
+        return permute(Matrice3D<T, Cmp>(A), a0, a1, a2, policy);
+    if (A.size() == 0)
+        return Matrice3D<T, Cmp>();
+    const std::size_t size[3] = {A.sizeZ(), A.sizeY(), A.sizeX()};
+    const std::size_t stride[3] = {A.strideZ(), A.strideY(), 1};
+    const std::size_t d[3] = {size[a0], size[a1], size[a2]};
+    const std::size_t s[3] = {stride[a0], stride[a1], stride[a2]};
+    Matrice3D<T, Cmp> B((int)d[0], (int)d[1], (int)d[2]);
+    m3dPermuteCopy(B.data(), A.data(), d, s, policy);
+    return B;
+}
+
+/**
+    Metodo GLOBALE transpose: inverte l'ordine degli assi, B(x, y, z) == A(z, y, x).
+    Equivale a permute(A, m3dAxisX, m3dAxisY, m3dAxisZ, policy).
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout, class Policy = m3dSeqPolicy>
+Matrice3D<T, Cmp> transpose(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Policy &policy = m3dSeq) {
+    return permute(A, m3dAxisX, m3dAxisY, m3dAxisZ, policy);
+}
+
+/**
+    Metodo GLOBALE permuted_view: vista (senza copia) con gli assi riordinati come in
+    permute(). Le scritture sulla vista modificano la matrice di origine.
+
+    @param v vista (o Matrice3D row-major) da permutare
+    @param a0, a1, a2 permutazione degli assi
+
+    @return Matrice3DView con dimensioni e stride permutati
+
+    @throw Matrice3DInvalidParameters se gli assi non sono una permutazione
+*/
+template <class T, class Cmp>
+Matrice3DView<T, Cmp> permuted_view(const Matrice3DView<T, Cmp> &v, Matrice3DAxis a0, Matrice3DAxis a1, Matrice3DAxis a2) {
+    m3dCheckAxes(a0, a1, a2);
+    const unsigned int size[3] = {v.sizeZ(), v.sizeY(), v.sizeX()};
+    const std::ptrdiff_t stride[3] = {v.strideZ(), v.strideY(), v.strideX()};
+    return Matrice3DView<T, Cmp>(v.data(), size[a0], size[a1], size[a2], stride[a0], stride[a1], stride[a2]);
+}
+
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DView<T, Cmp> permuted_view(Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis a0, Matrice3DAxis a1, Matrice3DAxis a2) {
+    return permuted_view(A.view(), a0, a1, a2);
+}
+
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DView<const T, Cmp> permuted_view(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis a0, Matrice3DAxis a1, Matrice3DAxis a2) {
+    return permuted_view(A.view(), a0, a1, a2);
+}
+
+#endif
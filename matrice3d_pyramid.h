@@ -0,0 +1,300 @@
+#ifndef MATRICE3D_PYRAMID_H
+#define MATRICE3D_PYRAMID_H
+
+#include <cstddef> // size_t
+#include <algorithm> // min, max, copy
+#include <type_traits> // is_arithmetic, is_integral, is_signed, void_t
+#include <utility> // declval
+#include <vector> // livelli
+#include "matrice3d.h" // Matrice3D, defaultCmp, m3dForBlocks, m3dSumType
+
+/**
+    @brief Filtri di riduzione 2x2x2 della Matrice3DPyramid
+
+    - m3dFilterMean: media degli elementi (solo tipi aritmetici; per gli interi
+      arrotondata al piu' vicino, a parita' verso +infinito);
+    - m3dFilterMax: massimo secondo l'operatore < di T;
+    - m3dFilterMode: valore piu' frequente secondo il funtore Cmp, adatto alle etichette.
+      A parita' vince il primo nell'ordine di iterazione della finestra.
+*/
+enum Matrice3DFilter { m3dFilterMean, m3dFilterMax, m3dFilterMode };
+
+/// true se T ha l'operatore < (necessario per m3dFilterMax)
+template <class T, class = void> struct m3dLessComparable : std::false_type {};
+template <class T>
+struct m3dLessComparable<T, std::void_t<decltype(std::declval<const T &>() < std::declval<const T &>())> > : std::true_type {};
+
+/**
+    @brief Classe Matrice3DPyramid: piramide multi-risoluzione (mipmap) di una Matrice3D
+
+    Il livello 0 e' una copia del volume di partenza; il livello l+1 dimezza ogni
+    dimensione del livello l (arrotondando per eccesso) riducendo finestre di 2x2x2
+    elementi con il filtro scelto. I livelli proseguono fino alla matrice 1x1x1, o fino
+    al numero massimo indicato. Con una dimensione dispari la finestra dell'ultimo
+    elemento e' incompleta: gli elementi presenti vengono ripetuti lungo quell'asse,
+    cosi' media e moda non cambiano.
+
+    Ogni livello viene calcolato dal precedente a righe, leggendo quattro righe consecutive del
+    livello piu' fine per ogni riga prodotta; le righe si distribuiscono sul pool con la
+    politica m3dPar(pool). Costruire tutti i livelli legge in totale circa 8/7 del
+    volume di partenza. Il risultato non dipende dalla politica.
+
+    Accesso per livello di dettaglio: lod() e slice() ricevono coordinate del livello 0 e
+    leggono solo la matrice del livello richiesto; level_for() sceglie il livello piu'
+    fine entro un numero massimo di elementi. Dopo la modifica di un sotto-volume,
+    update() ricalcola solo la regione interessata di ogni livello.
+
+*/
+template <class T, class Cmp = defaultCmp>
+class Matrice3DPyramid
+{
+    public:
+
+    typedef Matrice3D<T, Cmp> level_type; ///< matrice di un livello
+    typedef T value_type; ///< tipo degli elementi
+
+    private:
+
+    std::vector<level_type> _levels; ///< livelli, dal piu' fine al piu' grossolano
+    Matrice3DFilter _filter; ///< filtro di riduzione
+    Cmp _cmp; ///< funtore di confronto (per la moda)
+
+    public:
+
+    /**
+        Costruttore di default: piramide vuota, senza livelli
+    */
+    Matrice3DPyramid() : _filter(m3dFilterMean) {}
+
+    /**
+        Costruttore: piramide del volume base
+
+        @param base volume di partenza (livello 0)
+        @param filter filtro di riduzione
+        @param maxLevels numero massimo di livelli, compreso il livello 0 (0: tutti)
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+        @throw Matrice3DInvalidParameters possibile eccezione di filtro non disponibile per T
+                                          (media senza tipo aritmetico, massimo senza operatore <)
+    */
+    template <class C, class Ch, class A, class L, class Policy = m3dSeqPolicy>
+    explicit Matrice3DPyramid(const Matrice3D<T, C, Ch, A, L> &base, Matrice3DFilter filter = m3dFilterMean,
+                              unsigned int maxLevels = 0, const Policy &policy = m3dSeq) : _filter(filter) {
+        if ((filter == m3dFilterMean && !std::is_arithmetic<T>::value) ||
+            (filter == m3dFilterMax && !m3dLessComparable<T>::value))
+            throw Matrice3DInvalidParameters("ERRORE: Filtro non disponibile per il tipo degli elementi");
+        _levels.push_back(level_type(base));
+        unsigned int z = base.sizeZ(), y = base.sizeY(), x = base.sizeX();
+        while (base.size() > 0 && (z > 1 || y > 1 || x > 1) && (maxLevels == 0 || _levels.size() < maxLevels)) {
+            z = (z + 1) / 2;
+            y = (y + 1) / 2;
+            x = (x + 1) / 2;
+            _levels.push_back(level_type((int)z, (int)y, (int)x));
+            const level_type &fine = _levels[_levels.size() - 2];
+            reduce(fine, _levels.back(), 0, z - 1, 0, y - 1, 0, x - 1, policy);
+        }
+    }
+
+    unsigned int levels() const { return (unsigned int)_levels.size(); } ///< numero di livelli
+    Matrice3DFilter filter() const { return _filter; } ///< filtro di riduzione
+
+    /**
+        @return matrice del livello l (0 e' il volume di partenza)
+
+        @throw Matrice3DOutOfRange possibile eccezione di livello non valido
+    */
+    const level_type &level(unsigned int l) const {
+        if (l >= _levels.size())
+            throw Matrice3DOutOfRange("ERRORE: Livello della piramide non valido");
+        return _levels[l];
+    }
+
+    /**
+        @return volume di partenza (livello 0)
+    */
+    const level_type &base() const { return level(0); }
+
+    /**
+        Livello di dettaglio: valore del livello l nel punto (z, y, x) del livello 0
+
+        @throw Matrice3DOutOfRange possibile eccezione di livello o coordinate non validi
+    */
+    const T &lod(unsigned int l, int z, int y, int x) const {
+        const level_type &m = level(l);
+        if (z < 0 || y < 0 || x < 0)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate non valide");
+        return m(z >> l, y >> l, x >> l);
+    }
+
+    /**
+        Metodo slice: sotto-matrice del livello l che copre gli intervalli z1..z2, y1..y2,
+        x1..x2 del livello 0 (ogni estremo diviso per 2^l). Legge solo il livello l.
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di livello o intervallo non validi
+    */
+    level_type slice(unsigned int l, int z1, int z2, int y1, int y2, int x1, int x2) const {
+        const level_type &m = level(l);
+        if (z1 < 0 || y1 < 0 || x1 < 0)
+            throw Matrice3DOutOfRange("ERRORE: Intervallo fuori range");
+        return m.slice(z1 >> l, z2 >> l, y1 >> l, y2 >> l, x1 >> l, x2 >> l);
+    }
+
+    /**
+        @return il livello piu' fine con al massimo maxElements elementi (il piu'
+                grossolano se nessuno e' abbastanza piccolo)
+    */
+    unsigned int level_for(std::size_t maxElements) const {
+        for (unsigned int l = 0; l < _levels.size(); l++)
+            if (_levels[l].size() <= maxElements)
+                return l;
+        return _levels.empty() ? 0 : levels() - 1;
+    }
+
+    /**
+        Metodo update: copia il sotto-volume sub nel livello 0 a partire da (z, y, x) e
+        ricalcola solo gli elementi dei livelli successivi che dipendono dalla regione.
+
+        @param sub sotto-volume da scrivere
+        @param z, y, x coordinate del primo elemento di sub nel livello 0
+        @param policy politica di esecuzione (m3dSeq o m3dPar(pool))
+
+        @throw Matrice3DOutOfRange possibile eccezione di sotto-volume fuori dal livello 0
+    */
+    template <class C, class Ch, class A, class L, class Policy = m3dSeqPolicy>
+    void update(const Matrice3D<T, C, Ch, A, L> &sub, int z, int y, int x, const Policy &policy = m3dSeq) {
+        if (_levels.empty() || z < 0 || y < 0 || x < 0 ||
+            std::size_t(z) + sub.sizeZ() > _levels[0].sizeZ() || std::size_t(y) + sub.sizeY() > _levels[0].sizeY() ||
+            std::size_t(x) + sub.sizeX() > _levels[0].sizeX())
+            throw Matrice3DOutOfRange("ERRORE: Sotto-volume fuori dalla piramide");
+        if (sub.size() == 0)
+            return;
+        level_type &b = _levels[0];
+        for (unsigned int k = 0; k < sub.sizeZ(); k++)
+            for (unsigned int j = 0; j < sub.sizeY(); j++)
+                for (unsigned int i = 0; i < sub.sizeX(); i++)
+                    b.at_unchecked(z + k, y + j, x + i) = sub.at_unchecked(k, j, i);
+        unsigned int z1 = z, z2 = z + sub.sizeZ() - 1, y1 = y, y2 = y + sub.sizeY() - 1, x1 = x, x2 = x + sub.sizeX() - 1;
+        for (std::size_t l = 1; l < _levels.size(); l++) {
+            z1 /= 2; z2 /= 2;
+            y1 /= 2; y2 /= 2;
+            x1 /= 2; x2 /= 2;
+            reduce(_levels[l - 1], _levels[l], z1, z2, y1, y2, x1, x2, policy);
+        }
+    }
+
+    /**
+        Operator ==: stesse dimensioni e stessi valori in tutti i livelli
+    */
+    bool operator==(const Matrice3DPyramid &other) const {
+        if (_levels.size() != other._levels.size())
+            return false;
+        for (std::size_t l = 0; l < _levels.size(); l++)
+            if (!(_levels[l] == other._levels[l]))
+                return false;
+        return true;
+    }
+
+    private:
+
+    /**
+        Media di 8 valori: per gli interi somma in un tipo piu' largo, arrotondata
+    */
+    static T mean8(const T *w) {
+        if constexpr (std::is_integral<T>::value) {
+            typename m3dSumType<T>::type s = 4;
+            for (int k = 0; k < 8; k++)
+                s += w[k];
+            // Divisione per 8 arrotondata verso -infinito anche per i negativi
+            if constexpr (std::is_signed<T>::value)
+                return T(s >= 0 ? s / 8 : -((-s + 7) / 8));
+            else
+                return T(s / 8);
+        }
+        else if constexpr (std::is_arithmetic<T>::value)
+            return T((((w[0] + w[1]) + (w[2] + w[3])) + ((w[4] + w[5]) + (w[6] + w[7]))) / 8);
+        else
+            return w[0];
+    }
+
+    static T max8(const T *w) {
+        if constexpr (m3dLessComparable<T>::value) {
+            T m = w[0];
+            for (int k = 1; k < 8; k++)
+                if (m < w[k])
+                    m = w[k];
+            return m;
+        }
+        else
+            return w[0];
+    }
+
+    T mode8(const T *w) const {
+        int best = 0, bestCount = 0;
+        // Il valore in posizione k compare al piu' 8 - k volte da k in poi
+        for (int k = 0; k < 8 && bestCount < 8 - k; k++) {
+            bool seen = false;
+            for (int j = 0; j < k && !seen; j++)
+                seen = _cmp(w[j], w[k]);
+            if (seen)
+                continue;
+            int count = 1;
+            for (int j = k + 1; j < 8; j++)
+                count += _cmp(w[j], w[k]);
+            if (count > bestCount) {
+                best = k;
+                bestCount = count;
+            }
+        }
+        return w[best];
+    }
+
+    /**
+        Ricalcola gli elementi z1..z2, y1..y2, x1..x2 di coarse a partire da fine con il
+        filtro della piramide
+    */
+    template <class Policy>
+    void reduce(const level_type &fine, level_type &coarse, unsigned int z1, unsigned int z2, unsigned int y1,
+                unsigned int y2, unsigned int x1, unsigned int x2, const Policy &policy) const {
+        if (_filter == m3dFilterMean)
+            reduce_rows(fine, coarse, z1, z2, y1, y2, x1, x2, policy, [](const T *w) { return mean8(w); });
+        else if (_filter == m3dFilterMax)
+            reduce_rows(fine, coarse, z1, z2, y1, y2, x1, x2, policy, [](const T *w) { return max8(w); });
+        else
+            reduce_rows(fine, coarse, z1, z2, y1, y2, x1, x2, policy, [this](const T *w) { return mode8(w); });
+    }
+
+    /**
+        Riduzione con f(w), w finestra di 8 elementi. Le righe della regione sono
+        indipendenti e vengono divise secondo la politica.
+    */
+    template <class Policy, class F>
+    static void reduce_rows(const level_type &fine, level_type &coarse, unsigned int z1, unsigned int z2, unsigned int y1,
+                            unsigned int y2, unsigned int x1, unsigned int x2, const Policy &policy, F f) {
+        const T *in = fine.data();
+        T *out = coarse.data();
+        std::size_t fz = fine.strideZ(), fy = fine.strideY(), cz = coarse.strideZ(), cy = coarse.strideY();
+        unsigned int Z = fine.sizeZ(), Y = fine.sizeY(), X = fine.sizeX(), rows = y2 - y1 + 1;
+        m3dForBlocks(policy, std::size_t(z2 - z1 + 1) * rows, 1, [&](std::size_t b, std::size_t e) {
+            T w[8];
+            for (std::size_t r = b; r < e; r++) {
+                unsigned int z = z1 + (unsigned int)(r / rows), y = y1 + (unsigned int)(r % rows);
+                // Righe della finestra, ripetute sul bordo con dimensione dispari
+                std::size_t za = std::size_t(2 * z), zb = std::min(2 * z + 1, Z - 1);
+                std::size_t ya = std::size_t(2 * y), yb = std::min(2 * y + 1, Y - 1);
+                const T *row[4] = {in + za * fz + ya * fy, in + za * fz + yb * fy, in + zb * fz + ya * fy, in + zb * fz + yb * fy};
+                T *o = out + z * cz + y * cy;
+                for (unsigned int x = x1; x <= x2; x++) {
+                    std::size_t xa = std::size_t(2 * x), xb = std::min(2 * x + 1, X - 1);
+                    for (int k = 0; k < 4; k++) {
+                        w[2 * k] = row[k][xa];
+                        w[2 * k + 1] = row[k][xb];
+                    }
+                    o[x] = f(w);
+                }
+            }
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef MATRICE3D_REDUCE_H
+#define MATRICE3D_REDUCE_H
+
+#include <cstddef> // size_t
+#include <algorithm> // copy, min
+#include <type_traits> // conditional, is_integral
+#include <vector> // risultati parziali
+#include "matrice3d.h" // Matrice3D, Matrice3DSimd, m3dForBlocks
+
+/**
+    @brief Riduzioni della Matrice3D: somma, media, minimo, massimo, argmin, argmax
+
+    Ogni riduzione esiste in due forme:
+    - sull'intera matrice, con risultato scalare (o le coordinate per argmin/argmax);
+    - lungo un asse (m3dAxisZ, m3dAxisY, m3dAxisX), con risultato una Matrice3D che ha
+      dimensione 1 lungo quell'asse. Es. la proiezione di massima intensita' lungo z:
+      maximum(A, m3dAxisZ) ha dimensioni 1 x sizeY() x sizeX().
+
+    Lungo x (righe contigue) ogni riga viene ridotta con i kernel di Matrice3DSimd; lungo
+    y e z si combinano righe intere elemento per elemento, a blocchi di colonne che
+    restano in cache. Tutte le forme accettano una politica di esecuzione (m3dSeq o
+    m3dPar(pool)); il risultato non dipende dalla politica ne' dal numero di thread.
+
+    Le somme di float e double sono a coppie (pairwise): blocchi brevi sommati in modo
+    vettoriale e poi combinati ad albero, con un errore che cresce come log(n) invece che
+    come n. Gli interi vengono sommati in long long (unsigned long long se senza segno).
+    A parita' di valore argmin e argmax ritornano il primo elemento nell'ordine di
+    iterazione. Con dei NaN minimo, massimo e argmin/argmax non sono specificati.
+
+    Le matrici con layout non contiguo vengono prima copiate in row-major.
+
+*/
+enum Matrice3DAxis { m3dAxisZ, m3dAxisY, m3dAxisX };
+
+/**
+    @brief Coordinate di un elemento (risultato di argmin e argmax)
+*/
+struct Matrice3DIndex {
+    unsigned int z; ///< piano
+    unsigned int y; ///< riga
+    unsigned int x; ///< colonna
+
+    bool operator==(const Matrice3DIndex &o) const { return z == o.z && y == o.y && x == o.x; }
+};
+
+/// Tipo della somma degli elementi di tipo T
+template <class T> struct m3dSumType {
+    typedef typename std::conditional<std::is_integral<T>::value,
+            typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type, T>::type type;
+};
+
+/// Tipo della media degli elementi di tipo T
+template <class T> struct m3dMeanType {
+    typedef typename std::conditional<std::is_integral<T>::value, double, T>::type type;
+};
+
+static const std::size_t m3dReduceLeaf = std::size_t(1) << 16; ///< elementi per risultato parziale
+static const std::size_t m3dReduceColumns = 2048; ///< colonne combinate insieme lungo y e z
+static const std::size_t m3dPairwiseBlock = 256; ///< blocco sommato direttamente
+
+/**
+    Somma a coppie degli n elementi di a, accumulata nel tipo S
+*/
+template <class S, class T>
+S m3dPairwiseSum(const T *a, std::size_t n) {
+    if (n <= m3dPairwiseBlock) {
+        if constexpr (std::is_same<S, T>::value)
+            return Matrice3DSimd::sum(a, n);
+        S s = S();
+        for (std::size_t i = 0; i < n; i++)
+            s += S(a[i]);
+        return s;
+    }
+    std::size_t h = n / 2;
+    return m3dPairwiseSum<S>(a, h) + m3dPairwiseSum<S>(a + h, n - h);
+}
+
+/**
+    Posizione del primo minimo (Max == false) o massimo (Max == true) degli n elementi di a
+*/
+template <bool Max, class T>
+std::size_t m3dArgExtreme(const T *a, std::size_t n) {
+    T m = Max ? Matrice3DSimd::maximum(a, n) : Matrice3DSimd::minimum(a, n);
+    for (std::size_t i = 0; i < n; i++)
+        if (a[i] == m)
+            return i;
+    return 0;
+}
+
+/**
+    @brief Somma a coppie di count righe di n elementi (distanti stride) in out
+*/
+template <class S, class T> struct m3dSumColumns {
+    void operator()(S *out, const T *in, std::size_t stride, std::size_t count, std::size_t n) const {
+        // Un livello di ricorsione per ogni dimezzamento: serve una riga di appoggio per livello
+        std::size_t levels = 1;
+        for (std::size_t c = count; c > 8; c -= c / 2)
+            levels++;
+        std::vector<S> scratch(levels * n);
+        rows(out, in, stride, count, n, scratch.data());
+    }
+
+    static void rows(S *out, const T *in, std::size_t stride, std::size_t count, std::size_t n, S *scratch) {
+        if (count > 8) {
+            std::size_t h = count / 2;
+            rows(out, in, stride, h, n, scratch + n);
+            rows(scratch, in + h * stride, stride, count - h, n, scratch + n);
+            accumulate(out, scratch, n);
+            return;
+        }
+        for (std::size_t i = 0; i < n; i++)
+            out[i] = S(in[i]);
+        for (std::size_t r = 1; r < count; r++)
+            accumulate(out, in + r * stride, n);
+    }
+
+    template <class U>
+    static void accumulate(S *out, const U *in, std::size_t n) {
+        if constexpr (std::is_same<S, U>::value)
+            Matrice3DSimd::add(out, out, in, n);
+        else
+            for (std::size_t i = 0; i < n; i++)
+                out[i] += S(in[i]);
+    }
+};
+
+/**
+    @brief Minimo (Max == false) o massimo (Max == true) di count righe in out
+*/
+template <bool Max, class T> struct m3dExtremeColumns {
+    void operator()(T *out, const T *in, std::size_t stride, std::size_t count, std::size_t n) const {
+        std::copy(in, in + n, out);
+        for (std::size_t r = 1; r < count; r++) {
+            if (Max)
+                Matrice3DSimd::max(out, in + r * stride, out, n);
+            else
+                Matrice3DSimd::min(out, in + r * stride, out, n);
+        }
+    }
+};
+
+/**
+    @brief Indice della riga con il primo minimo o massimo di ogni colonna
+*/
+template <bool Max, class T> struct m3dArgColumns {
+    void operator()(unsigned int *out, const T *in, std::size_t stride, std::size_t count, std::size_t n) const {
+        std::vector<T> best(in, in + n);
+        std::fill(out, out + n, 0u);
+        for (std::size_t r = 1; r < count; r++) {
+            const T *row = in + r * stride;
+            for (std::size_t i = 0; i < n; i++)
+                if (Max ? best[i] < row[i] : row[i] < best[i]) {
+                    best[i] = row[i];
+                    out[i] = (unsigned int)r;
+                }
+        }
+    }
+};
+
+/**
+    Riduzione lungo un asse: columns combina righe lungo y e z, row riduce una riga
+    lungo x. Il risultato ha dimensione 1 lungo l'asse.
+*/
+template <class R, class T, class Cmp, class Check, class Alloc, class Layout, class Policy, class Columns, class Row>
+Matrice3D<R> m3dReduceAxis(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const Policy &policy,
+                           Columns columns, Row row) {
+    if constexpr (!Layout::contiguous)
+        return m3dReduceAxis<R>(Matrice3D<T, Cmp>(A), axis, policy, columns, row);
+    if (A.size() == 0)
+        return Matrice3D<R>();
+    std::size_t Z = A.sizeZ(), Y = A.sizeY(), X = A.sizeX(), sz = A.strideZ(), sy = A.strideY();
+    const T *in = A.data();
+    if (axis == m3dAxisZ) {
+        Matrice3D<R> B(1, (int)Y, (int)X);
+        R *out = B.data();
+        // Colonne di un piano a blocchi: ogni blocco scorre tutti i piani
+        m3dForBlocks(policy, Y * X, m3dReduceColumns, [&](std::size_t b, std::size_t e) {
+            for (std::size_t c = b; c < e; c += m3dReduceColumns)
+                columns(out + c, in + c, sz, Z, std::min(m3dReduceColumns, e - c));
+        });
+        return B;
+    }
+    if (axis == m3dAxisY) {
+        Matrice3D<R> B((int)Z, 1, (int)X);
+        R *out = B.data();
+        m3dForBlocks(policy, Z * X, X, [&](std::size_t b, std::size_t e) {
+            for (std::size_t z = b / X; z < e / X; z++)
+                for (std::size_t c = 0; c < X; c += m3dReduceColumns)
+                    columns(out + z * X + c, in + z * sz + c, sy, Y, std::min(m3dReduceColumns, X - c));
+        });
+        return B;
+    }
+    Matrice3D<R> B((int)Z, (int)Y, 1);
+    R *out = B.data();
+    m3dForBlocks(policy, Z * Y, Y, [&](std::size_t b, std::size_t e) {
+        for (std::size_t r = b; r < e; r++)
+            out[r] = row(in + (r / Y) * sz + (r % Y) * sy, X);
+    });
+    return B;
+}
+
+/**
+    Risultati parziali leaf(a, n) su blocchi consecutivi di m3dReduceLeaf elementi. I
+    blocchi non dipendono dalla politica, quindi neanche il risultato finale.
+*/
+template <class R, class T, class Policy, class Leaf>
+std::vector<R> m3dReduceLeaves(const Policy &policy, const T *a, std::size_t n, Leaf leaf) {
+    std::vector<R> partial((n + m3dReduceLeaf - 1) / m3dReduceLeaf);
+    m3dForBlocks(policy, partial.size(), 1, [&](std::size_t b, std::size_t e) {
+        for (std::size_t l = b; l < e; l++)
+            partial[l] = leaf(a + l * m3dReduceLeaf, std::min(m3dReduceLeaf, n - l * m3dReduceLeaf));
+    });
+    return partial;
+}
+
+template <class T, class Cmp, class Check, class Alloc, class Layout, class Policy>
+typename m3dSumType<T>::type m3dSum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Policy &policy) {
+    typedef typename m3dSumType<T>::type S;
+    if constexpr (!Layout::contiguous)
+        return m3dSum(Matrice3D<T, Cmp>(A), policy);
+    std::vector<S> partial = m3dReduceLeaves<S>(policy, A.data(), A.size(), [](const T *a, std::size_t n) {
+        return m3dPairwiseSum<S>(a, n);
+    });
+    return m3dPairwiseSum<S>(partial.data(), partial.size());
+}
+
+template <bool Max, class T, class Cmp, class Check, class Alloc, class Layout, class Policy>
+T m3dExtreme(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Policy &policy) {
+    if constexpr (!Layout::contiguous)
+        return m3dExtreme<Max>(Matrice3D<T, Cmp>(A), policy);
+    if (A.size() == 0)
+        throw Matrice3DInvalidParameters("ERRORE: Riduzione di una matrice vuota");
+    std::vector<T> partial = m3dReduceLeaves<T>(policy, A.data(), A.size(), [](const T *a, std::size_t n) {
+        return Max ? Matrice3DSimd::maximum(a, n) : Matrice3DSimd::minimum(a, n);
+    });
+    return Max ? Matrice3DSimd::maximum(partial.data(), partial.size()) : Matrice3DSimd::minimum(partial.data(), partial.size());
+}
+
+template <bool Max, class T, class Cmp, class Check, class Alloc, class Layout, class Policy>
+Matrice3DIndex m3dArgExtreme(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Policy &policy) {
+    if constexpr (!Layout::contiguous)
+        return m3dArgExtreme<Max>(Matrice3D<T, Cmp>(A), policy);
+    if (A.size() == 0)
+        throw Matrice3DInvalidParameters("ERRORE: Riduzione di una matrice vuota");
+    const T *a = A.data();
+    std::vector<std::size_t> partial = m3dReduceLeaves<std::size_t>(policy, a, A.size(), [](const T *a, std::size_t n) {
+        return m3dArgExtreme<Max>(a, n);
+    });
+    // A parita' vince il blocco precedente
+    std::size_t best = partial[0];
+    for (std::size_t l = 1; l < partial.size(); l++) {
+        std::size_t i = l * m3dReduceLeaf + partial[l];
+        if (Max ? a[best] < a[i] : a[i] < a[best])
+            best = i;
+    }
+    Matrice3DIndex r;
+    r.z = (unsigned int)(best / A.strideZ());
+    r.y = (unsigned int)(best % A.strideZ() / A.strideY());
+    r.x = (unsigned int)(best % A.strideY());
+    return r;
+}
+
+template <class T, class Cmp, class Check, class Alloc, class Layout, class Policy>
+Matrice3D<typename m3dMeanType<T>::type> m3dMeanAxis(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const Policy &policy) {
+    typedef typename m3dSumType<T>::type S;
+    typedef typename m3dMeanType<T>::type M;
+    Matrice3D<M> r(m3dReduceAxis<S>(A, axis, policy, m3dSumColumns<S, T>(), [](const T *a, std::size_t n) {
+        return m3dPairwiseSum<S>(a, n);
+    }));
+    M count = M(axis == m3dAxisZ ? A.sizeZ() : (axis == m3dAxisY ? A.sizeY() : A.sizeX()));
+    for (std::size_t i = 0; i < r.size(); i++)
+        r.data()[i] /= count;
+    return r;
+}
+
+/**
+    Metodo GLOBALE sum: somma di tutti gli elementi di A (a coppie per float e double)
+
+    @return somma, di tipo m3dSumType<T>::type (T() se A e' vuota)
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+typename m3dSumType<T>::type sum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dSum(A, policy);
+}
+
+/**
+    Metodo GLOBALE sum con politica di esecuzione parallela: stesso risultato di sum(A)
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+typename m3dSumType<T>::type sum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    return m3dSum(A, policy);
+}
+
+/**
+    Metodo GLOBALE mean: media di tutti gli elementi di A
+
+    @throw Matrice3DInvalidParameters se A e' vuota
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+typename m3dMeanType<T>::type mean(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    if (A.size() == 0)
+        throw Matrice3DInvalidParameters("ERRORE: Riduzione di una matrice vuota");
+    typedef typename m3dMeanType<T>::type M;
+    return M(m3dSum(A, policy)) / M(A.size());
+}
+
+/**
+    Metodo GLOBALE mean con politica di esecuzione parallela: stesso risultato di mean(A)
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+typename m3dMeanType<T>::type mean(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    if (A.size() == 0)
+        throw Matrice3DInvalidParameters("ERRORE: Riduzione di una matrice vuota");
+    typedef typename m3dMeanType<T>::type M;
+    return M(m3dSum(A, policy)) / M(A.size());
+}
+
+/**
+    Metodo GLOBALE minimum: minimo degli elementi di A
+
+    @throw Matrice3DInvalidParameters se A e' vuota
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+T minimum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dExtreme<false>(A, policy);
+}
+
+/**
+    Metodo GLOBALE minimum con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+T minimum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    return m3dExtreme<false>(A, policy);
+}
+
+/**
+    Metodo GLOBALE maximum: massimo degli elementi di A
+
+    @throw Matrice3DInvalidParameters se A e' vuota
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+T maximum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dExtreme<true>(A, policy);
+}
+
+/**
+    Metodo GLOBALE maximum con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+T maximum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    return m3dExtreme<true>(A, policy);
+}
+
+/**
+    Metodo GLOBALE argmin: coordinate del primo minimo di A nell'ordine di iterazione
+
+    @throw Matrice3DInvalidParameters se A e' vuota
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DIndex argmin(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dArgExtreme<false>(A, policy);
+}
+
+/**
+    Metodo GLOBALE argmin con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DIndex argmin(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    return m3dArgExtreme<false>(A, policy);
+}
+
+/**
+    Metodo GLOBALE argmax: coordinate del primo massimo di A nell'ordine di iterazione
+
+    @throw Matrice3DInvalidParameters se A e' vuota
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DIndex argmax(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dArgExtreme<true>(A, policy);
+}
+
+/**
+    Metodo GLOBALE argmax con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3DIndex argmax(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const m3dParPolicy &policy) {
+    return m3dArgExtreme<true>(A, policy);
+}
+
+/**
+    Metodo GLOBALE sum lungo un asse: B(0,y,x) = somma su z di A(z,y,x) per m3dAxisZ ecc.
+
+    @return Matrice3D delle somme, con dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<typename m3dSumType<T>::type> sum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis,
+                                            const m3dSeqPolicy &policy = m3dSeq) {
+    typedef typename m3dSumType<T>::type S;
+    return m3dReduceAxis<S>(A, axis, policy, m3dSumColumns<S, T>(), [](const T *a, std::size_t n) { return m3dPairwiseSum<S>(a, n); });
+}
+
+/**
+    Metodo GLOBALE sum lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<typename m3dSumType<T>::type> sum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis,
+                                            const m3dParPolicy &policy) {
+    typedef typename m3dSumType<T>::type S;
+    return m3dReduceAxis<S>(A, axis, policy, m3dSumColumns<S, T>(), [](const T *a, std::size_t n) { return m3dPairwiseSum<S>(a, n); });
+}
+
+/**
+    Metodo GLOBALE mean lungo un asse
+
+    @return Matrice3D delle medie, con dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<typename m3dMeanType<T>::type> mean(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis,
+                                              const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dMeanAxis(A, axis, policy);
+}
+
+/**
+    Metodo GLOBALE mean lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<typename m3dMeanType<T>::type> mean(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis,
+                                              const m3dParPolicy &policy) {
+    return m3dMeanAxis(A, axis, policy);
+}
+
+/**
+    Metodo GLOBALE minimum lungo un asse
+
+    @return Matrice3D dei minimi, con dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T> minimum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dReduceAxis<T>(A, axis, policy, m3dExtremeColumns<false, T>(), [](const T *a, std::size_t n) { return Matrice3DSimd::minimum(a, n); });
+}
+
+/**
+    Metodo GLOBALE minimum lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T> minimum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dParPolicy &policy) {
+    return m3dReduceAxis<T>(A, axis, policy, m3dExtremeColumns<false, T>(), [](const T *a, std::size_t n) { return Matrice3DSimd::minimum(a, n); });
+}
+
+/**
+    Metodo GLOBALE maximum lungo un asse (es. proiezione di massima intensita')
+
+    @return Matrice3D dei massimi, con dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T> maximum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dReduceAxis<T>(A, axis, policy, m3dExtremeColumns<true, T>(), [](const T *a, std::size_t n) { return Matrice3DSimd::maximum(a, n); });
+}
+
+/**
+    Metodo GLOBALE maximum lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T> maximum(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dParPolicy &policy) {
+    return m3dReduceAxis<T>(A, axis, policy, m3dExtremeColumns<true, T>(), [](const T *a, std::size_t n) { return Matrice3DSimd::maximum(a, n); });
+}
+
+/**
+    Metodo GLOBALE argmin lungo un asse
+
+    @return Matrice3D con la coordinata lungo axis del primo minimo, dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<unsigned int> argmin(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dReduceAxis<unsigned int>(A, axis, policy, m3dArgColumns<false, T>(), [](const T *a, std::size_t n) { return (unsigned int)m3dArgExtreme<false>(a, n); });
+}
+
+/**
+    Metodo GLOBALE argmin lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<unsigned int> argmin(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dParPolicy &policy) {
+    return m3dReduceAxis<unsigned int>(A, axis, policy, m3dArgColumns<false, T>(), [](const T *a, std::size_t n) { return (unsigned int)m3dArgExtreme<false>(a, n); });
+}
+
+/**
+    Metodo GLOBALE argmax lungo un asse
+
+    @return Matrice3D con la coordinata lungo axis del primo massimo, dimensione 1 lungo axis
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<unsigned int> argmax(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dSeqPolicy &policy = m3dSeq) {
+    return m3dReduceAxis<unsigned int>(A, axis, policy, m3dArgColumns<true, T>(), [](const T *a, std::size_t n) { return (unsigned int)m3dArgExtreme<true>(a, n); });
+}
+
+/**
+    Metodo GLOBALE argmax lungo un asse con politica di esecuzione parallela
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<unsigned int> argmax(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, Matrice3DAxis axis, const m3dParPolicy &policy) {
+    return m3dReduceAxis<unsigned int>(A, axis, policy, m3dArgColumns<true, T>(), [](const T *a, std::size_t n) { return (unsigned int)m3dArgExtreme<true>(a, n); });
+}
+
+#endif
@@ -0,0 +1,832 @@
+#ifndef MATRICE3D_SIMD_H
+#define MATRICE3D_SIMD_H
+
+#include <cstddef> // size_t
+#include <cstdint> // int32_t, int16_t, uint8_t
+#include <cstring> // memcmp
+#include <cmath> // fma
+#include <type_traits> // is_same, if constexpr
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRICE3D_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define MATRICE3D_SIMD_X86 0
+#endif
+
+/**
+    @brief Classe Matrice3DSimd: kernel vettoriali sui buffer della Matrice3D
+
+    Raccoglie le operazioni element-wise usate dalla Matrice3D sui tipi aritmetici
+    (conversione di tipo, confronto di uguaglianza, somma, prodotto, fma, clamp,
+    minimo e massimo), le riduzioni di un buffer (somma, minimo e massimo) e la
+    trasposizione di blocchi 2D.
+    Ogni kernel ha una versione SSE2, AVX2 (con FMA) e AVX-512, compilate con gli
+    attributi target di GCC/Clang nello stesso eseguibile: la versione da usare viene
+    scelta a runtime interrogando la CPU (CPUID) alla prima chiamata. Sulle altre
+    architetture, o per tipi non supportati, viene usato un ciclo scalare equivalente.
+
+    I tipi vettorizzati sono float, double e int32_t; la conversione copre inoltre
+    uint8_t e int16_t verso float e il confronto tutti i tipi interi.
+    I risultati sono identici in tutte le versioni: le conversioni rispettano lo
+    static_cast, il confronto l'operatore == (NaN diverso da tutto, -0 == +0), fma
+    esegue un solo arrotondamento anche nel percorso scalare (std::fma). Fa eccezione
+    sum() su float e double, che somma in un ordine diverso a seconda della larghezza
+    dei vettori.
+
+*/
+class Matrice3DSimd {
+    public:
+
+    /// Insiemi di istruzioni disponibili, in ordine crescente
+    enum Level { scalar = 0, sse2 = 1, avx2 = 2, avx512 = 3 };
+
+    /**
+        Rileva l'insieme di istruzioni migliore supportato dalla CPU
+
+        @return livello rilevato
+    */
+    static Level detected() {
+#if MATRICE3D_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return avx2;
+        return sse2;
+#else
+        return scalar;
+#endif
+    }
+
+    /**
+        @return livello usato attualmente dai kernel
+    */
+    static Level level() { return current(); }
+
+    /**
+        Forza il livello usato dai kernel (utile per test e benchmark).
+        Un livello non supportato dalla CPU viene ridotto a quello rilevato.
+
+        @param l livello richiesto
+    */
+    static void setLevel(Level l) {
+        Level d = detected();
+        current() = l < d ? l : d;
+    }
+
+    /**
+        @return nome leggibile del livello l
+    */
+    static const char *name(Level l) {
+        static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+        return names[l];
+    }
+
+    /**
+        Conversione di tipo: dst[i] = static_cast<T>(src[i]) per i < n
+    */
+    template <class T, class U>
+    static void convert(T *dst, const U *src, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (hasConvert<T, U>::value) {
+            switch (level()) {
+                case avx512: convert_avx512(dst, src, n); return;
+                case avx2: convert_avx2(dst, src, n); return;
+                case sse2: convert_sse2(dst, src, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = static_cast<T>(src[i]);
+    }
+
+    /**
+        Confronto di uguaglianza con l'operatore == di T
+
+        @return true se a[i] == b[i] per ogni i < n
+    */
+    template <class T>
+    static bool equal(const T *a, const T *b, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (std::is_integral<T>::value) {
+            // Per gli interi l'uguaglianza coincide con quella dei byte
+            return equal_bytes(reinterpret_cast<const unsigned char *>(a),
+                               reinterpret_cast<const unsigned char *>(b), n * sizeof(T));
+        }
+        else if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: return equal_avx512(a, b, n);
+                case avx2: return equal_avx2(a, b, n);
+                case sse2: return equal_sse2(a, b, n);
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            if (!(a[i] == b[i]))
+                return false;
+        return true;
+    }
+
+    /**
+        Somma: dst[i] = a[i] + b[i] per i < n
+    */
+    template <class T>
+    static void add(T *dst, const T *a, const T *b, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: add_avx512(dst, a, b, n); return;
+                case avx2: add_avx2(dst, a, b, n); return;
+                case sse2: add_sse2(dst, a, b, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = a[i] + b[i];
+    }
+
+    /**
+        Prodotto: dst[i] = a[i] * b[i] per i < n
+    */
+    template <class T>
+    static void mul(T *dst, const T *a, const T *b, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: mul_avx512(dst, a, b, n); return;
+                case avx2: mul_avx2(dst, a, b, n); return;
+                case sse2: mul_sse2(dst, a, b, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = a[i] * b[i];
+    }
+
+    /**
+        Fused multiply-add: dst[i] = a[i] * b[i] + c[i] con un solo arrotondamento
+    */
+    template <class T>
+    static void fma(T *dst, const T *a, const T *b, const T *c, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: fma_avx512(dst, a, b, c, n); return;
+                case avx2: fma_avx2(dst, a, b, c, n); return;
+                case sse2:
+                    // SSE2 non ha istruzioni fma: solo gli interi (esatti) sono vettoriali
+                    if constexpr (std::is_integral<T>::value) {
+                        fma_sse2(dst, a, b, c, n);
+                        return;
+                    }
+                    break;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = scalar_fma(a[i], b[i], c[i]);
+    }
+
+    /**
+        Clamp: dst[i] = src[i] limitato all'intervallo [lo, hi] per i < n
+    */
+    template <class T>
+    static void clamp(T *dst, const T *src, T lo, T hi, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: clamp_avx512(dst, src, lo, hi, n); return;
+                case avx2: clamp_avx2(dst, src, lo, hi, n); return;
+                case sse2: clamp_sse2(dst, src, lo, hi, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = scalar_clamp(src[i], lo, hi);
+    }
+
+    /**
+        Minimo elemento per elemento: dst[i] = a[i] < b[i] ? a[i] : b[i] per i < n
+    */
+    template <class T>
+    static void min(T *dst, const T *a, const T *b, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: min_avx512(dst, a, b, n); return;
+                case avx2: min_avx2(dst, a, b, n); return;
+                case sse2: min_sse2(dst, a, b, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = a[i] < b[i] ? a[i] : b[i];
+    }
+
+    /**
+        Massimo elemento per elemento: dst[i] = b[i] < a[i] ? a[i] : b[i] per i < n
+    */
+    template <class T>
+    static void max(T *dst, const T *a, const T *b, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: max_avx512(dst, a, b, n); return;
+                case avx2: max_avx2(dst, a, b, n); return;
+                case sse2: max_sse2(dst, a, b, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < n; i++)
+            dst[i] = b[i] < a[i] ? a[i] : b[i];
+    }
+
+    /**
+        Somma degli n elementi di a. float e double vengono sommati su piu' accumulatori
+        vettoriali: l'ordine delle somme, e quindi l'arrotondamento, dipende dal livello.
+    */
+    template <class T>
+    static T sum(const T *a, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (std::is_floating_point<T>::value && isVector<T>::value) {
+            switch (level()) {
+                case avx512: return sum_avx512(a, n);
+                case avx2: return sum_avx2(a, n);
+                case sse2: return sum_sse2(a, n);
+                default: break;
+            }
+        }
+#endif
+        T s = T();
+        for (std::size_t i = 0; i < n; i++)
+            s += a[i];
+        return s;
+    }
+
+    /**
+        Minimo degli n elementi di a (n > 0). Con dei NaN il risultato non e' specificato.
+    */
+    template <class T>
+    static T minimum(const T *a, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: return minimum_avx512(a, n);
+                case avx2: return minimum_avx2(a, n);
+                case sse2: return minimum_sse2(a, n);
+                default: break;
+            }
+        }
+#endif
+        T m = a[0];
+        for (std::size_t i = 1; i < n; i++)
+            m = a[i] < m ? a[i] : m;
+        return m;
+    }
+
+    /**
+        Massimo degli n elementi di a (n > 0). Con dei NaN il risultato non e' specificato.
+    */
+    template <class T>
+    static T maximum(const T *a, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (isVector<T>::value) {
+            switch (level()) {
+                case avx512: return maximum_avx512(a, n);
+                case avx2: return maximum_avx2(a, n);
+                case sse2: return maximum_sse2(a, n);
+                default: break;
+            }
+        }
+#endif
+        T m = a[0];
+        for (std::size_t i = 1; i < n; i++)
+            m = m < a[i] ? a[i] : m;
+        return m;
+    }
+
+    /**
+        Trasposizione di un blocco: dst[i * ldd + j] = src[j * lds + i] per i < m, j < n.
+        Gli elementi sono solo spostati, quindi va bene qualsiasi tipo banalmente
+        copiabile di 4 o 8 byte: il blocco viene diviso in tile quadrate trasposte nei
+        registri (4x4 e 2x2 con SSE2, 8x8 e 4x4 con AVX2, usate anche con AVX-512).
+    */
+    template <class T>
+    static void transpose(T *dst, std::size_t ldd, const T *src, std::size_t lds, std::size_t m, std::size_t n) {
+#if MATRICE3D_SIMD_X86
+        if constexpr (std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)) {
+            switch (level()) {
+                case avx512:
+                case avx2: transpose_avx2(dst, ldd, src, lds, m, n); return;
+                case sse2: transpose_sse2(dst, ldd, src, lds, m, n); return;
+                default: break;
+            }
+        }
+#endif
+        for (std::size_t i = 0; i < m; i++)
+            for (std::size_t j = 0; j < n; j++)
+                dst[i * ldd + j] = src[j * lds + i];
+    }
+
+    /// Tipi con kernel aritmetici vettoriali
+    template <class T> struct isVector {
+        static const bool value = std::is_same<T, float>::value || std::is_same<T, double>::value ||
+                                  std::is_same<T, std::int32_t>::value;
+    };
+
+    /// Coppie (destinazione, sorgente) con conversione vettoriale
+    template <class T, class U> struct hasConvert {
+        static const bool value =
+            (std::is_same<T, float>::value && std::is_same<U, std::int32_t>::value) ||
+            (std::is_same<T, std::int32_t>::value && std::is_same<U, float>::value) ||
+            (std::is_same<T, double>::value && std::is_same<U, float>::value) ||
+            (std::is_same<T, float>::value && std::is_same<U, double>::value) ||
+            (std::is_same<T, float>::value && std::is_same<U, std::uint8_t>::value) ||
+            (std::is_same<T, float>::value && std::is_same<U, std::int16_t>::value);
+    };
+
+    private:
+
+    static Level &current() {
+        static Level l = detected();
+        return l;
+    }
+
+    template <class T> static T scalar_fma(T a, T b, T c) { return a * b + c; }
+    static float scalar_fma(float a, float b, float c) { return std::fma(a, b, c); }
+    static double scalar_fma(double a, double b, double c) { return std::fma(a, b, c); }
+
+    // Stesso risultato di min(hi, max(lo, v)) con le istruzioni SSE/AVX (NaN compreso)
+    template <class T> static T scalar_clamp(T v, T lo, T hi) {
+        return v < lo ? lo : (hi < v ? hi : v);
+    }
+
+#if MATRICE3D_SIMD_X86
+
+#define M3D_TARGET_SSE2 __attribute__((target("sse2")))
+#define M3D_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define M3D_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+    // ---- SSE2 ----
+    struct sse2f {
+        typedef __m128 V; static const std::size_t W = 4;
+        M3D_TARGET_SSE2 static V load(const float *p) { return _mm_loadu_ps(p); }
+        M3D_TARGET_SSE2 static void store(float *p, V v) { _mm_storeu_ps(p, v); }
+        M3D_TARGET_SSE2 static V set1(float v) { return _mm_set1_ps(v); }
+        M3D_TARGET_SSE2 static V add(V a, V b) { return _mm_add_ps(a, b); }
+        M3D_TARGET_SSE2 static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        M3D_TARGET_SSE2 static V min(V a, V b) { return _mm_min_ps(a, b); }
+        M3D_TARGET_SSE2 static V max(V a, V b) { return _mm_max_ps(a, b); }
+        M3D_TARGET_SSE2 static bool eq(V a, V b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)) == 0xF; }
+    };
+    struct sse2d {
+        typedef __m128d V; static const std::size_t W = 2;
+        M3D_TARGET_SSE2 static V load(const double *p) { return _mm_loadu_pd(p); }
+        M3D_TARGET_SSE2 static void store(double *p, V v) { _mm_storeu_pd(p, v); }
+        M3D_TARGET_SSE2 static V set1(double v) { return _mm_set1_pd(v); }
+        M3D_TARGET_SSE2 static V add(V a, V b) { return _mm_add_pd(a, b); }
+        M3D_TARGET_SSE2 static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+        M3D_TARGET_SSE2 static V min(V a, V b) { return _mm_min_pd(a, b); }
+        M3D_TARGET_SSE2 static V max(V a, V b) { return _mm_max_pd(a, b); }
+        M3D_TARGET_SSE2 static bool eq(V a, V b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)) == 0x3; }
+    };
+    struct sse2i {
+        typedef __m128i V; static const std::size_t W = 4;
+        M3D_TARGET_SSE2 static V load(const std::int32_t *p) { return _mm_loadu_si128((const __m128i *)p); }
+        M3D_TARGET_SSE2 static void store(std::int32_t *p, V v) { _mm_storeu_si128((__m128i *)p, v); }
+        M3D_TARGET_SSE2 static V set1(std::int32_t v) { return _mm_set1_epi32(v); }
+        M3D_TARGET_SSE2 static V add(V a, V b) { return _mm_add_epi32(a, b); }
+        // SSE2 non ha mullo_epi32 ne' min/max_epi32 (SSE4.1): li emulo
+        M3D_TARGET_SSE2 static V mul(V a, V b) {
+            __m128i even = _mm_mul_epu32(a, b);
+            __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                      _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+        M3D_TARGET_SSE2 static V min(V a, V b) {
+            __m128i gt = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+        }
+        M3D_TARGET_SSE2 static V max(V a, V b) {
+            __m128i gt = _mm_cmpgt_epi32(a, b);
+            return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+        }
+        M3D_TARGET_SSE2 static bool eq(V a, V b) { return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) == 0xFFFF; }
+    };
+
+    // ---- AVX2 + FMA ----
+    struct avx2f {
+        typedef __m256 V; static const std::size_t W = 8;
+        M3D_TARGET_AVX2 static V load(const float *p) { return _mm256_loadu_ps(p); }
+        M3D_TARGET_AVX2 static void store(float *p, V v) { _mm256_storeu_ps(p, v); }
+        M3D_TARGET_AVX2 static V set1(float v) { return _mm256_set1_ps(v); }
+        M3D_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        M3D_TARGET_AVX2 static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        M3D_TARGET_AVX2 static V fma(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+        M3D_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        M3D_TARGET_AVX2 static V max(V a, V b) { return _mm256_max_ps(a, b); }
+        M3D_TARGET_AVX2 static bool eq(V a, V b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)) == 0xFF; }
+    };
+    struct avx2d {
+        typedef __m256d V; static const std::size_t W = 4;
+        M3D_TARGET_AVX2 static V load(const double *p) { return _mm256_loadu_pd(p); }
+        M3D_TARGET_AVX2 static void store(double *p, V v) { _mm256_storeu_pd(p, v); }
+        M3D_TARGET_AVX2 static V set1(double v) { return _mm256_set1_pd(v); }
+        M3D_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_pd(a, b); }
+        M3D_TARGET_AVX2 static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        M3D_TARGET_AVX2 static V fma(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+        M3D_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_pd(a, b); }
+        M3D_TARGET_AVX2 static V max(V a, V b) { return _mm256_max_pd(a, b); }
+        M3D_TARGET_AVX2 static bool eq(V a, V b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)) == 0xF; }
+    };
+    struct avx2i {
+        typedef __m256i V; static const std::size_t W = 8;
+        M3D_TARGET_AVX2 static V load(const std::int32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+        M3D_TARGET_AVX2 static void store(std::int32_t *p, V v) { _mm256_storeu_si256((__m256i *)p, v); }
+        M3D_TARGET_AVX2 static V set1(std::int32_t v) { return _mm256_set1_epi32(v); }
+        M3D_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+        M3D_TARGET_AVX2 static V mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+        M3D_TARGET_AVX2 static V fma(V a, V b, V c) { return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c); }
+        M3D_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_epi32(a, b); }
+        M3D_TARGET_AVX2 static V max(V a, V b) { return _mm256_max_epi32(a, b); }
+        M3D_TARGET_AVX2 static bool eq(V a, V b) { return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) == -1; }
+    };
+
+    // ---- AVX-512 ----
+    struct avx512f {
+        typedef __m512 V; static const std::size_t W = 16;
+        M3D_TARGET_AVX512 static V load(const float *p) { return _mm512_loadu_ps(p); }
+        M3D_TARGET_AVX512 static void store(float *p, V v) { _mm512_storeu_ps(p, v); }
+        M3D_TARGET_AVX512 static V set1(float v) { return _mm512_set1_ps(v); }
+        M3D_TARGET_AVX512 static V add(V a, V b) { return _mm512_add_ps(a, b); }
+        M3D_TARGET_AVX512 static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+        M3D_TARGET_AVX512 static V fma(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+        M3D_TARGET_AVX512 static V min(V a, V b) { return _mm512_min_ps(a, b); }
+        M3D_TARGET_AVX512 static V max(V a, V b) { return _mm512_max_ps(a, b); }
+        M3D_TARGET_AVX512 static bool eq(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ) == 0xFFFF; }
+    };
+    struct avx512d {
+        typedef __m512d V; static const std::size_t W = 8;
+        M3D_TARGET_AVX512 static V load(const double *p) { return _mm512_loadu_pd(p); }
+        M3D_TARGET_AVX512 static void store(double *p, V v) { _mm512_storeu_pd(p, v); }
+        M3D_TARGET_AVX512 static V set1(double v) { return _mm512_set1_pd(v); }
+        M3D_TARGET_AVX512 static V add(V a, V b) { return _mm512_add_pd(a, b); }
+        M3D_TARGET_AVX512 static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+        M3D_TARGET_AVX512 static V fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+        M3D_TARGET_AVX512 static V min(V a, V b) { return _mm512_min_pd(a, b); }
+        M3D_TARGET_AVX512 static V max(V a, V b) { return _mm512_max_pd(a, b); }
+        M3D_TARGET_AVX512 static bool eq(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ) == 0xFF; }
+    };
+    struct avx512i {
+        typedef __m512i V; static const std::size_t W = 16;
+        M3D_TARGET_AVX512 static V load(const std::int32_t *p) { return _mm512_loadu_si512((const void *)p); }
+        M3D_TARGET_AVX512 static void store(std::int32_t *p, V v) { _mm512_storeu_si512((void *)p, v); }
+        M3D_TARGET_AVX512 static V set1(std::int32_t v) { return _mm512_set1_epi32(v); }
+        M3D_TARGET_AVX512 static V add(V a, V b) { return _mm512_add_epi32(a, b); }
+        M3D_TARGET_AVX512 static V mul(V a, V b) { return _mm512_mullo_epi32(a, b); }
+        M3D_TARGET_AVX512 static V fma(V a, V b, V c) { return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c); }
+        M3D_TARGET_AVX512 static V min(V a, V b) { return _mm512_min_epi32(a, b); }
+        M3D_TARGET_AVX512 static V max(V a, V b) { return _mm512_max_epi32(a, b); }
+        M3D_TARGET_AVX512 static bool eq(V a, V b) { return _mm512_cmpeq_epi32_mask(a, b) == 0xFFFF; }
+    };
+
+    /// Seleziona la struct di operazioni per (insieme di istruzioni, tipo)
+    template <class O_f, class O_d, class O_i, class T> struct pick {
+        typedef typename std::conditional<std::is_same<T, float>::value, O_f,
+                typename std::conditional<std::is_same<T, double>::value, O_d, O_i>::type>::type type;
+    };
+
+    /**
+        Genera i kernel di un insieme di istruzioni: ciclo vettoriale sui blocchi da W
+        elementi seguito da un ciclo scalare sugli elementi rimanenti.
+    */
+#define M3D_SIMD_KERNELS(ISA, ATTR, OF, OD, OI)                                                  \
+    template <class T> ATTR static bool equal_##ISA(const T *a, const T *b, std::size_t n) {     \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            if (!O::eq(O::load(a + i), O::load(b + i)))                                          \
+                return false;                                                                    \
+        for (; i < n; i++)                                                                       \
+            if (!(a[i] == b[i]))                                                                 \
+                return false;                                                                    \
+        return true;                                                                             \
+    }                                                                                            \
+    template <class T> ATTR static void add_##ISA(T *d, const T *a, const T *b, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::add(O::load(a + i), O::load(b + i)));                             \
+        for (; i < n; i++)                                                                       \
+            d[i] = a[i] + b[i];                                                                  \
+    }                                                                                            \
+    template <class T> ATTR static void mul_##ISA(T *d, const T *a, const T *b, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::mul(O::load(a + i), O::load(b + i)));                             \
+        for (; i < n; i++)                                                                       \
+            d[i] = a[i] * b[i];                                                                  \
+    }                                                                                            \
+    template <class T> ATTR static void clamp_##ISA(T *d, const T *s, T lo, T hi, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        typename O::V vlo = O::set1(lo), vhi = O::set1(hi);                                      \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::min(vhi, O::max(vlo, O::load(s + i))));                           \
+        for (; i < n; i++)                                                                       \
+            d[i] = scalar_clamp(s[i], lo, hi);                                                   \
+    }
+
+    M3D_SIMD_KERNELS(sse2, M3D_TARGET_SSE2, sse2f, sse2d, sse2i)
+    M3D_SIMD_KERNELS(avx2, M3D_TARGET_AVX2, avx2f, avx2d, avx2i)
+    M3D_SIMD_KERNELS(avx512, M3D_TARGET_AVX512, avx512f, avx512d, avx512i)
+
+#undef M3D_SIMD_KERNELS
+
+    /**
+        Kernel di minimo/massimo elemento per elemento e di riduzione (somma, minimo e
+        massimo di un buffer): i vettori parziali vengono combinati alla fine.
+    */
+#define M3D_SIMD_REDUCE(ISA, ATTR, OF, OD, OI)                                                   \
+    template <class T> ATTR static void min_##ISA(T *d, const T *a, const T *b, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::min(O::load(a + i), O::load(b + i)));                             \
+        for (; i < n; i++)                                                                       \
+            d[i] = a[i] < b[i] ? a[i] : b[i];                                                    \
+    }                                                                                            \
+    template <class T> ATTR static void max_##ISA(T *d, const T *a, const T *b, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::max(O::load(a + i), O::load(b + i)));                             \
+        for (; i < n; i++)                                                                       \
+            d[i] = b[i] < a[i] ? a[i] : b[i];                                                    \
+    }                                                                                            \
+    template <class T> ATTR static T sum_##ISA(const T *a, std::size_t n) {                      \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        typename O::V s0 = O::set1(T()), s1 = s0, s2 = s0, s3 = s0;                              \
+        std::size_t i = 0;                                                                       \
+        for (; i + 4 * O::W <= n; i += 4 * O::W) {                                               \
+            s0 = O::add(s0, O::load(a + i));                                                     \
+            s1 = O::add(s1, O::load(a + i + O::W));                                              \
+            s2 = O::add(s2, O::load(a + i + 2 * O::W));                                          \
+            s3 = O::add(s3, O::load(a + i + 3 * O::W));                                          \
+        }                                                                                        \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            s0 = O::add(s0, O::load(a + i));                                                     \
+        T lanes[O::W];                                                                           \
+        O::store(lanes, O::add(O::add(s0, s1), O::add(s2, s3)));                                 \
+        T s = T();                                                                               \
+        for (std::size_t k = 0; k < O::W; k++)                                                   \
+            s += lanes[k];                                                                       \
+        for (; i < n; i++)                                                                       \
+            s += a[i];                                                                           \
+        return s;                                                                                \
+    }                                                                                            \
+    template <class T> ATTR static T minimum_##ISA(const T *a, std::size_t n) {                  \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        T m = a[0];                                                                              \
+        std::size_t i = 1;                                                                       \
+        if (n >= O::W) {                                                                         \
+            typename O::V v = O::load(a);                                                        \
+            for (i = O::W; i + O::W <= n; i += O::W)                                             \
+                v = O::min(O::load(a + i), v);                                                   \
+            T lanes[O::W];                                                                       \
+            O::store(lanes, v);                                                                  \
+            m = lanes[0];                                                                        \
+            for (std::size_t k = 1; k < O::W; k++)                                               \
+                m = lanes[k] < m ? lanes[k] : m;                                                 \
+        }                                                                                        \
+        for (; i < n; i++)                                                                       \
+            m = a[i] < m ? a[i] : m;                                                             \
+        return m;                                                                                \
+    }                                                                                            \
+    template <class T> ATTR static T maximum_##ISA(const T *a, std::size_t n) {                  \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        T m = a[0];                                                                              \
+        std::size_t i = 1;                                                                       \
+        if (n >= O::W) {                                                                         \
+            typename O::V v = O::load(a);                                                        \
+            for (i = O::W; i + O::W <= n; i += O::W)                                             \
+                v = O::max(O::load(a + i), v);                                                   \
+            T lanes[O::W];                                                                       \
+            O::store(lanes, v);                                                                  \
+            m = lanes[0];                                                                        \
+            for (std::size_t k = 1; k < O::W; k++)                                               \
+                m = m < lanes[k] ? lanes[k] : m;                                                 \
+        }                                                                                        \
+        for (; i < n; i++)                                                                       \
+            m = m < a[i] ? a[i] : m;                                                             \
+        return m;                                                                                \
+    }
+
+    M3D_SIMD_REDUCE(sse2, M3D_TARGET_SSE2, sse2f, sse2d, sse2i)
+    M3D_SIMD_REDUCE(avx2, M3D_TARGET_AVX2, avx2f, avx2d, avx2i)
+    M3D_SIMD_REDUCE(avx512, M3D_TARGET_AVX512, avx512f, avx512d, avx512i)
+
+#undef M3D_SIMD_REDUCE
+
+#define M3D_SIMD_FMA(ISA, ATTR, OF, OD, OI)                                                      \
+    template <class T> ATTR static void fma_##ISA(T *d, const T *a, const T *b, const T *c, std::size_t n) { \
+        typedef typename pick<OF, OD, OI, T>::type O;                                            \
+        std::size_t i = 0;                                                                       \
+        for (; i + O::W <= n; i += O::W)                                                         \
+            O::store(d + i, O::fma(O::load(a + i), O::load(b + i), O::load(c + i)));             \
+        for (; i < n; i++)                                                                       \
+            d[i] = scalar_fma(a[i], b[i], c[i]);                                                 \
+    }
+
+    M3D_SIMD_FMA(avx2, M3D_TARGET_AVX2, avx2f, avx2d, avx2i)
+    M3D_SIMD_FMA(avx512, M3D_TARGET_AVX512, avx512f, avx512d, avx512i)
+
+#undef M3D_SIMD_FMA
+
+    // fma su interi con SSE2: prodotto e somma sono esatti
+    M3D_TARGET_SSE2 static void fma_sse2(std::int32_t *d, const std::int32_t *a, const std::int32_t *b,
+                                         const std::int32_t *c, std::size_t n) {
+        std::size_t i = 0;
+        for (; i + sse2i::W <= n; i += sse2i::W)
+            sse2i::store(d + i, sse2i::add(sse2i::mul(sse2i::load(a + i), sse2i::load(b + i)), sse2i::load(c + i)));
+        for (; i < n; i++)
+            d[i] = a[i] * b[i] + c[i];
+    }
+
+    /**
+        Uguaglianza byte a byte (usata per i tipi interi), a blocchi di 16/32/64 byte
+    */
+    static bool equal_bytes(const unsigned char *a, const unsigned char *b, std::size_t bytes) {
+        std::size_t words = bytes / sizeof(std::int32_t);
+        const std::int32_t *wa = reinterpret_cast<const std::int32_t *>(a);
+        const std::int32_t *wb = reinterpret_cast<const std::int32_t *>(b);
+        bool eq;
+        switch (level()) {
+            case avx512: eq = equal_avx512(wa, wb, words); break;
+            case avx2: eq = equal_avx2(wa, wb, words); break;
+            default: eq = equal_sse2(wa, wb, words); break;
+        }
+        std::size_t done = words * sizeof(std::int32_t);
+        return eq && std::memcmp(a + done, b + done, bytes - done) == 0;
+    }
+
+    /**
+        Conversioni: un passo converte W elementi. Per ogni insieme di istruzioni
+        definisco step(dst, src) per le coppie supportate da hasConvert.
+    */
+    // SSE2
+    M3D_TARGET_SSE2 static void cstep_sse2(float *d, const std::int32_t *s) { _mm_storeu_ps(d, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)s))); }
+    M3D_TARGET_SSE2 static void cstep_sse2(std::int32_t *d, const float *s) { _mm_storeu_si128((__m128i *)d, _mm_cvttps_epi32(_mm_loadu_ps(s))); }
+    M3D_TARGET_SSE2 static void cstep_sse2(double *d, const float *s) {
+        __m128 v = _mm_loadu_ps(s);
+        _mm_storeu_pd(d, _mm_cvtps_pd(v));
+        _mm_storeu_pd(d + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    M3D_TARGET_SSE2 static void cstep_sse2(float *d, const double *s) {
+        _mm_storeu_ps(d, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(s)), _mm_cvtpd_ps(_mm_loadu_pd(s + 2))));
+    }
+    M3D_TARGET_SSE2 static void cstep_sse2(float *d, const std::uint8_t *s) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i w = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int *)s), zero);
+        _mm_storeu_ps(d, _mm_cvtepi32_ps(_mm_unpacklo_epi16(w, zero)));
+    }
+    M3D_TARGET_SSE2 static void cstep_sse2(float *d, const std::int16_t *s) {
+        __m128i w = _mm_loadl_epi64((const __m128i *)s);
+        // Estensione di segno: duplico le parole e scorro a destra di 16 bit
+        _mm_storeu_ps(d, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16)));
+    }
+    // AVX2
+    M3D_TARGET_AVX2 static void cstep_avx2(float *d, const std::int32_t *s) { _mm256_storeu_ps(d, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *)s))); }
+    M3D_TARGET_AVX2 static void cstep_avx2(std::int32_t *d, const float *s) { _mm256_storeu_si256((__m256i *)d, _mm256_cvttps_epi32(_mm256_loadu_ps(s))); }
+    M3D_TARGET_AVX2 static void cstep_avx2(double *d, const float *s) {
+        _mm256_storeu_pd(d, _mm256_cvtps_pd(_mm_loadu_ps(s)));
+        _mm256_storeu_pd(d + 4, _mm256_cvtps_pd(_mm_loadu_ps(s + 4)));
+    }
+    M3D_TARGET_AVX2 static void cstep_avx2(float *d, const double *s) {
+        _mm256_storeu_ps(d, _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(s + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(s))));
+    }
+    M3D_TARGET_AVX2 static void cstep_avx2(float *d, const std::uint8_t *s) { _mm256_storeu_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)s)))); }
+    M3D_TARGET_AVX2 static void cstep_avx2(float *d, const std::int16_t *s) { _mm256_storeu_ps(d, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)s)))); }
+    // AVX-512
+    M3D_TARGET_AVX512 static void cstep_avx512(float *d, const std::int32_t *s) { _mm512_storeu_ps(d, _mm512_cvtepi32_ps(_mm512_loadu_si512((const void *)s))); }
+    M3D_TARGET_AVX512 static void cstep_avx512(std::int32_t *d, const float *s) { _mm512_storeu_si512((void *)d, _mm512_cvttps_epi32(_mm512_loadu_ps(s))); }
+    M3D_TARGET_AVX512 static void cstep_avx512(double *d, const float *s) {
+        _mm512_storeu_pd(d, _mm512_cvtps_pd(_mm256_loadu_ps(s)));
+        _mm512_storeu_pd(d + 8, _mm512_cvtps_pd(_mm256_loadu_ps(s + 8)));
+    }
+    M3D_TARGET_AVX512 static void cstep_avx512(float *d, const double *s) {
+        _mm256_storeu_ps(d, _mm512_cvtpd_ps(_mm512_loadu_pd(s)));
+        _mm256_storeu_ps(d + 8, _mm512_cvtpd_ps(_mm512_loadu_pd(s + 8)));
+    }
+    M3D_TARGET_AVX512 static void cstep_avx512(float *d, const std::uint8_t *s) { _mm512_storeu_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)s)))); }
+    M3D_TARGET_AVX512 static void cstep_avx512(float *d, const std::int16_t *s) { _mm512_storeu_ps(d, _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *)s)))); }
+
+#define M3D_SIMD_CONVERT(ISA, ATTR, W)                                                           \
+    template <class T, class U> ATTR static void convert_##ISA(T *d, const U *s, std::size_t n) { \
+        std::size_t i = 0;                                                                       \
+        for (; i + W <= n; i += W)                                                               \
+            cstep_##ISA(d + i, s + i);                                                           \
+        for (; i < n; i++)                                                                       \
+            d[i] = static_cast<T>(s[i]);                                                         \
+    }
+
+    M3D_SIMD_CONVERT(sse2, M3D_TARGET_SSE2, 4)
+    M3D_SIMD_CONVERT(avx2, M3D_TARGET_AVX2, 8)
+    M3D_SIMD_CONVERT(avx512, M3D_TARGET_AVX512, 16)
+
+#undef M3D_SIMD_CONVERT
+
+    /**
+        Trasposizione nei registri di una tile quadrata: la riga k di src (distanza lds)
+        diventa la colonna k di dst (distanza ldd). float e double stanno per qualsiasi
+        tipo di 4 e 8 byte.
+    */
+    M3D_TARGET_SSE2 static void tstep_sse2(float *d, std::size_t ldd, const float *s, std::size_t lds) {
+        __m128 r0 = _mm_loadu_ps(s), r1 = _mm_loadu_ps(s + lds), r2 = _mm_loadu_ps(s + 2 * lds), r3 = _mm_loadu_ps(s + 3 * lds);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(d, r0);
+        _mm_storeu_ps(d + ldd, r1);
+        _mm_storeu_ps(d + 2 * ldd, r2);
+        _mm_storeu_ps(d + 3 * ldd, r3);
+    }
+    M3D_TARGET_SSE2 static void tstep_sse2(double *d, std::size_t ldd, const double *s, std::size_t lds) {
+        __m128d r0 = _mm_loadu_pd(s), r1 = _mm_loadu_pd(s + lds);
+        _mm_storeu_pd(d, _mm_unpacklo_pd(r0, r1));
+        _mm_storeu_pd(d + ldd, _mm_unpackhi_pd(r0, r1));
+    }
+    M3D_TARGET_AVX2 static void tstep_avx2(float *d, std::size_t ldd, const float *s, std::size_t lds) {
+        __m256 r[8], t[8];
+        for (int k = 0; k < 8; k++)
+            r[k] = _mm256_loadu_ps(s + k * lds);
+        // Coppie di righe intercalate, poi quartine, poi scambio delle meta' da 128 bit
+        for (int k = 0; k < 8; k += 2) {
+            t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+            t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+        }
+        for (int k = 0; k < 8; k += 4) {
+            r[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        for (int k = 0; k < 4; k++) {
+            _mm256_storeu_ps(d + k * ldd, _mm256_permute2f128_ps(r[k], r[k + 4], 0x20));
+            _mm256_storeu_ps(d + (k + 4) * ldd, _mm256_permute2f128_ps(r[k], r[k + 4], 0x31));
+        }
+    }
+    M3D_TARGET_AVX2 static void tstep_avx2(double *d, std::size_t ldd, const double *s, std::size_t lds) {
+        __m256d r0 = _mm256_loadu_pd(s), r1 = _mm256_loadu_pd(s + lds), r2 = _mm256_loadu_pd(s + 2 * lds), r3 = _mm256_loadu_pd(s + 3 * lds);
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+        _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(d + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(d + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(d + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+
+    /**
+        Trasposizione a tile di W x W elementi (W = BYTES / sizeof(T)), con i bordi
+        rimanenti trasposti elemento per elemento.
+    */
+#define M3D_SIMD_TRANSPOSE(ISA, ATTR, BYTES)                                                     \
+    template <class T> ATTR static void transpose_##ISA(T *d, std::size_t ldd, const T *s, std::size_t lds, \
+                                                        std::size_t m, std::size_t n) {          \
+        typedef typename std::conditional<sizeof(T) == 4, float, double>::type V;                \
+        const std::size_t W = BYTES / sizeof(T);                                                 \
+        std::size_t mw = m - m % W, nw = n - n % W;                                              \
+        for (std::size_t i = 0; i < mw; i += W) {                                                \
+            for (std::size_t j = 0; j < nw; j += W)                                              \
+                tstep_##ISA(reinterpret_cast<V *>(d + i * ldd + j), ldd,                         \
+                            reinterpret_cast<const V *>(s + j * lds + i), lds);                  \
+            for (std::size_t k = i; k < i + W; k++)                                              \
+                for (std::size_t j = nw; j < n; j++)                                             \
+                    d[k * ldd + j] = s[j * lds + k];                                             \
+        }                                                                                        \
+        for (std::size_t i = mw; i < m; i++)                                                     \
+            for (std::size_t j = 0; j < n; j++)                                                  \
+                d[i * ldd + j] = s[j * lds + i];                                                 \
+    }
+
+    M3D_SIMD_TRANSPOSE(sse2, M3D_TARGET_SSE2, 16)
+    M3D_SIMD_TRANSPOSE(avx2, M3D_TARGET_AVX2, 32)
+
+#undef M3D_SIMD_TRANSPOSE
+
+#endif // MATRICE3D_SIMD_X86
+};
+
+#undef M3D_TARGET_SSE2
+#undef M3D_TARGET_AVX2
+#undef M3D_TARGET_AVX512
+
+#endif
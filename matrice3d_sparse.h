@@ -0,0 +1,609 @@
+#ifndef MATRICE3D_SPARSE_H
+#define MATRICE3D_SPARSE_H
+
+#include <cstddef> // size_t
+#include <algorithm> // all_of, copy, fill, min
+#include <memory> // unique_ptr
+#include <iterator> // forward_iterator_tag
+#include <vector> // indice dei mattoni
+#include "matrice3d.h" // Matrice3D, Matrice3DSimd, m3dForBlocks, m3dHasApply
+
+/**
+    @brief Classe Matrice3DSparse: Matrice3D per volumi in gran parte vuoti
+
+    Il volume e' diviso in mattoni (brick) di B x B x B elementi. Sono memorizzati solo
+    i mattoni che contengono almeno un elemento diverso dal valore di riempimento (fill):
+    tutti gli altri elementi valgono implicitamente fill. Un indice denso con una voce
+    per mattone (1 / B^3 degli elementi) porta dalle coordinate al mattone in tempo
+    costante, senza hash.
+
+    - L'operatore () in lettura (const) ritorna fill per i mattoni non memorizzati.
+    - L'operatore () non const ritorna un Matrice3DElementRef: il mattone (riempito con
+      fill) viene allocato solo quando l'elemento viene assegnato, non quando viene letto.
+    - begin() ed end() visitano solo i mattoni memorizzati (vedi brick_ref).
+    - ==, slice() e trasform() lavorano sui soli mattoni memorizzati e saltano le
+      regioni vuote.
+    - Il costruttore da Matrice3D e materialize() convertono da e verso la forma densa.
+
+    I mattoni ai bordi possono sporgere oltre la matrice: gli elementi di riempimento
+    valgono sempre fill (trasform li trasforma insieme al valore di fill).
+
+    @tparam B lato del mattone (potenza di 2)
+
+*/
+template <class T, class Cmp = defaultCmp, class Check = checkedAccess, unsigned int B = 8> class Matrice3DSparse
+{
+    template <class, class, class, unsigned int> friend class Matrice3DSparse;
+    template <class> friend class Matrice3DElementRef;
+    template <class Q, class FQ, class U, class C, class Ch, unsigned int BB, class F, class Policy>
+    friend Matrice3DSparse<Q, FQ, Ch, BB> m3dSparseTrasform(const Matrice3DSparse<U, C, Ch, BB> &, F, const Policy &);
+
+    static_assert(B > 0 && (B & (B - 1)) == 0, "Matrice3DSparse: il lato del mattone deve essere una potenza di 2");
+
+    public:
+
+    static constexpr unsigned int brick_edge = B; ///< lato del mattone
+    static constexpr unsigned int brick_size = B * B * B; ///< elementi di un mattone
+
+    private:
+
+    /// Mattoni allocati insieme (blocchi di circa 16K elementi)
+    static constexpr unsigned int chunk_bricks = brick_size >= 16384 ? 1 : 16384 / brick_size;
+    /// Voce dell'indice per un mattone non memorizzato
+    static constexpr unsigned int empty = ~0u;
+
+    unsigned int _sizeX; ///< dimensione X
+    unsigned int _sizeY; ///< dimensione Y
+    unsigned int _sizeZ; ///< dimensione Z
+    unsigned int _bricksX; ///< mattoni lungo X
+    unsigned int _bricksY; ///< mattoni lungo Y
+    unsigned int _bricksZ; ///< mattoni lungo Z
+    T _fill; ///< valore degli elementi non memorizzati
+    Cmp _cmp; ///< funtore di confronto
+    std::vector<unsigned int> _index; ///< slot di ogni mattone (empty se non memorizzato)
+    std::vector<unsigned int> _brick; ///< mattone contenuto in ogni slot
+    std::vector<std::unique_ptr<T[]> > _chunks; ///< memoria degli slot (indirizzi stabili)
+
+    public:
+
+    typedef T value_type; ///< tipo degli elementi
+    typedef Matrice3DElementRef<Matrice3DSparse> reference; ///< riferimento in lettura e scrittura
+
+    /**
+        Costruttore di default: Matrice3DSparse vuota
+    */
+    Matrice3DSparse() : _sizeX(0), _sizeY(0), _sizeZ(0), _bricksX(0), _bricksY(0), _bricksZ(0), _fill() {}
+
+    /**
+        Costruttore: Matrice3DSparse z * y * x con tutti gli elementi a fill, senza
+        alcun mattone memorizzato.
+
+        @param z, y, x dimensioni
+        @param fill valore degli elementi non memorizzati
+
+        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida
+    */
+    Matrice3DSparse(int z, int y, int x, const T &fill = T()) : Matrice3DSparse() {
+        if (z <= 0 || y <= 0 || x <= 0)
+            throw Matrice3DOutOfRange("ERRORE: Indici fuori dai limiti della matrice");
+        _sizeZ = z;
+        _sizeY = y;
+        _sizeX = x;
+        _bricksZ = (z + B - 1) / B;
+        _bricksY = (y + B - 1) / B;
+        _bricksX = (x + B - 1) / B;
+        _fill = fill;
+        _index.assign(std::size_t(_bricksZ) * _bricksY * _bricksX, empty);
+    }
+
+    /**
+        Costruttore di conversione da una Matrice3D densa: memorizza solo i mattoni
+        con almeno un elemento diverso da fill (secondo il funtore Cmp).
+
+        @param other Matrice3D da convertire (qualsiasi layout)
+        @param fill valore degli elementi non memorizzati
+    */
+    template <class C, class Ch, class A, class L>
+    explicit Matrice3DSparse(const Matrice3D<T, C, Ch, A, L> &other, const T &fill = T()) : Matrice3DSparse() {
+        if constexpr (!L::contiguous) {
+            *this = Matrice3DSparse(Matrice3D<T, C>(other), fill);
+            return;
+        }
+        if (other.size() == 0)
+            return;
+        Matrice3DSparse tmp(other.sizeZ(), other.sizeY(), other.sizeX(), fill);
+        const T *src = other.data();
+        std::size_t sz = other.strideZ(), sy = other.strideY();
+        for (unsigned int id = 0; id < tmp._index.size(); id++) {
+            unsigned int z0, y0, x0, nz, ny, nx;
+            tmp.brick_extent(id, z0, y0, x0, nz, ny, nx);
+            // Cerco un elemento diverso da fill, riga per riga
+            bool used = false;
+            for (unsigned int dz = 0; dz < nz && !used; dz++)
+                for (unsigned int dy = 0; dy < ny && !used; dy++) {
+                    const T *row = src + (z0 + dz) * sz + (y0 + dy) * sy + x0;
+                    for (unsigned int dx = 0; dx < nx; dx++)
+                        if (!tmp._cmp(row[dx], fill)) {
+                            used = true;
+                            break;
+                        }
+                }
+            if (!used)
+                continue;
+            T *dst = tmp.allocate_brick(id);
+            for (unsigned int dz = 0; dz < nz; dz++)
+                for (unsigned int dy = 0; dy < ny; dy++) {
+                    const T *row = src + (z0 + dz) * sz + (y0 + dy) * sy + x0;
+                    std::copy(row, row + nx, dst + (dz * B + dy) * B);
+                }
+        }
+        swap(tmp);
+    }
+
+    /**
+        Copy constructor: copia l'indice e i soli mattoni memorizzati
+
+        @param other Matrice3DSparse da copiare
+    */
+    Matrice3DSparse(const Matrice3DSparse &other)
+        : _sizeX(other._sizeX), _sizeY(other._sizeY), _sizeZ(other._sizeZ), _bricksX(other._bricksX),
+          _bricksY(other._bricksY), _bricksZ(other._bricksZ), _fill(other._fill), _cmp(other._cmp),
+          _index(other._index), _brick(other._brick) {
+        std::size_t left = _brick.size() * std::size_t(brick_size);
+        for (std::size_t c = 0; c < other._chunks.size(); c++) {
+            _chunks.emplace_back(new T[std::size_t(chunk_bricks) * brick_size]);
+            std::size_t n = std::min(left, std::size_t(chunk_bricks) * brick_size);
+            std::copy(other._chunks[c].get(), other._chunks[c].get() + n, _chunks[c].get());
+            left -= n;
+        }
+    }
+
+    /**
+        Move constructor: other resta vuota
+
+        @param other Matrice3DSparse da spostare
+    */
+    Matrice3DSparse(Matrice3DSparse &&other) : Matrice3DSparse() {
+        swap(other);
+    }
+
+    /**
+        Operatore di assegnamento (copy and swap)
+
+        @param other Matrice3DSparse da copiare
+
+        @return reference alla Matrice3DSparse this
+    */
+    Matrice3DSparse& operator=(const Matrice3DSparse &other) {
+        if (this != &other) {
+            Matrice3DSparse tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    Matrice3DSparse& operator=(Matrice3DSparse &&other) {
+        if (this != &other) {
+            Matrice3DSparse tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    /**
+        Scambia il contenuto di due Matrice3DSparse
+
+        @param other Matrice3DSparse con cui scambiare
+    */
+    void swap(Matrice3DSparse &other) {
+        std::swap(_sizeX, other._sizeX);
+        std::swap(_sizeY, other._sizeY);
+        std::swap(_sizeZ, other._sizeZ);
+        std::swap(_bricksX, other._bricksX);
+        std::swap(_bricksY, other._bricksY);
+        std::swap(_bricksZ, other._bricksZ);
+        std::swap(_fill, other._fill);
+        std::swap(_cmp, other._cmp);
+        _index.swap(other._index);
+        _brick.swap(other._brick);
+        _chunks.swap(other._chunks);
+    }
+
+    /**
+        Metodo clear(): libera tutti i mattoni e riporta la matrice allo stato vuoto
+    */
+    void clear() {
+        Matrice3DSparse tmp;
+        swap(tmp);
+    }
+
+    unsigned int sizeX() const { return _sizeX; } ///< dimensione X
+    unsigned int sizeY() const { return _sizeY; } ///< dimensione Y
+    unsigned int sizeZ() const { return _sizeZ; } ///< dimensione Z
+
+    /// Numero di elementi (memorizzati e non)
+    std::size_t size() const { return std::size_t(_sizeZ) * _sizeY * _sizeX; }
+
+    /// Valore degli elementi non memorizzati
+    const T &fill_value() const { return _fill; }
+
+    /// Numero di mattoni memorizzati
+    std::size_t bricks() const { return _brick.size(); }
+
+    /// Numero di elementi memorizzati (mattoni per elementi di un mattone)
+    std::size_t storage_size() const { return _brick.size() * std::size_t(brick_size); }
+
+    /**
+        Operatore (): Ritorna il valore delle coordinate (z, y, x), fill se il mattone
+        non e' memorizzato.
+
+        @return Valore delle coordinate (z, y, x) constante
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    const T& operator()(int z, int y, int x) const {
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        unsigned int s = _index[brick_id(z, y, x)];
+        if (s == empty)
+            return _fill;
+        return slot_data(s)[cell(z, y, x)];
+    }
+
+    /**
+        Operatore (): Ritorna il riferimento all'elemento (z, y, x). Il mattone (con tutti
+        gli elementi a fill) viene allocato solo quando l'elemento viene assegnato, se non
+        e' memorizzato: le letture non allocano. Es: G(1,2,3) = G(2,2,3).
+
+        @return Riferimento all'elemento delle coordinate (z, y, x)
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide (checkedAccess)
+    */
+    reference operator()(int z, int y, int x) {
+        Check::check(z, y, x, _sizeZ, _sizeY, _sizeX);
+        return reference(this, std::size_t(brick_id(z, y, x)) * brick_size + cell(z, y, x));
+    }
+
+    /**
+        Metodo prune: elimina i mattoni in cui tutti gli elementi valgono fill (ad es.
+        dopo delle scritture o una trasformazione). Invalida i riferimenti agli elementi.
+    */
+    void prune() {
+        for (std::size_t s = _brick.size(); s-- > 0;) {
+            const T *p = slot_data(s);
+            bool used = false;
+            for (unsigned int i = 0; i < brick_size && !used; i++)
+                used = !_cmp(p[i], _fill);
+            if (!used)
+                release_slot(s);
+        }
+    }
+
+    /**
+        Metodo materialize: copia la matrice in una Matrice3D densa
+
+        @return Matrice3D con gli stessi valori
+    */
+    Matrice3D<T, Cmp> materialize() const {
+        if (size() == 0)
+            return Matrice3D<T, Cmp>();
+        Matrice3D<T, Cmp> res(_sizeZ, _sizeY, _sizeX);
+        std::fill(res.data(), res.data() + res.size(), _fill);
+        for (std::size_t s = 0; s < _brick.size(); s++) {
+            unsigned int z0, y0, x0, nz, ny, nx;
+            brick_extent(_brick[s], z0, y0, x0, nz, ny, nx);
+            const T *src = slot_data(s);
+            for (unsigned int dz = 0; dz < nz; dz++)
+                for (unsigned int dy = 0; dy < ny; dy++) {
+                    const T *row = src + (dz * B + dy) * B;
+                    std::copy(row, row + nx, res.data() + (z0 + dz) * res.strideZ() + (y0 + dy) * res.strideY() + x0);
+                }
+        }
+        return res;
+    }
+
+    /**
+        Metodo slice: Ritorna la sotto-Matrice3DSparse negli intervalli di coordinate
+        z1..z2, y1..y2 e x1..x2, con lo stesso fill. Vengono copiati solo i mattoni
+        memorizzati che intersecano l'intervallo, e il risultato non memorizza mattoni
+        che contengono solo fill.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Sotto-Matrice3DSparse
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3DSparse slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        if (z1 > z2 || y1 > y2 || x1 > x2)
+            throw Matrice3DInvalidParameters("ERRORE: Parametri forniti invalidi");
+        if (z1 < 0 || z2 >= (int)_sizeZ || y1 < 0 || y2 >= (int)_sizeY || x1 < 0 || x2 >= (int)_sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+        Matrice3DSparse res(z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1, _fill);
+        res._cmp = _cmp;
+        for (std::size_t s = 0; s < _brick.size(); s++) {
+            unsigned int z0, y0, x0, nz, ny, nx;
+            brick_extent(_brick[s], z0, y0, x0, nz, ny, nx);
+            // Intersezione del mattone con l'intervallo
+            int za = std::max<int>(z0, z1), zb = std::min<int>(z0 + nz - 1, z2);
+            int ya = std::max<int>(y0, y1), yb = std::min<int>(y0 + ny - 1, y2);
+            int xa = std::max<int>(x0, x1), xb = std::min<int>(x0 + nx - 1, x2);
+            if (za > zb || ya > yb || xa > xb)
+                continue;
+            const T *src = slot_data(s);
+            for (int z = za; z <= zb; z++)
+                for (int y = ya; y <= yb; y++) {
+                    const T *row = src + ((z - z0) * B + (y - y0)) * B;
+                    // La riga cade in al piu' due mattoni del risultato
+                    for (int x = xa; x <= xb;) {
+                        unsigned int rz = z - z1, ry = y - y1, rx = x - x1;
+                        unsigned int id = res.brick_id(rz, ry, rx);
+                        unsigned int rs = res._index[id];
+                        int n = std::min<int>(xb - x + 1, B - rx % B);
+                        const T *seg = row + (x - x0);
+                        x += n;
+                        // Un tratto tutto a fill non crea mattoni nel risultato
+                        if (rs == empty && std::all_of(seg, seg + n, [&](const T &v) { return _cmp(v, _fill); }))
+                            continue;
+                        T *dst = rs == empty ? res.allocate_brick(id) : res.slot_data(rs);
+                        std::copy(seg, seg + n, dst + res.cell(rz, ry, rx));
+                    }
+                }
+        }
+        return res;
+    }
+
+    /**
+        Operator ==: Verifica che due Matrice3DSparse contengano gli stessi valori.
+                     I mattoni non memorizzati in nessuna delle due si confrontano
+                     tramite i soli valori di fill.
+
+        @param other Matrice3DSparse da confrontare
+
+        @return true se le due matrici contengono gli stessi valori, false altrimenti
+    */
+    bool operator==(const Matrice3DSparse &other) const {
+        if (_sizeX != other._sizeX || _sizeY != other._sizeY || _sizeZ != other._sizeZ)
+            return false;
+        bool sameFill = _cmp(_fill, other._fill);
+        for (unsigned int id = 0; id < _index.size(); id++) {
+            unsigned int a = _index[id], b = other._index[id];
+            if (a == empty && b == empty) {
+                if (!sameFill)
+                    return false;
+                continue;
+            }
+            const T *pa = a == empty ? nullptr : slot_data(a);
+            const T *pb = b == empty ? nullptr : other.slot_data(b);
+            // Stesso fill: il riempimento dei mattoni coincide, confronto il mattone intero
+            if (pa && pb && sameFill) {
+                if constexpr (std::is_same<Cmp, defaultCmp>::value && std::is_arithmetic<T>::value) {
+                    if (!Matrice3DSimd::equal(pa, pb, brick_size))
+                        return false;
+                } else {
+                    for (unsigned int i = 0; i < brick_size; i++)
+                        if (!_cmp(pa[i], pb[i]))
+                            return false;
+                }
+                continue;
+            }
+            // Altrimenti confronto i soli elementi interni alla matrice
+            unsigned int z0, y0, x0, nz, ny, nx;
+            brick_extent(id, z0, y0, x0, nz, ny, nx);
+            for (unsigned int dz = 0; dz < nz; dz++)
+                for (unsigned int dy = 0; dy < ny; dy++)
+                    for (unsigned int dx = 0; dx < nx; dx++) {
+                        unsigned int i = (dz * B + dy) * B + dx;
+                        if (!_cmp(pa ? pa[i] : _fill, pb ? pb[i] : other._fill))
+                            return false;
+                    }
+        }
+        return true;
+    }
+
+    /**
+     @brief Riferimento a un mattone memorizzato (valore degli iteratori)
+
+            Gli elementi del mattone sono in row-major con lato B: l'elemento (dz, dy, dx)
+            si trova in data()[(dz * B + dy) * B + dx] e corrisponde all'elemento
+            (z() + dz, y() + dy, x() + dx) della matrice. sizeZ/Y/X() escludono la parte
+            che sporge oltre la matrice.
+    */
+    template <class V> class brick_ref {
+        V *_data; ///< elementi del mattone
+        unsigned int _z0, _y0, _x0; ///< origine del mattone
+        unsigned int _nz, _ny, _nx; ///< elementi interni alla matrice
+
+        public:
+        brick_ref(V *data, unsigned int z0, unsigned int y0, unsigned int x0, unsigned int nz, unsigned int ny, unsigned int nx)
+            : _data(data), _z0(z0), _y0(y0), _x0(x0), _nz(nz), _ny(ny), _nx(nx) {}
+
+        unsigned int z() const { return _z0; } ///< piano di origine
+        unsigned int y() const { return _y0; } ///< riga di origine
+        unsigned int x() const { return _x0; } ///< colonna di origine
+        unsigned int sizeZ() const { return _nz; } ///< piani interni alla matrice
+        unsigned int sizeY() const { return _ny; } ///< righe interne alla matrice
+        unsigned int sizeX() const { return _nx; } ///< colonne interne alla matrice
+        V *data() const { return _data; } ///< elementi del mattone (B^3)
+
+        /// Elemento (dz, dy, dx) relativo all'origine del mattone
+        V &operator()(unsigned int dz, unsigned int dy, unsigned int dx) const { return _data[(dz * B + dy) * B + dx]; }
+    };
+
+    /**
+     @brief Forward iterator sui mattoni memorizzati
+
+            Il valore e' un brick_ref (proxy): l'ordine di visita e' quello di
+            allocazione dei mattoni.
+    */
+    template <class V> class brick_iterator {
+        typedef typename std::conditional<std::is_const<V>::value, const Matrice3DSparse, Matrice3DSparse>::type M;
+
+        M *_m; ///< matrice su cui si itera
+        std::size_t _s; ///< slot corrente
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef brick_ref<V> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef brick_ref<V> reference;
+
+        brick_iterator() : _m(nullptr), _s(0) {}
+        brick_iterator(M *m, std::size_t s) : _m(m), _s(s) {}
+
+        reference operator*() const {
+            unsigned int z0, y0, x0, nz, ny, nx;
+            _m->brick_extent(_m->_brick[_s], z0, y0, x0, nz, ny, nx);
+            return reference(_m->slot_data(_s), z0, y0, x0, nz, ny, nx);
+        }
+
+        brick_iterator& operator++() { ++_s; return *this; }
+        brick_iterator operator++(int) { brick_iterator tmp(*this); ++_s; return tmp; }
+
+        bool operator==(const brick_iterator &other) const { return _s == other._s; }
+        bool operator!=(const brick_iterator &other) const { return _s != other._s; }
+    };
+
+    typedef brick_iterator<T> iterator;
+    typedef brick_iterator<const T> const_iterator;
+
+    // Metodi membro begin() e end() per l'iterazione sui mattoni memorizzati
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, _brick.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _brick.size()); }
+
+    private:
+
+    /// Mattone che contiene (z, y, x)
+    unsigned int brick_id(unsigned int z, unsigned int y, unsigned int x) const {
+        return ((z / B) * _bricksY + y / B) * _bricksX + x / B;
+    }
+
+    /// Posizione di (z, y, x) nel proprio mattone
+    static unsigned int cell(unsigned int z, unsigned int y, unsigned int x) {
+        return ((z % B) * B + y % B) * B + x % B;
+    }
+
+    // Elemento i = mattone * brick_size + cella: in lettura (fill se il mattone non e'
+    // memorizzato) o in scrittura (il mattone viene allocato se manca)
+    const T& load_element(std::size_t i) const {
+        unsigned int s = _index[i / brick_size];
+        return s == empty ? _fill : slot_data(s)[i % brick_size];
+    }
+    T& store_element(std::size_t i) {
+        unsigned int id = (unsigned int)(i / brick_size);
+        unsigned int s = _index[id];
+        T *p = s == empty ? allocate_brick(id) : slot_data(s);
+        return p[i % brick_size];
+    }
+
+    /// Origine del mattone id e numero di elementi interni alla matrice lungo ogni asse
+    void brick_extent(unsigned int id, unsigned int &z0, unsigned int &y0, unsigned int &x0,
+                      unsigned int &nz, unsigned int &ny, unsigned int &nx) const {
+        x0 = (id % _bricksX) * B;
+        y0 = (id / _bricksX % _bricksY) * B;
+        z0 = (id / _bricksX / _bricksY) * B;
+        nx = std::min(B, _sizeX - x0);
+        ny = std::min(B, _sizeY - y0);
+        nz = std::min(B, _sizeZ - z0);
+    }
+
+    T *slot_data(std::size_t s) const {
+        return _chunks[s / chunk_bricks].get() + (s % chunk_bricks) * std::size_t(brick_size);
+    }
+
+    /// Memorizza il mattone id (tutti gli elementi a fill) e ritorna i suoi elementi
+    T *allocate_brick(unsigned int id) {
+        std::size_t s = _brick.size();
+        if (s % chunk_bricks == 0)
+            _chunks.emplace_back(new T[std::size_t(chunk_bricks) * brick_size]);
+        _brick.push_back(id);
+        _index[id] = (unsigned int)s;
+        T *p = slot_data(s);
+        std::fill(p, p + brick_size, _fill);
+        return p;
+    }
+
+    /// Elimina lo slot s spostandovi l'ultimo mattone
+    void release_slot(std::size_t s) {
+        std::size_t last = _brick.size() - 1;
+        _index[_brick[s]] = empty;
+        if (s != last) {
+            std::copy(slot_data(last), slot_data(last) + brick_size, slot_data(s));
+            _brick[s] = _brick[last];
+            _index[_brick[s]] = (unsigned int)s;
+        }
+        _brick.pop_back();
+        if (_brick.size() % chunk_bricks == 0)
+            _chunks.pop_back();
+    }
+};
+
+/**
+    Trasformazione dei soli mattoni memorizzati: il fill del risultato e' funz(fill) e
+    l'indice dei mattoni e' lo stesso di A. I blocchi di mattoni vengono trasformati
+    secondo la politica.
+*/
+template <class Q, class FQ, class U, class C, class Ch, unsigned int B, class F, class Policy>
+Matrice3DSparse<Q, FQ, Ch, B> m3dSparseTrasform(const Matrice3DSparse<U, C, Ch, B> &A, F funz, const Policy &policy) {
+    typedef Matrice3DSparse<Q, FQ, Ch, B> R;
+    R res;
+    if (A.size() == 0)
+        return res;
+    res._sizeZ = A._sizeZ;
+    res._sizeY = A._sizeY;
+    res._sizeX = A._sizeX;
+    res._bricksZ = A._bricksZ;
+    res._bricksY = A._bricksY;
+    res._bricksX = A._bricksX;
+    res._fill = static_cast<Q>(funz(A._fill));
+    res._index = A._index;
+    res._brick = A._brick;
+    for (std::size_t c = 0; c < A._chunks.size(); c++)
+        res._chunks.emplace_back(new Q[std::size_t(R::chunk_bricks) * R::brick_size]);
+    const std::size_t V = R::brick_size;
+    m3dForBlocks(policy, A._brick.size() * V, V, [&](std::size_t b, std::size_t e) {
+        for (std::size_t s = b / V; s < e / V; s++) {
+            const U *in = A.slot_data(s);
+            Q *out = res.slot_data(s);
+            if constexpr (m3dHasApply<F, Q, U>::value)
+                funz.apply(out, in, V);
+            else
+                for (std::size_t i = 0; i < V; i++)
+                    out[i] = static_cast<Q>(funz(in[i]));
+        }
+    });
+    return res;
+}
+
+/**
+    Metodo GLOBALE transform per la Matrice3DSparse: applica il funtore ai soli mattoni
+    memorizzati e al valore di fill, B(i,j,k) = F(A(i,j,k)). Il funtore deve dipendere
+    solo dal valore dell'elemento.
+
+    @param A Matrice3DSparse su tipi T, F funtore generico
+
+    @return Matrice3DSparse B su tipi Q con il funtore applicato
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DSparse<Q, FQ, Ch, B> trasform(const Matrice3DSparse<T, C, Ch, B> &A, F funz) {
+    return m3dSparseTrasform<Q, FQ>(A, funz, m3dSeq);
+}
+
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DSparse<Q, FQ, Ch, B> trasform(const Matrice3DSparse<T, C, Ch, B> &A, F funz, const m3dSeqPolicy &) {
+    return m3dSparseTrasform<Q, FQ>(A, funz, m3dSeq);
+}
+
+/**
+    Metodo GLOBALE transform per la Matrice3DSparse con politica parallela: i blocchi di
+    mattoni vengono trasformati in parallelo sul pool.
+*/
+template <typename Q, typename FQ = defaultCmp, typename T, class C, class Ch, unsigned int B, typename F>
+Matrice3DSparse<Q, FQ, Ch, B> trasform(const Matrice3DSparse<T, C, Ch, B> &A, F funz, const m3dParPolicy &policy) {
+    return m3dSparseTrasform<Q, FQ>(A, funz, policy);
+}
+
+#endif
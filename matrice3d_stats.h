@@ -0,0 +1,247 @@
+#ifndef MATRICE3D_STATS_H
+#define MATRICE3D_STATS_H
+
+#include <cstdint> // uint64_t
+
+/**
+    @brief Strumentazione delle operazioni della Matrice3D
+
+    Disattivata di default: va abilitata definendo MATRICE3D_STATS prima di includere
+    matrice3d.h (o con -DMATRICE3D_STATS). Senza la macro i punti di misura si espandono
+    a nulla e non resta alcun costo.
+
+    Con la strumentazione attiva ogni operazione registra numero di chiamate, byte
+    trattati e tempo trascorso (orologio monotono) nei contatori del thread corrente,
+    senza sincronizzazione tra thread. Matrice3DStats::snapshot() somma i contatori di
+    tutti i thread (compresi quelli gia' terminati), Matrice3DStats::json() li scrive
+    in formato JSON, es.
+
+        {"alloc": {"count": 12, "bytes": 4800, "ns": 0}, "copy": {...}, ...}
+
+    Le operazioni annidate vengono contate entrambe: l'assegnamento per copia conta
+    anche la copia che esegue, e ogni operazione conta le proprie allocazioni.
+
+*/
+enum Matrice3DOp {
+    m3dOpAlloc,      ///< allocazione del buffer (byte allocati, senza tempo)
+    m3dOpCopy,       ///< copia profonda (copy constructor)
+    m3dOpAssign,     ///< assegnamento per copia (operator=)
+    m3dOpConvert,    ///< costruttore di conversione
+    m3dOpSlice,      ///< estrazione di una sotto-matrice con slice()
+    m3dOpFill,       ///< fill da una sequenza
+    m3dOpEqual,      ///< operator== ed equals()
+    m3dOpTrasform,   ///< trasform globale
+    m3dOpHash,       ///< calcolo di hash()
+    m3dOpOutOfRange, ///< Matrice3DOutOfRange lanciata dall'accesso controllato
+    m3dOpCount       ///< numero di operazioni
+};
+
+/**
+    @brief Contatori di un'operazione
+*/
+struct Matrice3DOpStats {
+    std::uint64_t count = 0; ///< numero di chiamate
+    std::uint64_t bytes = 0; ///< byte letti o scritti
+    std::uint64_t ns = 0;    ///< tempo totale in nanosecondi
+};
+
+#ifdef MATRICE3D_STATS
+
+#include <atomic> // atomic
+#include <chrono> // steady_clock
+#include <mutex> // mutex, lock_guard
+#include <ostream> // ostream
+#include <sstream> // ostringstream
+#include <string> // string
+
+/**
+    @brief Contatori globali della strumentazione (solo metodi statici)
+*/
+class Matrice3DStats {
+
+    /**
+        Contatori di un thread: li aggiorna solo il thread proprietario (load e store
+        relaxed, nessuna istruzione atomica read-modify-write), mentre snapshot() li
+        legge da qualsiasi thread. I blocchi dei thread vivi formano una lista
+        collegata; alla fine del thread i contatori passano nel totale dei terminati.
+        Nessuna allocazione dinamica.
+    */
+    struct Local {
+        std::atomic<std::uint64_t> v[m3dOpCount][3];
+        Local *next;
+        Local *prev;
+
+        Local() : next(nullptr), prev(nullptr) {
+            for (int o = 0; o < m3dOpCount; o++)
+                for (int k = 0; k < 3; k++)
+                    v[o][k].store(0, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            next = registry().head;
+            if (next)
+                next->prev = this;
+            registry().head = this;
+        }
+
+        ~Local() {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            for (int o = 0; o < m3dOpCount; o++)
+                for (int k = 0; k < 3; k++)
+                    registry().retired[o][k] += v[o][k].load(std::memory_order_relaxed);
+            if (prev)
+                prev->next = next;
+            else
+                registry().head = next;
+            if (next)
+                next->prev = prev;
+        }
+
+        void add(Matrice3DOp op, std::uint64_t bytes, std::uint64_t ns) {
+            std::atomic<std::uint64_t> *c = v[op];
+            c[0].store(c[0].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            c[1].store(c[1].load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+            c[2].store(c[2].load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        Local *head = nullptr;
+        std::uint64_t retired[m3dOpCount][3] = {}; ///< contatori dei thread terminati
+    };
+
+    static Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    static Local &local() {
+        // Il registro va costruito prima del blocco locale, cosi' viene distrutto dopo
+        registry();
+        static thread_local Local l;
+        return l;
+    }
+
+    public:
+
+    /**
+        Registra una chiamata dell'operazione op
+
+        @param op operazione
+        @param bytes byte trattati
+        @param ns durata in nanosecondi
+    */
+    static void record(Matrice3DOp op, std::uint64_t bytes, std::uint64_t ns = 0) {
+        local().add(op, bytes, ns);
+    }
+
+    /**
+        @return nome dell'operazione op (chiave nel JSON)
+    */
+    static const char *name(Matrice3DOp op) {
+        static const char *names[m3dOpCount] = {"alloc", "copy", "assign", "convert", "slice",
+                                                "fill", "equal", "trasform", "hash", "out_of_range"};
+        return names[op];
+    }
+
+    /**
+        Somma dei contatori di tutti i thread. Le operazioni in corso in altri thread
+        possono essere contate solo in parte.
+
+        @param out array di m3dOpCount contatori, indicizzato con Matrice3DOp
+    */
+    static void snapshot(Matrice3DOpStats out[m3dOpCount]) {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (int o = 0; o < m3dOpCount; o++) {
+            std::uint64_t t[3] = {r.retired[o][0], r.retired[o][1], r.retired[o][2]};
+            for (Local *l = r.head; l; l = l->next)
+                for (int k = 0; k < 3; k++)
+                    t[k] += l->v[o][k].load(std::memory_order_relaxed);
+            out[o].count = t[0];
+            out[o].bytes = t[1];
+            out[o].ns = t[2];
+        }
+    }
+
+    /**
+        @return contatori dell'operazione op sommati su tutti i thread
+    */
+    static Matrice3DOpStats get(Matrice3DOp op) {
+        Matrice3DOpStats s[m3dOpCount];
+        snapshot(s);
+        return s[op];
+    }
+
+    /**
+        Azzera i contatori. Va chiamato quando nessun altro thread sta usando le
+        matrici, altrimenti gli aggiornamenti concorrenti possono andare persi.
+    */
+    static void reset() {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (int o = 0; o < m3dOpCount; o++)
+            for (int k = 0; k < 3; k++) {
+                r.retired[o][k] = 0;
+                for (Local *l = r.head; l; l = l->next)
+                    l->v[o][k].store(0, std::memory_order_relaxed);
+            }
+    }
+
+    /**
+        Scrive su os i contatori aggregati in formato JSON: un oggetto con una chiave
+        per operazione e i campi count, bytes e ns.
+    */
+    static void json(std::ostream &os) {
+        Matrice3DOpStats s[m3dOpCount];
+        snapshot(s);
+        os << "{";
+        for (int o = 0; o < m3dOpCount; o++)
+            os << (o ? ", " : "") << "\"" << name(Matrice3DOp(o)) << "\": {\"count\": " << s[o].count
+               << ", \"bytes\": " << s[o].bytes << ", \"ns\": " << s[o].ns << "}";
+        os << "}";
+    }
+
+    /**
+        @return contatori aggregati in formato JSON
+    */
+    static std::string json() {
+        std::ostringstream os;
+        json(os);
+        return os.str();
+    }
+};
+
+/**
+    @brief Misura la durata di un blocco: registra l'operazione alla distruzione
+*/
+class Matrice3DStatsScope {
+    Matrice3DOp _op;
+    std::uint64_t _bytes;
+    std::chrono::steady_clock::time_point _start;
+
+    public:
+
+    Matrice3DStatsScope(Matrice3DOp op, std::uint64_t bytes) : _op(op), _bytes(bytes), _start(std::chrono::steady_clock::now()) {}
+
+    ~Matrice3DStatsScope() {
+        std::chrono::nanoseconds d = std::chrono::steady_clock::now() - _start;
+        Matrice3DStats::record(_op, _bytes, std::uint64_t(d.count()));
+    }
+
+    Matrice3DStatsScope(const Matrice3DStatsScope &) = delete;
+    Matrice3DStatsScope &operator=(const Matrice3DStatsScope &) = delete;
+};
+
+/// Misura il resto del blocco corrente come operazione op su bytes byte
+#define M3D_STATS_SCOPE(op, bytes) Matrice3DStatsScope m3dStatsScope_((op), std::uint64_t(bytes))
+/// Registra un evento istantaneo (senza tempo)
+#define M3D_STATS_EVENT(op, bytes) Matrice3DStats::record((op), std::uint64_t(bytes))
+
+#else
+
+#define M3D_STATS_SCOPE(op, bytes) ((void)0)
+#define M3D_STATS_EVENT(op, bytes) ((void)0)
+
+#endif
+
+#endif
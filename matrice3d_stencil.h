@@ -0,0 +1,633 @@
+#ifndef MATRICE3D_STENCIL_H
+#define MATRICE3D_STENCIL_H
+
+#include <cstddef> // size_t, ptrdiff_t
+#include <algorithm> // copy, fill, swap
+#include <vector> // pesi del kernel
+#include <memory> // unique_ptr
+#include "matrice3d.h" // Matrice3D, m3dForBlocks
+
+/**
+    @brief Condizioni al contorno degli stencil: valore dei vicini fuori dalla matrice
+
+    - m3dBoundaryZero: valgono T().
+    - m3dBoundaryClamp: valgono come l'elemento del bordo piu' vicino.
+    - m3dBoundaryWrap: la matrice e' periodica su tutti e tre gli assi.
+*/
+enum Matrice3DBoundary { m3dBoundaryZero, m3dBoundaryClamp, m3dBoundaryWrap };
+
+/**
+    @brief Classe Matrice3DKernel: pesi di una convoluzione 3D
+
+    Il kernel ha raggio (rz, ry, rx) e contiene (2rz+1) * (2ry+1) * (2rx+1) pesi,
+    indirizzati con gli spostamenti dal centro: K(dz, dy, dx) con -rz <= dz <= rz ecc.
+    I pesi si impostano con set(). Un kernel costruito con separable() e' il prodotto di tre kernel 1D e viene applicato
+    con tre passate 1D ((2rz+1) + (2ry+1) + (2rx+1) moltiplicazioni per elemento invece
+    del prodotto); impostare un peso lo rende un kernel generico.
+
+*/
+template <class T> class Matrice3DKernel
+{
+    int _rz; ///< raggio lungo z
+    int _ry; ///< raggio lungo y
+    int _rx; ///< raggio lungo x
+    std::vector<T> _weights; ///< pesi, ordinati per dz, dy, dx
+    std::vector<T> _factorZ; ///< fattore lungo z (solo se separabile)
+    std::vector<T> _factorY; ///< fattore lungo y (solo se separabile)
+    std::vector<T> _factorX; ///< fattore lungo x (solo se separabile)
+    bool _separable; ///< prodotto dei tre fattori
+
+    public:
+
+    /**
+        Costruttore: kernel di raggio (rz, ry, rx) con tutti i pesi a T()
+
+        @throw Matrice3DInvalidParameters possibile eccezione di raggio negativo
+    */
+    Matrice3DKernel(int rz, int ry, int rx) : _rz(rz), _ry(ry), _rx(rx), _separable(false) {
+        if (rz < 0 || ry < 0 || rx < 0)
+            throw Matrice3DInvalidParameters("ERRORE: Raggio del kernel negativo");
+        _weights.assign(std::size_t(2 * rz + 1) * (2 * ry + 1) * (2 * rx + 1), T());
+    }
+
+    /**
+        Kernel separabile: K(dz, dy, dx) = wz[rz + dz] * wy[ry + dy] * wx[rx + dx]
+
+        @param wz, wy, wx pesi 1D, ognuno di lunghezza dispari (2r + 1)
+
+        @throw Matrice3DInvalidParameters possibile eccezione di lunghezza pari
+    */
+    static Matrice3DKernel separable(const std::vector<T> &wz, const std::vector<T> &wy, const std::vector<T> &wx) {
+        if (wz.size() % 2 == 0 || wy.size() % 2 == 0 || wx.size() % 2 == 0)
+            throw Matrice3DInvalidParameters("ERRORE: I pesi 1D devono avere lunghezza dispari");
+        Matrice3DKernel k((int)wz.size() / 2, (int)wy.size() / 2, (int)wx.size() / 2);
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < wz.size(); i++)
+            for (std::size_t j = 0; j < wy.size(); j++)
+                for (std::size_t l = 0; l < wx.size(); l++)
+                    k._weights[n++] = wz[i] * wy[j] * wx[l];
+        k._factorZ = wz;
+        k._factorY = wy;
+        k._factorX = wx;
+        k._separable = true;
+        return k;
+    }
+
+    /**
+        Laplaciano a 7 punti: -6 al centro, 1 sulle sei facce
+    */
+    static Matrice3DKernel laplacian() {
+        Matrice3DKernel k(1, 1, 1);
+        k.set(0, 0, 0, T(-6));
+        for (int d = -1; d <= 1; d += 2) {
+            k.set(d, 0, 0, T(1));
+            k.set(0, d, 0, T(1));
+            k.set(0, 0, d, T(1));
+        }
+        return k;
+    }
+
+    int radiusZ() const { return _rz; } ///< raggio lungo z
+    int radiusY() const { return _ry; } ///< raggio lungo y
+    int radiusX() const { return _rx; } ///< raggio lungo x
+
+    /**
+        @return true se il kernel e' il prodotto dei fattori factorZ(), factorY(), factorX()
+    */
+    bool isSeparable() const { return _separable; }
+
+    const std::vector<T> &factorZ() const { return _factorZ; } ///< fattore lungo z
+    const std::vector<T> &factorY() const { return _factorY; } ///< fattore lungo y
+    const std::vector<T> &factorX() const { return _factorX; } ///< fattore lungo x
+
+    /**
+        Operatore (): peso nella posizione (dz, dy, dx) rispetto al centro
+
+        @throw Matrice3DOutOfRange possibile eccezione di posizione fuori dal kernel
+    */
+    const T &operator()(int dz, int dy, int dx) const {
+        return _weights[index(dz, dy, dx)];
+    }
+
+    /**
+        Metodo set: imposta il peso nella posizione (dz, dy, dx). Il kernel smette di
+        essere separabile.
+
+        @throw Matrice3DOutOfRange possibile eccezione di posizione fuori dal kernel
+    */
+    void set(int dz, int dy, int dx, const T &weight) {
+        _weights[index(dz, dy, dx)] = weight;
+        _separable = false;
+    }
+
+    private:
+
+    std::size_t index(int dz, int dy, int dx) const {
+        if (dz < -_rz || dz > _rz || dy < -_ry || dy > _ry || dx < -_rx || dx > _rx)
+            throw Matrice3DOutOfRange("ERRORE: Posizione fuori dal kernel");
+        return (std::size_t(dz + _rz) * (2 * _ry + 1) + (dy + _ry)) * (2 * _rx + 1) + (dx + _rx);
+    }
+};
+
+/**
+    @brief Vicinato di un elemento, passato ai funtori di stencil()
+
+    N(dz, dy, dx) e' il valore del vicino (z + dz, y + dy, x + dx), con la condizione al
+    contorno gia' applicata; gli spostamenti non devono superare il raggio dello stencil.
+*/
+template <class T> class Matrice3DNeighborhood
+{
+    const T *_center; ///< elemento centrale
+    std::ptrdiff_t _strideZ; ///< distanza tra due piani
+    std::ptrdiff_t _strideY; ///< distanza tra due righe
+    unsigned int _z, _y, _x; ///< coordinate del centro
+
+    public:
+
+    Matrice3DNeighborhood(const T *center, std::ptrdiff_t sz, std::ptrdiff_t sy, unsigned int z, unsigned int y, unsigned int x)
+        : _center(center), _strideZ(sz), _strideY(sy), _z(z), _y(y), _x(x) {}
+
+    const T &operator()(int dz, int dy, int dx) const {
+        return _center[dz * _strideZ + dy * _strideY + dx];
+    }
+
+    unsigned int z() const { return _z; } ///< coordinata z del centro
+    unsigned int y() const { return _y; } ///< coordinata y del centro
+    unsigned int x() const { return _x; } ///< coordinata x del centro
+};
+
+/**
+    @brief Classe Matrice3DStencil: motore degli stencil e delle convoluzioni
+
+    La matrice viene divisa in tile (blocchi di piani z e di righe y, con le righe x
+    intere) dimensionati per restare in cache. Ogni tile viene copiato, con un bordo
+    (halo) sufficiente per tutte le iterazioni, in un buffer con le righe allungate di
+    rx elementi per lato: qui la condizione al contorno diventa semplice memoria e i
+    cicli interni lavorano su righe contigue senza controlli di coordinate.
+
+    Con piu' iterazioni (steps > 1) il tile esegue tutte le iterazioni in cache prima di
+    scrivere il risultato (blocking temporale): a ogni iterazione la zona valida del buffer
+    si restringe di un raggio verso l'interno, quindi l'halo e' largo steps * r e il
+    lavoro sul bordo viene ripetuto dai tile vicini, in cambio di una sola lettura e una
+    sola scrittura della matrice. Sui bordi della matrice (Zero e Clamp) l'halo viene
+    invece rigenerato a ogni iterazione e la zona valida non si restringe.
+
+    I tile sono indipendenti e vengono distribuiti sul pool con m3dForBlocks().
+
+    Un'operazione (Op) applica una o piu' passate per iterazione e fornisce:
+    - unsigned int passes(): passate per iterazione
+    - int radiusZ(p), radiusY(p): raggio della passata p lungo z e y (al massimo quello
+      del motore; lungo x ogni passata puo' usare fino a rx)
+    - void row(p, T *out, const T *in, n, z, y): calcola n elementi della riga (z, y),
+      con in che punta al primo elemento della riga nel buffer (strideZ(), strideY())
+
+*/
+template <class T> class Matrice3DStencil
+{
+    /// Intervallo di slot del buffer lungo z o y
+    struct Axis {
+        long start; ///< coordinata dello slot 0
+        long n; ///< slot del buffer
+        long d0, d1; ///< slot delle coordinate dentro la matrice [d0, d1)
+        long lo, hi; ///< slot validi per la prossima passata [lo, hi)
+    };
+
+    unsigned int _sizeZ, _sizeY, _sizeX; ///< dimensioni della matrice
+    int _rz, _ry, _rx; ///< raggio massimo delle passate
+    unsigned int _steps; ///< iterazioni
+    Matrice3DBoundary _boundary; ///< condizione al contorno
+    long _haloZ, _haloY; ///< bordo del tile nel buffer: (steps + 1) * raggio
+    unsigned int _tileZ, _tileY; ///< dimensioni di un tile
+    unsigned int _tilesZ, _tilesY; ///< numero di tile lungo z e y
+    std::size_t _pitch; ///< distanza tra due righe del buffer (sizeX + 2 rx)
+    std::size_t _plane; ///< distanza tra due piani del buffer
+
+    public:
+
+    /**
+        Costruttore: prepara i tile per una matrice z * y * x
+
+        @param rz, ry, rx raggio dello stencil
+        @param steps iterazioni (almeno 1)
+        @param cache dimensione massima in byte di un buffer di tile
+
+        @throw Matrice3DInvalidParameters possibile eccezione di raggio negativo
+    */
+    Matrice3DStencil(unsigned int z, unsigned int y, unsigned int x, int rz, int ry, int rx,
+                     unsigned int steps, Matrice3DBoundary boundary, std::size_t cache = std::size_t(1) << 20)
+        : _sizeZ(z), _sizeY(y), _sizeX(x), _rz(rz), _ry(ry), _rx(rx), _steps(steps), _boundary(boundary) {
+        if (rz < 0 || ry < 0 || rx < 0)
+            throw Matrice3DInvalidParameters("ERRORE: Raggio dello stencil negativo");
+        if (_steps == 0)
+            _steps = 1;
+        _haloZ = long(_steps + 1) * rz;
+        _haloY = long(_steps + 1) * ry;
+        _pitch = std::size_t(x) + 2 * rx;
+        // Tile il piu' grandi possibile entro la cache, ma non piu' piccoli di 4 volte
+        // l'halo (oltre il lavoro ripetuto sul bordo supererebbe quello utile)
+        unsigned int minZ = (unsigned int)std::min<long>(z, std::max<long>(4 * _haloZ, 1));
+        unsigned int minY = (unsigned int)std::min<long>(y, std::max<long>(4 * _haloY, 1));
+        _tileZ = z;
+        _tileY = y;
+        while (bytes(_tileZ, _tileY) > cache && (_tileZ > minZ || _tileY > minY)) {
+            if (_tileY > minY && (_tileY >= _tileZ || _tileZ <= minZ))
+                _tileY = std::max(minY, (_tileY + 1) / 2);
+            else
+                _tileZ = std::max(minZ, (_tileZ + 1) / 2);
+        }
+        _tilesZ = z == 0 ? 0 : (z + _tileZ - 1) / _tileZ;
+        _tilesY = y == 0 ? 0 : (y + _tileY - 1) / _tileY;
+        _plane = std::size_t(_tileY + 2 * _haloY) * _pitch;
+    }
+
+    std::size_t tiles() const { return std::size_t(_tilesZ) * _tilesY; } ///< numero di tile
+    unsigned int tileZ() const { return _tileZ; } ///< piani di un tile
+    unsigned int tileY() const { return _tileY; } ///< righe di un tile
+    std::ptrdiff_t strideZ() const { return (std::ptrdiff_t)_plane; } ///< distanza tra due piani del buffer
+    std::ptrdiff_t strideY() const { return (std::ptrdiff_t)_pitch; } ///< distanza tra due righe del buffer
+
+    /**
+        Applica op ai tile [b, e) di A e scrive il risultato in out (row-major, con
+        gli stride indicati). Puo' essere chiamato in parallelo su tile diversi.
+    */
+    template <class M, class Op>
+    void run(const M &A, Op &op, T *out, std::size_t outStrideZ, std::size_t outStrideY, std::size_t b, std::size_t e) const {
+        // Ogni slot letto viene prima scritto: i buffer non vanno inizializzati
+        std::size_t size = std::size_t(_tileZ + 2 * _haloZ) * _plane;
+        std::unique_ptr<T[]> src(new T[size]), dst(new T[size]);
+        for (std::size_t t = b; t < e; t++) {
+            unsigned int z0 = (unsigned int)(t / _tilesY) * _tileZ, y0 = (unsigned int)(t % _tilesY) * _tileY;
+            unsigned int nz = std::min(_tileZ, _sizeZ - z0), ny = std::min(_tileY, _sizeY - y0);
+            Axis az = axis(z0, nz, _sizeZ, _haloZ, _rz), ay = axis(y0, ny, _sizeY, _haloY, _ry);
+            long oz = long(z0) - az.start, oy = long(y0) - ay.start; // slot della prima riga del tile
+            load(A, src.get(), az, ay);
+            T *s = src.get(), *d = dst.get();
+            for (unsigned int step = 0; step < _steps; step++)
+                for (unsigned int p = 0; p < op.passes(); p++) {
+                    Axis cz = shrink(az, op.radiusZ(p)), cy = shrink(ay, op.radiusY(p));
+                    if (step + 1 == _steps && p + 1 == op.passes()) {
+                        // Ultima passata: solo le righe del tile, direttamente nel risultato
+                        assert(cz.lo <= oz && oz + nz <= cz.hi && cy.lo <= oy && oy + ny <= cy.hi);
+                        for (unsigned int i = 0; i < nz; i++)
+                            for (unsigned int j = 0; j < ny; j++)
+                                op.row(p, out + (z0 + i) * outStrideZ + (y0 + j) * outStrideY,
+                                       s + row(oz + i, oy + j), _sizeX, z0 + i, y0 + j);
+                        break;
+                    }
+                    for (long i = cz.lo; i < cz.hi; i++)
+                        for (long j = cy.lo; j < cy.hi; j++) {
+                            T *o = d + row(i, j);
+                            op.row(p, o, s + row(i, j), _sizeX, coordinate(az.start + i, _sizeZ), coordinate(ay.start + j, _sizeY));
+                            halo(o);
+                        }
+                    ghosts(d, cz, cy);
+                    std::swap(s, d);
+                    az = cz;
+                    ay = cy;
+                }
+        }
+    }
+
+    private:
+
+    std::size_t bytes(unsigned int z, unsigned int y) const {
+        return std::size_t(z + 2 * _haloZ) * (y + 2 * _haloY) * _pitch * sizeof(T);
+    }
+
+    /// Posizione del primo elemento della riga (i, j) nel buffer
+    std::size_t row(long i, long j) const { return std::size_t(i) * _plane + std::size_t(j) * _pitch + _rx; }
+
+    /// Coordinata della matrice corrispondente a c (solo Wrap puo' uscire dalla matrice)
+    unsigned int coordinate(long c, unsigned int size) const {
+        return (unsigned int)(((c % (long)size) + size) % size);
+    }
+
+    /**
+        Slot di un tile di n coordinate da c0, con halo slot per lato. Fuori dalla
+        matrice (Zero e Clamp) bastano r slot, rigenerati a ogni passata.
+    */
+    Axis axis(unsigned int c0, unsigned int n, unsigned int size, long halo, long r) const {
+        Axis a;
+        if (_boundary == m3dBoundaryWrap) {
+            // Ogni slot e' dentro la matrice periodica: non ci sono bordi
+            a.start = long(c0) - halo;
+            a.n = long(n) + 2 * halo;
+            a.d0 = 0;
+            a.d1 = a.n;
+        }
+        else {
+            a.start = std::max(long(c0) - halo, -r);
+            a.n = std::min(long(c0) + long(n) + halo, long(size) + r) - a.start;
+            a.d0 = -a.start;
+            a.d1 = long(size) - a.start;
+        }
+        a.lo = std::max(a.d0, 0L);
+        a.hi = std::min(a.d1, a.n);
+        return a;
+    }
+
+    /**
+        Slot validi dopo una passata di raggio q: sul bordo della matrice, se gli slot
+        esterni bastano, restano fermi (l'halo viene rigenerato), altrimenti si
+        restringono di q.
+    */
+    static Axis shrink(Axis a, int q) {
+        if (a.lo != a.d0 || a.d0 < q)
+            a.lo += q;
+        if (a.hi != a.d1 || a.n - a.d1 < q)
+            a.hi -= q;
+        return a;
+    }
+
+    /// Copia le righe del tile (halo compreso) nel buffer
+    template <class M>
+    void load(const M &A, T *buf, const Axis &az, const Axis &ay) const {
+        for (long i = 0; i < az.n; i++) {
+            long z = az.start + i;
+            for (long j = 0; j < ay.n; j++) {
+                long y = ay.start + j;
+                T *o = buf + row(i, j);
+                bool outside = z < 0 || z >= long(_sizeZ) || y < 0 || y >= long(_sizeY);
+                if (outside && _boundary == m3dBoundaryZero) {
+                    std::fill(o - _rx, o + _sizeX + _rx, T());
+                    continue;
+                }
+                unsigned int cz = clamp(z, _sizeZ), cy = clamp(y, _sizeY);
+                if constexpr (M::layout_type::contiguous) {
+                    const T *r = A.data() + std::size_t(cz) * A.strideZ() + std::size_t(cy) * A.strideY();
+                    std::copy(r, r + _sizeX, o);
+                }
+                else
+                    for (unsigned int x = 0; x < _sizeX; x++)
+                        o[x] = A.at_unchecked(cz, cy, x);
+                halo(o);
+            }
+        }
+    }
+
+    /// Coordinata da leggere per c secondo la condizione al contorno (Clamp o Wrap)
+    unsigned int clamp(long c, unsigned int size) const {
+        if (_boundary == m3dBoundaryWrap)
+            return coordinate(c, size);
+        return c < 0 ? 0 : (c >= long(size) ? size - 1 : (unsigned int)c);
+    }
+
+    /// Riempie gli rx elementi per lato fuori dalla riga
+    void halo(T *o) const {
+        for (long k = 1; k <= _rx; k++) {
+            switch (_boundary) {
+            case m3dBoundaryZero:
+                o[-k] = o[_sizeX - 1 + k] = T();
+                break;
+            case m3dBoundaryClamp:
+                o[-k] = o[0];
+                o[_sizeX - 1 + k] = o[_sizeX - 1];
+                break;
+            case m3dBoundaryWrap:
+                o[-k] = o[coordinate(-k, _sizeX)];
+                o[_sizeX - 1 + k] = o[coordinate(_sizeX - 1 + k, _sizeX)];
+                break;
+            }
+        }
+    }
+
+    /// Riga esterna: zero, oppure copia (halo compreso) della riga di bordo
+    void ghost(T *o, const T *edge) const {
+        if (_boundary == m3dBoundaryZero)
+            std::fill(o - _rx, o + _sizeX + _rx, T());
+        else
+            std::copy(edge - _rx, edge + _sizeX + _rx, o - _rx);
+    }
+
+    /// Rigenera le righe e i piani fuori dalla matrice adiacenti agli slot validi
+    void ghosts(T *buf, const Axis &az, const Axis &ay) const {
+        long ylo = ay.lo, yhi = ay.hi;
+        if (ay.lo == ay.d0)
+            ylo = std::max(0L, ay.d0 - _ry);
+        if (ay.hi == ay.d1)
+            yhi = std::min(ay.n, ay.d1 + _ry);
+        for (long i = az.lo; i < az.hi; i++) {
+            for (long j = ylo; j < ay.lo; j++)
+                ghost(buf + row(i, j), buf + row(i, ay.lo));
+            for (long j = ay.hi; j < yhi; j++)
+                ghost(buf + row(i, j), buf + row(i, ay.hi - 1));
+        }
+        if (az.lo == az.d0)
+            for (long i = std::max(0L, az.d0 - _rz); i < az.lo; i++)
+                for (long j = ylo; j < yhi; j++)
+                    ghost(buf + row(i, j), buf + row(az.lo, j));
+        if (az.hi == az.d1)
+            for (long i = az.hi; i < std::min(az.n, az.d1 + _rz); i++)
+                for (long j = ylo; j < yhi; j++)
+                    ghost(buf + row(i, j), buf + row(az.hi - 1, j));
+    }
+};
+
+/**
+    @brief Operazione di Matrice3DStencil per i kernel di pesi
+
+    Un kernel generico e' una passata con un termine per ogni peso non nullo; un kernel
+    separabile sono tre passate 1D (x, y, z). Ogni termine scorre l'intera riga, cosi'
+    il ciclo interno e' un prodotto-somma su elementi contigui.
+*/
+template <class T> class m3dKernelRows
+{
+    /// Termine della somma: peso e distanza del vicino nel buffer
+    struct Tap {
+        std::ptrdiff_t offset;
+        T weight;
+    };
+
+    std::vector<Tap> _taps[3]; ///< termini di ogni passata
+    int _radiusZ[3], _radiusY[3]; ///< raggio di ogni passata
+    unsigned int _passes; ///< passate per iterazione
+
+    public:
+
+    m3dKernelRows(const Matrice3DKernel<T> &k, std::ptrdiff_t sz, std::ptrdiff_t sy) {
+        int rz = k.radiusZ(), ry = k.radiusY(), rx = k.radiusX();
+        if (k.isSeparable()) {
+            _passes = 3;
+            for (int d = -rx; d <= rx; d++)
+                add(0, d, k.factorX()[rx + d]);
+            for (int d = -ry; d <= ry; d++)
+                add(1, d * sy, k.factorY()[ry + d]);
+            for (int d = -rz; d <= rz; d++)
+                add(2, d * sz, k.factorZ()[rz + d]);
+            _radiusZ[0] = _radiusY[0] = _radiusZ[1] = _radiusY[2] = 0;
+            _radiusY[1] = ry;
+            _radiusZ[2] = rz;
+        }
+        else {
+            _passes = 1;
+            for (int dz = -rz; dz <= rz; dz++)
+                for (int dy = -ry; dy <= ry; dy++)
+                    for (int dx = -rx; dx <= rx; dx++)
+                        add(0, dz * sz + dy * sy + dx, k(dz, dy, dx));
+            _radiusZ[0] = rz;
+            _radiusY[0] = ry;
+        }
+    }
+
+    unsigned int passes() const { return _passes; }
+    int radiusZ(unsigned int p) const { return _radiusZ[p]; }
+    int radiusY(unsigned int p) const { return _radiusY[p]; }
+
+    void row(unsigned int p, T *out, const T *in, unsigned int n, unsigned int, unsigned int) const {
+        const std::vector<Tap> &taps = _taps[p];
+        if (taps.empty()) {
+            std::fill(out, out + n, T());
+            return;
+        }
+        const T *v = in + taps[0].offset;
+        T w = taps[0].weight;
+        for (unsigned int i = 0; i < n; i++)
+            out[i] = w * v[i];
+        for (std::size_t t = 1; t < taps.size(); t++) {
+            v = in + taps[t].offset;
+            w = taps[t].weight;
+            for (unsigned int i = 0; i < n; i++)
+                out[i] += w * v[i];
+        }
+    }
+
+    private:
+
+    void add(unsigned int p, std::ptrdiff_t offset, const T &weight) {
+        if (weight == T())
+            return;
+        Tap t;
+        t.offset = offset;
+        t.weight = weight;
+        _taps[p].push_back(t);
+    }
+};
+
+/**
+    @brief Operazione di Matrice3DStencil per gli stencil con funtore: una passata che
+           chiama f(Matrice3DNeighborhood) per ogni elemento
+*/
+template <class T, class F> class m3dFunctorRows
+{
+    F &_f; ///< funtore dello stencil
+    int _radius; ///< raggio dello stencil
+    std::ptrdiff_t _strideZ, _strideY; ///< stride del buffer
+
+    public:
+
+    m3dFunctorRows(F &f, int radius, std::ptrdiff_t sz, std::ptrdiff_t sy) : _f(f), _radius(radius), _strideZ(sz), _strideY(sy) {}
+
+    unsigned int passes() const { return 1; }
+    int radiusZ(unsigned int) const { return _radius; }
+    int radiusY(unsigned int) const { return _radius; }
+
+    void row(unsigned int, T *out, const T *in, unsigned int n, unsigned int z, unsigned int y) {
+        for (unsigned int i = 0; i < n; i++)
+            out[i] = static_cast<T>(_f(Matrice3DNeighborhood<T>(in + i, _strideZ, _strideY, z, y, i)));
+    }
+};
+
+/**
+    Esegue op sui tile di A secondo la politica e ritorna il risultato
+*/
+template <class T, class Cmp, class M, class Op, class Policy>
+Matrice3D<T, Cmp> m3dStencilRun(const M &A, const Matrice3DStencil<T> &engine, Op &op, const Policy &policy) {
+    Matrice3D<T, Cmp> B(A.sizeZ(), A.sizeY(), A.sizeX());
+    T *out = B.data();
+    std::size_t sz = B.strideZ(), sy = B.strideY();
+    m3dForBlocks(policy, engine.tiles(), 1, [&](std::size_t b, std::size_t e) {
+        engine.run(A, op, out, sz, sy, b, e);
+    });
+    return B;
+}
+
+/**
+    Metodo GLOBALE convolve: applica steps volte il kernel K alla Matrice3D A
+    B(z,y,x) = somma di K(dz,dy,dx) * A(z+dz, y+dy, x+dx), con i vicini fuori dalla
+    matrice dati dalla condizione al contorno. Le iterazioni vengono eseguite a tile in
+    cache (vedi Matrice3DStencil); i kernel separabili usano tre passate 1D.
+
+    @param A Matrice3D, K kernel, boundary condizione al contorno, steps iterazioni
+
+    @return Matrice3D con il kernel applicato (copia di A se steps == 0)
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T, Cmp> convolve(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Matrice3DKernel<T> &K,
+                           Matrice3DBoundary boundary = m3dBoundaryZero, unsigned int steps = 1) {
+    return convolve(A, K, boundary, steps, m3dSeq);
+}
+
+/**
+    Metodo GLOBALE convolve con politica di esecuzione sequenziale: equivale a convolve(A, K, boundary, steps).
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T, Cmp> convolve(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Matrice3DKernel<T> &K,
+                           Matrice3DBoundary boundary, unsigned int steps, const m3dSeqPolicy &policy) {
+    if (A.size() == 0 || steps == 0)
+        return Matrice3D<T, Cmp>(A);
+    Matrice3DStencil<T> engine(A.sizeZ(), A.sizeY(), A.sizeX(), K.radiusZ(), K.radiusY(), K.radiusX(), steps, boundary);
+    m3dKernelRows<T> op(K, engine.strideZ(), engine.strideY());
+    return m3dStencilRun<T, Cmp>(A, engine, op, policy);
+}
+
+/**
+    Metodo GLOBALE convolve con politica di esecuzione parallela: i tile vengono
+    distribuiti sul pool. Il risultato e' identico a quello di convolve(A, K, boundary, steps).
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout>
+Matrice3D<T, Cmp> convolve(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, const Matrice3DKernel<T> &K,
+                           Matrice3DBoundary boundary, unsigned int steps, const m3dParPolicy &policy) {
+    if (A.size() == 0 || steps == 0)
+        return Matrice3D<T, Cmp>(A);
+    Matrice3DStencil<T> engine(A.sizeZ(), A.sizeY(), A.sizeX(), K.radiusZ(), K.radiusY(), K.radiusX(), steps, boundary);
+    m3dKernelRows<T> op(K, engine.strideZ(), engine.strideY());
+    return m3dStencilRun<T, Cmp>(A, engine, op, policy);
+}
+
+/**
+    Metodo GLOBALE stencil: applica steps volte lo stencil f di raggio radius alla
+    Matrice3D A: B(z,y,x) = f(N), con N il vicinato di (z,y,x) (Matrice3DNeighborhood,
+    N(dz,dy,dx) con |dz|,|dy|,|dx| <= radius). Es. uno stencil a 27 punti:
+    stencil(A, 1, [](const Matrice3DNeighborhood<float> &n) { ... n(-1,-1,-1) ... })
+
+    @param A Matrice3D, radius raggio, f funtore, boundary condizione al contorno, steps iterazioni
+
+    @return Matrice3D con lo stencil applicato (copia di A se steps == 0)
+
+    @throw Matrice3DInvalidParameters possibile eccezione di raggio negativo
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout, class F>
+Matrice3D<T, Cmp> stencil(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, int radius, F f,
+                          Matrice3DBoundary boundary = m3dBoundaryZero, unsigned int steps = 1) {
+    return stencil(A, radius, f, boundary, steps, m3dSeq);
+}
+
+/**
+    Metodo GLOBALE stencil con politica di esecuzione sequenziale: equivale a stencil(A, radius, f, boundary, steps).
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout, class F>
+Matrice3D<T, Cmp> stencil(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, int radius, F f,
+                          Matrice3DBoundary boundary, unsigned int steps, const m3dSeqPolicy &policy) {
+    if (A.size() == 0 || steps == 0)
+        return Matrice3D<T, Cmp>(A);
+    Matrice3DStencil<T> engine(A.sizeZ(), A.sizeY(), A.sizeX(), radius, radius, radius, steps, boundary);
+    m3dFunctorRows<T, F> op(f, radius, engine.strideZ(), engine.strideY());
+    return m3dStencilRun<T, Cmp>(A, engine, op, policy);
+}
+
+/**
+    Metodo GLOBALE stencil con politica di esecuzione parallela: i tile vengono
+    distribuiti sul pool. Il funtore viene chiamato da piu' thread contemporaneamente,
+    quindi non deve modificare uno stato condiviso.
+*/
+template <class T, class Cmp, class Check, class Alloc, class Layout, class F>
+Matrice3D<T, Cmp> stencil(const Matrice3D<T, Cmp, Check, Alloc, Layout> &A, int radius, F f,
+                          Matrice3DBoundary boundary, unsigned int steps, const m3dParPolicy &policy) {
+    if (A.size() == 0 || steps == 0)
+        return Matrice3D<T, Cmp>(A);
+    Matrice3DStencil<T> engine(A.sizeZ(), A.sizeY(), A.sizeX(), radius, radius, radius, steps, boundary);
+    m3dFunctorRows<T, F> op(f, radius, engine.strideZ(), engine.strideY());
+    return m3dStencilRun<T, Cmp>(A, engine, op, policy);
+}
+
+#endif
@@ -0,0 +1,517 @@
+#ifndef MATRICE3D_STREAM_H
+#define MATRICE3D_STREAM_H
+
+#include <cstddef> // size_t
+#include <fstream> // fstream
+#include <future> // async, future
+#include <mutex> // mutex, lock_guard
+#include <string> // string
+#include <vector> // slot della cache
+#include "matrice3d.h" // Matrice3D, save/load (formato su file)
+
+/**
+    @brief Classe Matrice3DStream: Matrice3D su disco per volumi piu' grandi della RAM
+
+    Gli elementi stanno in un file nel formato binario di matrice3d_io.h (row-major),
+    quindi lo stesso file si puo' usare con load() e load_mapped(). In memoria vengono
+    tenuti solo alcuni slab (blocchi di piani z consecutivi) in una cache LRU con
+    budget di memoria fisso: quando serve uno slab non presente viene letto dal disco,
+    eventualmente scartando quello usato meno di recente (e riscrivendolo se modificato).
+
+    Quando l'accesso passa allo slab successivo (scansione in ordine z) lo slab ancora
+    dopo viene letto in anticipo da un thread in background, sovrapponendo lettura e
+    calcolo. Il thread di prefetch usa uno degli slot della cache, quindi la memoria
+    resta entro il budget.
+
+    L'operatore () non costante e gli iteratori non costanti ritornano un
+    Matrice3DElementRef: uno slab viene segnato come modificato (e riscritto sul file)
+    solo se un suo elemento viene assegnato, non quando viene letto. I riferimenti
+    const T& ritornati dalla versione costante restano validi solo fino al prossimo
+    accesso a un altro slab. La classe non e' thread-safe.
+
+*/
+template <class T> class Matrice3DStream
+{
+    static_assert(std::is_arithmetic<T>::value, "Matrice3DStream: servono elementi di tipo aritmetico");
+
+    template <class> friend class Matrice3DElementRef;
+
+    /// Slot della cache: contiene uno slab
+    struct Slot {
+        T *data; ///< elementi dello slab
+        long index; ///< slab contenuto (-1 se vuoto)
+        bool dirty; ///< modificato rispetto al file
+        unsigned long stamp; ///< ultimo utilizzo (per l'LRU)
+    };
+
+    mutable std::fstream _file; ///< file con gli elementi
+    mutable std::mutex _io; ///< serializza gli accessi al file (prefetch compreso)
+    std::uint64_t _dataOffset; ///< posizione degli elementi nel file
+    unsigned int _sizeX; ///< dimensione X
+    unsigned int _sizeY; ///< dimensione Y
+    unsigned int _sizeZ; ///< dimensione Z
+    std::size_t _plane; ///< elementi di un piano
+    unsigned int _depth; ///< piani per slab
+    unsigned int _slabs; ///< numero di slab
+    std::size_t _budget; ///< memoria massima per la cache (byte)
+    mutable std::vector<Slot> _slots; ///< cache degli slab
+    mutable std::vector<int> _slotOf; ///< slot di ogni slab (-1 se non in cache)
+    mutable unsigned long _clock; ///< contatore per l'LRU
+    mutable long _last; ///< ultimo slab usato (accesso veloce)
+    mutable int _lastSlot; ///< slot dell'ultimo slab usato
+    mutable int _pending; ///< slot in lettura in background (-1 se nessuno)
+    mutable std::future<void> _prefetch; ///< lettura in background
+    mutable unsigned long _loads; ///< slab letti dal disco
+    mutable unsigned long _writes; ///< slab riscritti sul disco
+
+    public:
+
+    typedef T value_type; ///< tipo degli elementi
+    typedef Matrice3DElementRef<Matrice3DStream> reference; ///< riferimento in lettura e scrittura
+
+    /**
+        Costruttore: crea il file di una nuova Matrice3DStream z * y * x con tutti gli
+        elementi a 0 (il file viene esteso senza scriverlo, se il filesystem lo consente).
+
+        @param file percorso del file (sovrascritto se esiste)
+        @param z, y, x dimensioni
+        @param budget memoria massima della cache in byte
+        @param depth piani per slab (0: scelto in modo da avere 4 slab nel budget)
+
+        @throw Matrice3DOutOfRange possibile eccezione di dimensione non valida
+        @throw Matrice3DInvalidParameters se nel budget non stanno almeno 2 slab
+        @throw Matrice3DError possibile eccezione di scrittura del file fallita
+    */
+    Matrice3DStream(const std::string &file, int z, int y, int x, std::size_t budget, unsigned int depth = 0) {
+        if (z <= 0 || y <= 0 || x <= 0)
+            throw Matrice3DOutOfRange("ERRORE: Indici fuori dai limiti della matrice");
+        Matrice3DFileHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "M3DF", 4);
+        h.byteOrder = Matrice3DFileHeader::nativeOrder;
+        h.version = Matrice3DFileHeader::currentVersion;
+        h.type = m3dTypeCode<T>();
+        h.typeSize = sizeof(T);
+        h.sizeZ = z;
+        h.sizeY = y;
+        h.sizeX = x;
+        h.count = std::uint64_t(z) * y * x;
+        h.dataOffset = sizeof(h);
+        {
+            std::ofstream out(file.c_str(), std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            // Scrivo solo l'ultimo byte: il resto del file vale 0
+            out.seekp(std::streamoff(h.dataOffset + h.count * sizeof(T) - 1));
+            out.put(0);
+            out.close();
+            if (!out)
+                throw Matrice3DError("ERRORE: Scrittura del file fallita");
+        }
+        open(file, h, budget, depth);
+    }
+
+    /**
+        Costruttore: apre una Matrice3DStream su un file esistente (scritto da save()
+        con layout row-major o da un'altra Matrice3DStream).
+
+        @param file percorso del file
+        @param budget memoria massima della cache in byte
+        @param depth piani per slab (0: scelto in modo da avere 4 slab nel budget)
+
+        @throw Matrice3DInvalidParameters se nel budget non stanno almeno 2 slab
+        @throw Matrice3DError possibile eccezione di file non compatibile
+    */
+    Matrice3DStream(const std::string &file, std::size_t budget, unsigned int depth = 0) {
+        Matrice3DFileHeader h;
+        std::ifstream in(file.c_str(), std::ios::binary);
+        if (!in)
+            throw Matrice3DError("ERRORE: Impossibile aprire il file");
+        if (m3dReadHeader<Matrice3D<T> >(in, h))
+            throw Matrice3DError("ERRORE: Il file ha un ordine dei byte diverso: usare load()");
+        if (h.count == 0)
+            throw Matrice3DError("ERRORE: Il file contiene una matrice vuota");
+        in.close();
+        open(file, h, budget, depth);
+    }
+
+    /**
+        Distruttore: attende il prefetch, riscrive gli slab modificati e libera la cache
+    */
+    ~Matrice3DStream() {
+        try {
+            flush();
+        }
+        catch (...) {
+            std::cerr << "ERRORE: Scrittura degli slab modificati fallita." << std::endl;
+        }
+        for (std::size_t i = 0; i < _slots.size(); i++)
+            if (_slots[i].data != nullptr)
+                alignedAllocator<T>().deallocate(_slots[i].data, slab_elements());
+    }
+
+    Matrice3DStream(const Matrice3DStream &) = delete;
+    Matrice3DStream &operator=(const Matrice3DStream &) = delete;
+
+    unsigned int sizeX() const { return _sizeX; } ///< dimensione X
+    unsigned int sizeY() const { return _sizeY; } ///< dimensione Y
+    unsigned int sizeZ() const { return _sizeZ; } ///< dimensione Z
+    std::size_t size() const { return _plane * _sizeZ; } ///< dimensione totale
+    unsigned int depth() const { return _depth; } ///< piani per slab
+    std::size_t budget() const { return _budget; } ///< budget di memoria della cache (byte)
+    unsigned int slots() const { return (unsigned int)_slots.size(); } ///< slab nella cache
+    std::size_t memory() const { return _slots.size() * slab_elements() * sizeof(T); } ///< memoria della cache (byte)
+    unsigned long loads() const { return _loads; } ///< slab letti dal disco
+    unsigned long writes() const { return _writes; } ///< slab riscritti sul disco
+
+    /**
+        Operatore (): Ritorna il riferimento all'elemento (z, y, x), in lettura e scrittura.
+        Lo slab che lo contiene viene caricato a ogni uso del riferimento se necessario, e
+        segnato come modificato solo quando l'elemento viene assegnato.
+
+        @return Riferimento all'elemento (z, y, x)
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide
+    */
+    reference operator()(int z, int y, int x) {
+        check(z, y, x);
+        return reference(this, std::size_t(z) * _plane + std::size_t(y) * _sizeX + x);
+    }
+
+    /**
+        Operatore (): Ritorna il valore delle coordinate (z, y, x) in sola lettura
+
+        @return Valore delle coordinate (z, y, x), valido fino all'accesso a un altro slab
+
+        @throw Matrice3DOutOfRange possibile eccezione di coordinate non valide
+    */
+    const T& operator()(int z, int y, int x) const {
+        check(z, y, x);
+        return slab(z / _depth)[(z % _depth) * _plane + std::size_t(y) * _sizeX + x];
+    }
+
+    /**
+        Metodo slice: Ritorna in memoria la sotto-Matrice3D negli intervalli di coordinate
+                      z1..z2, y1..y2 e x1..x2, leggendo gli slab uno alla volta.
+
+        @param z1, z2, y1, y2, x1, x2 Intervalli di coordinate
+
+        @return Matrice3D con i valori negli intervalli
+
+        @throw Matrice3DInvalidParameters possibile eccezione di intervallo non valido
+        @throw Matrice3DOutOfRange possibile eccezione di intervallo fuori range
+    */
+    Matrice3D<T> slice(int z1, int z2, int y1, int y2, int x1, int x2) const {
+        if(z1 > z2 || y1 > y2 || x1 > x2)
+            throw Matrice3DInvalidParameters("ERRORE: Parametri forniti invalidi");
+        if(z1 < 0 || z2 >= _sizeZ || y1 < 0 || y2 >= _sizeY || x1 < 0 || x2 >= _sizeX)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+        Matrice3D<T> res(z2 - z1 + 1, y2 - y1 + 1, x2 - x1 + 1);
+        T *out = res.data();
+        for (int i = z1; i <= z2; i++) {
+            const T *plane = slab(i / _depth) + (i % _depth) * _plane;
+            for (int j = y1; j <= y2; j++) {
+                const T *row = plane + std::size_t(j) * _sizeX;
+                for (int k = x1; k <= x2; k++)
+                    *out++ = row[k];
+            }
+        }
+        return res;
+    }
+
+    /**
+        Metodo flush: attende il prefetch e riscrive sul file gli slab modificati
+
+        @throw Matrice3DError possibile eccezione di scrittura fallita
+    */
+    void flush() {
+        wait_prefetch();
+        for (std::size_t i = 0; i < _slots.size(); i++)
+            write_back(_slots[i]);
+        std::lock_guard<std::mutex> lock(_io);
+        _file.flush();
+    }
+
+    /**
+        Puntatore agli elementi dello slab s (piani s * depth() .. s * depth() + depth() - 1),
+        caricato se necessario. Usato da iteratori e trasform per lavorare a slab interi.
+        La versione costante e' in sola lettura; quella non costante segna lo slab come
+        modificato, quindi verra' riscritto sul file.
+
+        @param s indice dello slab
+
+        @return elementi dello slab, validi fino all'accesso a un altro slab
+    */
+    const T *slab(unsigned int s) const { return use(s).data; }
+
+    T *slab(unsigned int s) {
+        Slot &slot = use(s);
+        slot.dirty = true;
+        return slot.data;
+    }
+
+    /**
+        @return numero di slab
+    */
+    unsigned int slabs() const { return _slabs; }
+
+    /**
+        @return piani contenuti nello slab s (l'ultimo puo' essere piu' corto)
+    */
+    unsigned int slab_depth(unsigned int s) const {
+        return s + 1 < _slabs ? _depth : _sizeZ - s * _depth;
+    }
+
+    /**
+     @brief Forward iterator della Matrice3DStream
+
+            Scorre gli elementi nell'ordine della Matrice3D (x, poi y, poi z), uno slab
+            alla volta: a ogni cambio di slab parte il prefetch del successivo.
+    */
+    template <class V> class stream_iterator {
+        template <class> friend class stream_iterator;
+        typedef typename std::conditional<std::is_const<V>::value, const Matrice3DStream, Matrice3DStream>::type S;
+
+        S *_s; ///< matrice su cui si itera
+        std::size_t _i; ///< posizione lineare corrente
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef typename std::conditional<std::is_const<V>::value, const T&,
+                                          Matrice3DElementRef<Matrice3DStream> >::type reference;
+
+        stream_iterator() : _s(nullptr), _i(0) {}
+        stream_iterator(S *s, std::size_t i) : _s(s), _i(i) {}
+
+        // Conversione da iterator a const_iterator
+        template <class W, typename = typename std::enable_if<std::is_same<const W, V>::value>::type>
+        stream_iterator(const stream_iterator<W> &other) : _s(other._s), _i(other._i) {}
+
+        // In scrittura un riferimento che segna lo slab solo se assegnato
+        reference operator*() const {
+            if constexpr (std::is_const<V>::value)
+                return _s->load_element(_i);
+            else
+                return reference(_s, _i);
+        }
+        pointer operator->() const { return &_s->load_element(_i); }
+
+        stream_iterator& operator++() { ++_i; return *this; }
+        stream_iterator operator++(int) { stream_iterator tmp(*this); ++_i; return tmp; }
+
+        bool operator==(const stream_iterator &other) const { return _i == other._i; }
+        bool operator!=(const stream_iterator &other) const { return _i != other._i; }
+    };
+
+    typedef stream_iterator<T> iterator;
+    typedef stream_iterator<const T> const_iterator;
+
+    // Metodi membro begin() e end() per l'iterazione
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+    private:
+
+    std::size_t slab_elements() const { return std::size_t(_depth) * _plane; }
+
+    // Slot dello slab s, caricato se necessario, aggiornando l'LRU
+    Slot &use(unsigned int s) const {
+        if ((long)s != _last) {
+            _lastSlot = acquire(s);
+            _last = s;
+        }
+        Slot &slot = _slots[_lastSlot];
+        slot.stamp = ++_clock;
+        return slot;
+    }
+
+    // Elemento in posizione lineare i: in lettura (lo slab resta pulito) o in scrittura
+    const T& load_element(std::size_t i) const {
+        return slab((unsigned int)(i / slab_elements()))[i % slab_elements()];
+    }
+    T& store_element(std::size_t i) {
+        return slab((unsigned int)(i / slab_elements()))[i % slab_elements()];
+    }
+
+    void open(const std::string &file, const Matrice3DFileHeader &h, std::size_t budget, unsigned int depth) {
+        _dataOffset = h.dataOffset;
+        _sizeZ = (unsigned int)h.sizeZ;
+        _sizeY = (unsigned int)h.sizeY;
+        _sizeX = (unsigned int)h.sizeX;
+        _plane = std::size_t(_sizeY) * _sizeX;
+        _budget = budget;
+        std::size_t planeBytes = _plane * sizeof(T);
+        if (depth == 0)
+            depth = budget / (4 * planeBytes) > 0 ? (unsigned int)(budget / (4 * planeBytes)) : 1;
+        _depth = depth < _sizeZ ? depth : _sizeZ;
+        _slabs = (_sizeZ + _depth - 1) / _depth;
+        std::size_t count = budget / (slab_elements() * sizeof(T));
+        if (count < (_slabs > 1 ? 2u : 1u))
+            throw Matrice3DInvalidParameters("ERRORE: Budget insufficiente per due slab");
+        if (count > _slabs)
+            count = _slabs;
+        Slot empty = { nullptr, -1, false, 0 };
+        _slots.assign(count, empty);
+        _slotOf.assign(_slabs, -1);
+        _clock = 0;
+        _last = -1;
+        _lastSlot = -1;
+        _pending = -1;
+        _loads = 0;
+        _writes = 0;
+        _file.open(file.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        if (!_file)
+            throw Matrice3DError("ERRORE: Impossibile aprire il file");
+    }
+
+    void check(int z, int y, int x) const {
+        if(z >= _sizeZ || y >= _sizeY || x >= _sizeX || z < 0 || y < 0 || x < 0)
+            throw Matrice3DOutOfRange("ERRORE: Coordinate fuori dai limiti della matrice");
+    }
+
+    /**
+        Ritorna lo slot dello slab s, caricandolo se necessario. Se l'accesso e' passato
+        dallo slab s - 1 allo slab s avvia il prefetch di s + 1.
+    */
+    int acquire(unsigned int s) const {
+        int slot = _slotOf[s];
+        if (slot >= 0 && slot == _pending)
+            wait_prefetch();
+        if (slot < 0) {
+            // Non posso usare lo slot in lettura in background: prima lo completo
+            wait_prefetch();
+            slot = victim(-1);
+            read(_slots[slot], s);
+        }
+        // Scansione sequenziale: leggo in anticipo lo slab successivo
+        if (_slots.size() > 1 && (long)s == _last + 1 && s + 1 < _slabs && _slotOf[s + 1] < 0 && _pending < 0) {
+            int next = victim(slot);
+            Slot &n = _slots[next];
+            evict(n);
+            n.index = s + 1;
+            n.stamp = _clock;
+            _slotOf[s + 1] = next;
+            _pending = next;
+            _loads++;
+            _prefetch = std::async(std::launch::async, [this, next]() { load(_slots[next]); });
+        }
+        return slot;
+    }
+
+    /**
+        Slot da liberare: uno vuoto, altrimenti quello usato meno di recente (escluso keep)
+    */
+    int victim(int keep) const {
+        int best = -1;
+        for (int i = 0; i < (int)_slots.size(); i++) {
+            if (i == keep || i == _pending)
+                continue;
+            if (_slots[i].index < 0)
+                return i;
+            if (best < 0 || _slots[i].stamp < _slots[best].stamp)
+                best = i;
+        }
+        return best;
+    }
+
+    // Riscrive lo slot se modificato e lo svuota
+    void evict(Slot &slot) const {
+        write_back(slot);
+        if (slot.index >= 0)
+            _slotOf[slot.index] = -1;
+        slot.index = -1;
+        if (slot.data == nullptr)
+            slot.data = alignedAllocator<T>().allocate(slab_elements());
+    }
+
+    // Carica lo slab s nello slot
+    void read(Slot &slot, unsigned int s) const {
+        evict(slot);
+        slot.index = s;
+        try {
+            load(slot);
+        }
+        catch (...) {
+            slot.index = -1;
+            throw;
+        }
+        _slotOf[s] = (int)(&slot - &_slots[0]);
+        _loads++;
+    }
+
+    // Legge dal file lo slab slot.index (eseguito anche dal thread di prefetch)
+    void load(Slot &slot) const {
+        std::lock_guard<std::mutex> lock(_io);
+        std::size_t n = slab_depth((unsigned int)slot.index) * _plane;
+        _file.seekg(std::streamoff(_dataOffset + slot.index * slab_elements() * sizeof(T)));
+        _file.read(reinterpret_cast<char *>(slot.data), std::streamsize(n * sizeof(T)));
+        if (!_file) {
+            _file.clear();
+            throw Matrice3DError("ERRORE: Lettura del file fallita");
+        }
+    }
+
+    void write_back(Slot &slot) const {
+        if (slot.index < 0 || !slot.dirty)
+            return;
+        std::lock_guard<std::mutex> lock(_io);
+        std::size_t n = slab_depth((unsigned int)slot.index) * _plane;
+        _file.seekp(std::streamoff(_dataOffset + slot.index * slab_elements() * sizeof(T)));
+        _file.write(reinterpret_cast<const char *>(slot.data), std::streamsize(n * sizeof(T)));
+        if (!_file) {
+            _file.clear();
+            throw Matrice3DError("ERRORE: Scrittura del file fallita");
+        }
+        slot.dirty = false;
+        _writes++;
+    }
+
+    // Attende la lettura in background; se e' fallita libera lo slot e rilancia
+    void wait_prefetch() const {
+        if (_pending < 0)
+            return;
+        int slot = _pending;
+        _pending = -1;
+        try {
+            _prefetch.get();
+        }
+        catch (...) {
+            _slotOf[_slots[slot].index] = -1;
+            _slots[slot].index = -1;
+            throw;
+        }
+    }
+};
+
+/**
+    Metodo GLOBALE transform su una Matrice3DStream: B(i,j,k) = F(A(i,j,k)), con B
+    Matrice3DStream delle stesse dimensioni (es. creata su un nuovo file). Le due
+    matrici vengono percorse piano per piano in ordine z, quindi entrambe sfruttano il
+    prefetch e la memoria usata resta entro i budget delle due cache.
+
+    @param A Matrice3DStream su tipi T, F funtore generico
+    @param B Matrice3DStream su tipi Q in cui scrivere il risultato
+
+    @throw Matrice3DInvalidParameters possibile eccezione di dimensioni diverse
+*/
+template <typename Q, typename T, typename F>
+void trasform(const Matrice3DStream<T> &A, F funz, Matrice3DStream<Q> &B) {
+    if (A.sizeZ() != B.sizeZ() || A.sizeY() != B.sizeY() || A.sizeX() != B.sizeX())
+        throw Matrice3DInvalidParameters("ERRORE: Dimensioni delle matrici diverse");
+    std::size_t plane = std::size_t(A.sizeY()) * A.sizeX();
+    for (unsigned int z = 0; z < A.sizeZ(); z++) {
+        const T *in = A.slab(z / A.depth()) + (z % A.depth()) * plane;
+        Q *out = B.slab(z / B.depth()) + (z % B.depth()) * plane;
+        if constexpr (m3dHasApply<F, Q, T>::value)
+            funz.apply(out, in, plane);
+        else
+            for (std::size_t i = 0; i < plane; i++)
+                out[i] = static_cast<Q>(funz(in[i]));
+    }
+}
+
+#endif